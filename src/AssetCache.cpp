@@ -0,0 +1,158 @@
+#include "AssetCache.h"
+#include "ObjFileReader.h"
+#include "utils/MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+AssetCache& AssetCache::instance()
+{
+    static AssetCache cache;
+    return cache;
+}
+
+AssetCache::MeshHandle AssetCache::loadMesh(const std::string& filename, float scaleFactor)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const Key pathKey = { filename, scaleFactor };
+    auto byPath = mByPath.find(pathKey);
+    if (byPath != mByPath.end())
+    {
+        if (MeshHandle mesh = byPath->second.lock())
+        {
+            return mesh;
+        }
+    }
+    if (mFailed.count(pathKey))
+    {
+        return MeshHandle();
+    }
+
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        mFailed[pathKey] = true;
+        return MeshHandle();
+    }
+
+    // the same file under another name
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) hashBytes(file.data(), file.size()));
+    const Key contentKey = { hex, scaleFactor };
+    auto byContent = mByContent.find(contentKey);
+    if (byContent != mByContent.end())
+    {
+        MeshHandle mesh = byContent->second.mesh.lock();
+        if (mesh && sameContents(file.data(), file.size(), byContent->second.path))
+        {
+            mByPath[pathKey] = mesh;
+            return mesh;
+        }
+    }
+    file.close();
+
+    prune();
+    ObjFileReader reader;
+    mLoadCount++;
+    if (!reader.loadFile(filename, scaleFactor))
+    {
+        mFailed[pathKey] = true;
+        return MeshHandle();
+    }
+    MeshHandle mesh = std::make_shared<const Mesh>(reader.getObjects());
+    mByPath[pathKey] = mesh;
+    mByContent[contentKey] = { mesh, filename };
+    return mesh;
+}
+
+AssetCache::VehicleMeshHandle AssetCache::loadVehicleMesh(const std::string& filename, float scaleFactor)
+{
+    MeshHandle mesh = loadMesh(filename, scaleFactor);
+    if (!mesh)
+    {
+        return VehicleMeshHandle();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto found = mVehicleMeshes.find(mesh.get());
+    if (found == mVehicleMeshes.end() || found->second.expired())
+    {
+        prune();
+    }
+    std::weak_ptr<const VehicleMesh>& entry = mVehicleMeshes[mesh.get()];
+    VehicleMeshHandle vehicleMesh = entry.lock();
+    if (!vehicleMesh)
+    {
+        // the deleter keeps the mesh in use as long as the vehicle mesh, so that no other mesh gets its address
+        vehicleMesh = VehicleMeshHandle(new VehicleMesh(*mesh), [mesh](const VehicleMesh* built) mutable
+        {
+            delete built;
+            mesh.reset();
+        });
+        entry = vehicleMesh;
+    }
+    return vehicleMesh;
+}
+
+std::size_t AssetCache::meshCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::size_t count = 0;
+    for (const auto& entry : mByContent)
+    {
+        count += entry.second.mesh.expired() ? 0 : 1;
+    }
+    return count;
+}
+
+std::size_t AssetCache::loadCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLoadCount;
+}
+
+void AssetCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mByPath.clear();
+    mByContent.clear();
+    mFailed.clear();
+    mVehicleMeshes.clear();
+    mLoadCount = 0;
+}
+
+void AssetCache::prune()
+{
+    for (auto it = mByPath.begin(); it != mByPath.end();)
+    {
+        it = it->second.expired() ? mByPath.erase(it) : std::next(it);
+    }
+    for (auto it = mByContent.begin(); it != mByContent.end();)
+    {
+        it = it->second.mesh.expired() ? mByContent.erase(it) : std::next(it);
+    }
+    for (auto it = mVehicleMeshes.begin(); it != mVehicleMeshes.end();)
+    {
+        it = it->second.expired() ? mVehicleMeshes.erase(it) : std::next(it);
+    }
+}
+
+std::uint64_t AssetCache::hashBytes(const char* data, std::size_t size)
+{
+    // FNV-1a, 64 bit
+    std::uint64_t hash = 14695981039346656037ull;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool AssetCache::sameContents(const char* data, std::size_t size, const std::string& filename)
+{
+    MappedFile file;
+    return file.open(filename) && file.size() == size && std::memcmp(file.data(), data, size) == 0;
+}
@@ -0,0 +1,83 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include "VertexObject.h"
+#include "VehicleMesh.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ @brief Loads every mesh once and shares it. loadMesh returns a handle to an
+        immutable mesh that is reference-counted: all vehicles using the same
+        model hold the same one, and it is freed with its last handle. Meshes
+        are found by path, and a file at another path with the same contents
+        and scale is not parsed again either: files with the same hash are
+        compared byte by byte before the mesh is shared. Paths that failed to
+        load are not retried until clear(). loadVehicleMesh shares the
+        triangulated GPU mesh of a model in the same way.
+        The cache may be used from several threads.
+ */
+class AssetCache
+{
+public:
+    // the named parts of a mesh, as read by ObjFileReader
+    typedef std::map<std::string, VertexObject> Mesh;
+    typedef std::shared_ptr<const Mesh> MeshHandle;
+    typedef std::shared_ptr<const VehicleMesh> VehicleMeshHandle;
+
+    // the cache the vehicles load their models from
+    static AssetCache& instance();
+
+    /* @brief the mesh of an OBJ file with all vertices multiplied by
+     * scaleFactor, or an empty handle if it cannot be read.
+     */
+    MeshHandle loadMesh(const std::string& filename, float scaleFactor = 1.0f);
+    /* @brief the mesh of loadMesh triangulated for drawing, built once per
+     * mesh. It keeps the mesh it was built from in use.
+     */
+    VehicleMeshHandle loadVehicleMesh(const std::string& filename, float scaleFactor = 1.0f);
+
+    // the number of meshes that are in use
+    std::size_t meshCount() const;
+    // the number of times a file was parsed
+    std::size_t loadCount() const;
+
+    void clear();
+
+private:
+    struct Key
+    {
+        std::string path; // or the content hash as hex digits
+        float scaleFactor;
+
+        bool operator<(const Key& other) const
+        {
+            return path < other.path || (path == other.path && scaleFactor < other.scaleFactor);
+        }
+    };
+
+    struct ContentEntry
+    {
+        std::weak_ptr<const Mesh> mesh;
+        std::string path; // the file it was parsed from
+    };
+
+    static std::uint64_t hashBytes(const char* data, std::size_t size);
+    static bool sameContents(const char* data, std::size_t size, const std::string& filename);
+    // forget the meshes that were freed; with mMutex held
+    void prune();
+
+    mutable std::mutex mMutex;
+    std::map<Key, std::weak_ptr<const Mesh>> mByPath;
+    std::map<Key, ContentEntry> mByContent;
+    std::map<Key, bool> mFailed;
+    // by the mesh they were built from, which they keep in use
+    std::map<const Mesh*, std::weak_ptr<const VehicleMesh>> mVehicleMeshes;
+    std::size_t mLoadCount = 0;
+};
+
+#endif
@@ -0,0 +1,322 @@
+#include "Clipmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+const int Clipmap::GridSize;
+const int Clipmap::HoleCells;
+
+Clipmap::Clipmap(int levels) :
+                mLevels(levels)
+{
+}
+
+Clipmap::~Clipmap()
+{
+    release();
+}
+
+void Clipmap::reset(const HeightSource* source)
+{
+    release();
+    mSource = source;
+    mUpdatedSamples = 0;
+    for (Level& level : mLevels)
+    {
+        level.valid = false;
+        level.heights.assign(GridSize * GridSize, 0.0f);
+        level.vertices.assign(GridSize * GridSize, Vertex());
+        level.indices.clear();
+        level.dirtyRows.assign(GridSize, 0);
+        level.indicesDirty = true;
+    }
+}
+
+void Clipmap::release()
+{
+    for (Level& level : mLevels)
+    {
+        if (level.vertexBuffer != 0)
+        {
+            glDeleteBuffersARB(1, &level.vertexBuffer);
+            glDeleteBuffersARB(1, &level.indexBuffer);
+            level.vertexBuffer = 0;
+            level.indexBuffer = 0;
+        }
+    }
+}
+
+int Clipmap::wrap(int value)
+{
+    const int m = value % GridSize;
+    return m < 0 ? m + GridSize : m;
+}
+
+int Clipmap::slot(int x, int y)
+{
+    return wrap(x) * GridSize + wrap(y);
+}
+
+void Clipmap::update(glm::vec2 center)
+{
+    mUpdatedSamples = 0;
+    if (mSource == nullptr)
+    {
+        return;
+    }
+
+    const int count = mLevels.size();
+    for (int l = 0; l < count; ++l)
+    {
+        Level& level = mLevels[l];
+        const float cellSize = mSource->spacing() * (1 << l);
+
+        // center the level on the sample next to center; even origins keep
+        // its samples aligned with the ones of the next coarser level
+        int originX = (int) std::floor(center.x / cellSize) - HoleCells;
+        int originY = (int) std::floor(center.y / cellSize) - HoleCells;
+        originX -= originX & 1;
+        originY -= originY & 1;
+        if (level.valid && originX == level.originX && originY == level.originY)
+            continue;
+
+        const bool keep = level.valid && std::abs(originX - level.originX) < GridSize && std::abs(originY - level.originY) < GridSize;
+        const int oldX = level.originX;
+        const int oldY = level.originY;
+        level.originX = originX;
+        level.originY = originY;
+        level.valid = true;
+
+        // fetch what is new, the rest is still in the toroidal buffer
+        for (int x = originX; x < originX + GridSize; ++x)
+        {
+            for (int y = originY; y < originY + GridSize; ++y)
+            {
+                const bool old = keep && x >= oldX && x < oldX + GridSize && y >= oldY && y < oldY + GridSize;
+                if (!old)
+                {
+                    fetch(l, x, y);
+                }
+            }
+        }
+
+        // write the new vertices and the ones whose neighbours or border state changed
+        for (int x = originX; x < originX + GridSize; ++x)
+        {
+            for (int y = originY; y < originY + GridSize; ++y)
+            {
+                const bool old = keep && x >= oldX && x < oldX + GridSize && y >= oldY && y < oldY + GridSize;
+                const bool oldBorder = x == oldX || x == oldX + GridSize - 1 || y == oldY || y == oldY + GridSize - 1;
+                const bool border = x == originX || x == originX + GridSize - 1 || y == originY || y == originY + GridSize - 1;
+                if (!old || oldBorder || border)
+                {
+                    writeVertex(l, x, y);
+                }
+            }
+        }
+
+        // the level moved, and with it the hole of the next coarser one
+        level.indicesDirty = true;
+        if (l + 1 < count)
+        {
+            mLevels[l + 1].indicesDirty = true;
+        }
+    }
+
+    for (int l = 0; l < count; ++l)
+    {
+        if (mLevels[l].indicesDirty)
+        {
+            buildIndices(l);
+        }
+    }
+}
+
+void Clipmap::fetch(int l, int x, int y)
+{
+    const int step = 1 << l;
+    mLevels[l].heights[slot(x, y)] = mSource->height(x * step, y * step);
+    mUpdatedSamples++;
+}
+
+void Clipmap::writeVertex(int l, int x, int y)
+{
+    Level& level = mLevels[l];
+    const int step = 1 << l;
+    const float cellSize = mSource->spacing() * step;
+    auto h = [&](int sx, int sy)
+    {
+        return level.heights[slot(sx, sy)];
+    };
+
+    const int lastX = level.originX + GridSize - 1;
+    const int lastY = level.originY + GridSize - 1;
+    float height = h(x, y);
+    if (l + 1 < (int) mLevels.size())
+    {
+        // odd samples on the border lie on an edge of the next coarser level
+        if ((x == level.originX || x == lastX) && (y & 1))
+        {
+            height = (h(x, y - 1) + h(x, y + 1)) / 2.0f;
+        }
+        else if ((y == level.originY || y == lastY) && (x & 1))
+        {
+            height = (h(x - 1, y) + h(x + 1, y)) / 2.0f;
+        }
+    }
+
+    // central differences, one sided at the border
+    const int x0 = std::max(x - 1, level.originX);
+    const int x1 = std::min(x + 1, lastX);
+    const int y0 = std::max(y - 1, level.originY);
+    const int y1 = std::min(y + 1, lastY);
+    glm::vec3 normal((h(x0, y) - h(x1, y)) / (x1 - x0), (h(x, y0) - h(x, y1)) / (y1 - y0), cellSize);
+    normal = normal / std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+
+    Vertex& vertex = level.vertices[slot(x, y)];
+    vertex.position = glm::vec3(x * cellSize, y * cellSize, height);
+    vertex.normal = normal;
+    vertex.texCoord = glm::vec2(x * step, y * step);
+    level.dirtyRows[wrap(x)] = 1;
+}
+
+void Clipmap::buildIndices(int l)
+{
+    Level& level = mLevels[l];
+    level.indices.clear();
+
+    // the cells covered by the next finer level
+    int holeX = GridSize;
+    int holeY = GridSize;
+    if (l > 0)
+    {
+        holeX = mLevels[l - 1].originX / 2 - level.originX;
+        holeY = mLevels[l - 1].originY / 2 - level.originY;
+    }
+
+    for (int i = 0; i < GridSize - 1; ++i)
+    {
+        for (int j = 0; j < GridSize - 1; ++j)
+        {
+            if (i >= holeX && i < holeX + HoleCells && j >= holeY && j < holeY + HoleCells)
+                continue;
+            const int x = level.originX + i;
+            const int y = level.originY + j;
+            const GLuint v00 = slot(x, y);
+            const GLuint v01 = slot(x, y + 1);
+            const GLuint v10 = slot(x + 1, y);
+            const GLuint v11 = slot(x + 1, y + 1);
+            // upper left half, then lower right half, as in LandscapeMesh
+            level.indices.push_back(v00);
+            level.indices.push_back(v11);
+            level.indices.push_back(v01);
+            level.indices.push_back(v00);
+            level.indices.push_back(v10);
+            level.indices.push_back(v11);
+        }
+    }
+    level.indicesDirty = true;
+}
+
+void Clipmap::draw()
+{
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    for (Level& level : mLevels)
+    {
+        if (!level.valid)
+            continue;
+
+        if (level.vertexBuffer == 0)
+        {
+            glGenBuffersARB(1, &level.vertexBuffer);
+            glGenBuffersARB(1, &level.indexBuffer);
+            glBindBufferARB(GL_ARRAY_BUFFER_ARB, level.vertexBuffer);
+            glBufferDataARB(GL_ARRAY_BUFFER_ARB, sizeof(Vertex) * level.vertices.size(), &level.vertices[0], GL_DYNAMIC_DRAW_ARB);
+            std::fill(level.dirtyRows.begin(), level.dirtyRows.end(), 0);
+            level.indicesDirty = true;
+        }
+        else
+        {
+            // upload runs of changed rows
+            glBindBufferARB(GL_ARRAY_BUFFER_ARB, level.vertexBuffer);
+            for (int row = 0; row < GridSize; ++row)
+            {
+                if (!level.dirtyRows[row])
+                    continue;
+                int end = row;
+                while (end < GridSize && level.dirtyRows[end])
+                {
+                    level.dirtyRows[end++] = 0;
+                }
+                glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, sizeof(Vertex) * row * GridSize, sizeof(Vertex) * (end - row) * GridSize, &level.vertices[row * GridSize]);
+                row = end;
+            }
+        }
+
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, level.indexBuffer);
+        if (level.indicesDirty)
+        {
+            glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(GLuint) * level.indices.size(), &level.indices[0], GL_DYNAMIC_DRAW_ARB);
+            level.indicesDirty = false;
+        }
+
+        glVertexPointer(3, GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, position)));
+        glNormalPointer(GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, normal)));
+        glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, texCoord)));
+        glDrawRangeElements(GL_TRIANGLES, 0, GridSize * GridSize - 1, level.indices.size(), GL_UNSIGNED_INT, BUFFER_OFFSET(0));
+    }
+
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+int Clipmap::levels() const
+{
+    return mLevels.size();
+}
+
+int Clipmap::originX(int level) const
+{
+    return mLevels[level].originX;
+}
+
+int Clipmap::originY(int level) const
+{
+    return mLevels[level].originY;
+}
+
+const Clipmap::Vertex& Clipmap::vertex(int level, int i, int j) const
+{
+    const Level& l = mLevels[level];
+    return l.vertices[slot(l.originX + i, l.originY + j)];
+}
+
+const std::vector<GLuint>& Clipmap::indices(int level) const
+{
+    return mLevels[level].indices;
+}
+
+size_t Clipmap::updatedSamples() const
+{
+    return mUpdatedSamples;
+}
+
+size_t Clipmap::triangles() const
+{
+    size_t count = 0;
+    for (const Level& level : mLevels)
+    {
+        count += level.indices.size() / 3;
+    }
+    return count;
+}
@@ -0,0 +1,90 @@
+#ifndef CLIPMAP_H
+#define CLIPMAP_H
+
+#include "HeightSource.h"
+
+#include <GL/glut.h>
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include <vector>
+
+/**
+ @brief Geometry clipmap: nested square grids of GridSize x GridSize samples
+        around a center point. Level l samples every 2^l-th height of the
+        source, so each level covers twice the area of the one inside it and
+        only draws the ring around that hole. The samples of a level are kept
+        in a toroidal buffer: when the center moves, only the rows and columns
+        that come into view are fetched and written, so the cost per frame
+        depends on the movement, not on the size of the map.
+        Odd vertices on the outer border of a level are set to the average of
+        their even neighbours, which lie on the edges of the next coarser
+        level; that way the levels meet without cracks.
+ */
+class Clipmap
+{
+public:
+    static const int GridSize = 65; // samples per side, 2^n + 1
+    static const int HoleCells = (GridSize - 1) / 2;
+
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+
+    explicit Clipmap(int levels = 6);
+    ~Clipmap();
+    Clipmap(const Clipmap&) = delete;
+    Clipmap& operator=(const Clipmap&) = delete;
+
+    /* @brief use a new source. Uploaded buffers are deleted, so a GL context
+     * has to be current if anything was drawn before.
+     */
+    void reset(const HeightSource* source);
+
+    // move the levels to center (in world units) and fetch the exposed samples
+    void update(glm::vec2 center);
+    // upload what update changed and draw all rings
+    void draw();
+
+    int levels() const;
+    // the first sample of a level, in samples of that level
+    int originX(int level) const;
+    int originY(int level) const;
+    // the vertex of the level at (i, j) relative to its origin
+    const Vertex& vertex(int level, int i, int j) const;
+    const std::vector<GLuint>& indices(int level) const;
+
+    // the samples fetched by the last update
+    size_t updatedSamples() const;
+    size_t triangles() const;
+
+private:
+    struct Level
+    {
+        int originX = 0;
+        int originY = 0;
+        bool valid = false;
+        std::vector<float> heights;  // toroidal, like vertices
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+        std::vector<char> dirtyRows; // rows of vertices to upload
+        bool indicesDirty = true;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+    };
+
+    static int wrap(int value);
+    static int slot(int x, int y);
+    void fetch(int level, int x, int y);
+    void writeVertex(int level, int x, int y);
+    void buildIndices(int level);
+    void release();
+
+    const HeightSource* mSource = nullptr;
+    std::vector<Level> mLevels;
+    size_t mUpdatedSamples = 0;
+};
+
+#endif
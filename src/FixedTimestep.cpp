@@ -0,0 +1,44 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(unsigned long tickUs, unsigned int maxTicks) :
+                mTickUs(tickUs),
+                mMaxTicks(maxTicks)
+{
+}
+
+unsigned int FixedTimestep::update(unsigned long nowUs)
+{
+    if (!mStarted)
+    {
+        mStarted = true;
+        mLastUs = nowUs;
+        return 0;
+    }
+
+    mAccumulatedUs += nowUs - mLastUs;
+    mLastUs = nowUs;
+
+    unsigned long ticks = mAccumulatedUs / mTickUs;
+    mAccumulatedUs -= ticks * mTickUs;
+    if (ticks > mMaxTicks)
+    {
+        mDroppedTicks += ticks - mMaxTicks;
+        ticks = mMaxTicks;
+    }
+    return ticks;
+}
+
+float FixedTimestep::alpha() const
+{
+    return mAccumulatedUs / (float) mTickUs;
+}
+
+unsigned long FixedTimestep::tickUs() const
+{
+    return mTickUs;
+}
+
+unsigned long FixedTimestep::droppedTicks() const
+{
+    return mDroppedTicks;
+}
@@ -0,0 +1,43 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+/**
+ @brief Decides how many simulation ticks of a fixed length are due, so that
+        the simulation advances with the wall clock independently of how
+        often and how long frames are drawn. update() adds the time since
+        its last call to an accumulator and takes whole ticks out of it; the
+        remainder is the progress into the next tick, which rendering uses to
+        interpolate between the last two simulated states.
+        If more than maxTicks are due at once, e.g. after a stalled frame or
+        on a machine too slow to keep up, the backlog beyond them is dropped
+        instead of being caught up, and the simulation runs slower than the
+        wall clock for a moment.
+ */
+class FixedTimestep
+{
+public:
+    FixedTimestep(unsigned long tickUs, unsigned int maxTicks);
+
+    /* @brief the number of ticks to run for the time nowUs (from
+     * Utils::clockTimeUs). The first call only starts the clock.
+     */
+    unsigned int update(unsigned long nowUs);
+
+    // progress into the next tick in [0, 1), for interpolation
+    float alpha() const;
+
+    unsigned long tickUs() const;
+    // ticks that were dropped because more than maxTicks were due
+    unsigned long droppedTicks() const;
+
+private:
+    const unsigned long mTickUs;
+    const unsigned int mMaxTicks;
+
+    bool mStarted = false;
+    unsigned long mLastUs = 0;
+    unsigned long mAccumulatedUs = 0;
+    unsigned long mDroppedTicks = 0;
+};
+
+#endif
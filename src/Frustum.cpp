@@ -0,0 +1,68 @@
+#include "Frustum.h"
+
+#include <GL/glut.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+#include <cstring>
+
+Frustum::Frustum(const glm::mat4& projectionModelview)
+{
+    // Gribb/Hartmann: each plane is the sum or difference of the last row and one other row
+    const glm::mat4& m = projectionModelview;
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+    mPlanes[0] = rows[3] + rows[0]; // left
+    mPlanes[1] = rows[3] - rows[0]; // right
+    mPlanes[2] = rows[3] + rows[1]; // bottom
+    mPlanes[3] = rows[3] - rows[1]; // top
+    mPlanes[4] = rows[3] + rows[2]; // near
+    mPlanes[5] = rows[3] - rows[2]; // far
+    for (glm::vec4& plane : mPlanes)
+    {
+        plane = plane / std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    }
+}
+
+Frustum Frustum::fromGL()
+{
+    glm::mat4 projection;
+    glm::mat4 modelview;
+    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projection));
+    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(modelview));
+    return Frustum(projection * modelview);
+}
+
+Frustum::Visibility Frustum::classify(const glm::vec3& min, const glm::vec3& max) const
+{
+    Visibility result = Visibility::INSIDE;
+    for (const glm::vec4& plane : mPlanes)
+    {
+        // the corners of the box farthest along and against the plane normal
+        const glm::vec3 positive(plane.x >= 0 ? max.x : min.x, plane.y >= 0 ? max.y : min.y, plane.z >= 0 ? max.z : min.z);
+        const glm::vec3 negative(plane.x >= 0 ? min.x : max.x, plane.y >= 0 ? min.y : max.y, plane.z >= 0 ? min.z : max.z);
+        if (glm::dot(glm::vec4(positive, 1.0f), plane) < 0)
+        {
+            return Visibility::OUTSIDE;
+        }
+        if (glm::dot(glm::vec4(negative, 1.0f), plane) < 0)
+        {
+            result = Visibility::INTERSECTING;
+        }
+    }
+    return result;
+}
+
+bool Frustum::contains(const glm::vec3& point) const
+{
+    for (const glm::vec4& plane : mPlanes)
+    {
+        if (glm::dot(glm::vec4(point, 1.0f), plane) < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <array>
+
+/**
+ @brief The six clip planes of a view frustum. Points p with
+        dot(plane, vec4(p, 1)) >= 0 for all planes are inside. The planes are
+        given in the space of the matrix they are extracted from, i.e. the
+        model space of the object when the modelview matrix includes its
+        transformation.
+ */
+class Frustum
+{
+public:
+    enum class Visibility
+    {
+        OUTSIDE,
+        INTERSECTING,
+        INSIDE
+    };
+
+    Frustum() = default;
+    // from projection * modelview
+    explicit Frustum(const glm::mat4& projectionModelview);
+
+    // from the current GL_PROJECTION_MATRIX and GL_MODELVIEW_MATRIX
+    static Frustum fromGL();
+
+    Visibility classify(const glm::vec3& min, const glm::vec3& max) const;
+    bool contains(const glm::vec3& point) const;
+
+private:
+    std::array<glm::vec4, 6> mPlanes;
+};
+
+#endif
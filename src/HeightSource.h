@@ -0,0 +1,62 @@
+#ifndef HEIGHTSOURCE_H
+#define HEIGHTSOURCE_H
+
+#include "Heightfield.h"
+
+#include <algorithm>
+
+/**
+ @brief Read access to a regular grid of heights, independent of where the
+        samples are kept. Renderers that only look at a part of the grid at a
+        time, like the Clipmap, fetch their samples through it.
+ */
+class HeightSource
+{
+public:
+    virtual ~HeightSource() = default;
+
+    virtual int sizeX() const = 0;
+    virtual int sizeY() const = 0;
+    // distance between neighbouring samples in world units
+    virtual float spacing() const = 0;
+    // the sample at (x, y); coordinates outside of the grid are clamped
+    virtual float height(int x, int y) const = 0;
+};
+
+/* @brief a HeightSource for a heightfield in memory */
+class HeightfieldSource : public HeightSource
+{
+public:
+    HeightfieldSource(const Heightfield<float>& heights, float spacing) :
+                    mHeights(&heights), mSpacing(spacing)
+    {
+    }
+
+    int sizeX() const override
+    {
+        return mHeights->sizeX();
+    }
+
+    int sizeY() const override
+    {
+        return mHeights->sizeY();
+    }
+
+    float spacing() const override
+    {
+        return mSpacing;
+    }
+
+    float height(int x, int y) const override
+    {
+        x = std::min(std::max(x, 0), mHeights->sizeX() - 1);
+        y = std::min(std::max(y, 0), mHeights->sizeY() - 1);
+        return (*mHeights)(x, y);
+    }
+
+private:
+    const Heightfield<float>* mHeights;
+    float mSpacing;
+};
+
+#endif
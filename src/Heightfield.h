@@ -0,0 +1,148 @@
+#ifndef HEIGHTFIELD_H
+#define HEIGHTFIELD_H
+
+#include "utils/AlignedAllocator.h"
+
+#include <vector>
+#include <cstddef>
+
+/**
+ @brief A regular grid of height samples in one contiguous, row-major block.
+        The first index (x) selects the row, the second (y) the sample in the
+        row. Rows are padded so that each of them starts on a cache line.
+        The samples are owned by the heightfield, unless it was attached to
+        a block that is kept elsewhere, e.g. in a mapped file.
+ */
+template<typename T = float>
+class Heightfield
+{
+public:
+    static const std::size_t Alignment = 64;
+
+    Heightfield() = default;
+    Heightfield(int sizeX, int sizeY, T value = T())
+    {
+        resize(sizeX, sizeY, value);
+    }
+    ~Heightfield() = default;
+
+    Heightfield(const Heightfield& other) :
+                    mSizeX(other.mSizeX), mSizeY(other.mSizeY), mStride(other.mStride), mSamples(other.mSamples)
+    {
+        mData = other.isAttached() ? other.mData : mSamples.data();
+    }
+
+    Heightfield& operator=(const Heightfield& other)
+    {
+        mSizeX = other.mSizeX;
+        mSizeY = other.mSizeY;
+        mStride = other.mStride;
+        mSamples = other.mSamples;
+        mData = other.isAttached() ? other.mData : mSamples.data();
+        return *this;
+    }
+
+    void resize(int sizeX, int sizeY, T value = T())
+    {
+        const std::size_t samplesPerLine = Alignment / sizeof(T);
+        mSizeX = sizeX;
+        mSizeY = sizeY;
+        mStride = (sizeY + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+        mSamples.assign(mStride * sizeX, value);
+        mData = mSamples.data();
+    }
+
+    /* @brief use sizeX rows of stride samples at data instead of an own
+     * block. The memory has to outlive the heightfield or the next resize,
+     * attach or clear.
+     */
+    void attach(T* data, int sizeX, int sizeY, std::size_t stride)
+    {
+        mSamples.clear();
+        mSamples.shrink_to_fit();
+        mSizeX = sizeX;
+        mSizeY = sizeY;
+        mStride = stride;
+        mData = data;
+    }
+
+    bool isAttached() const
+    {
+        return mData != nullptr && mSamples.empty();
+    }
+
+    void clear()
+    {
+        mSizeX = 0;
+        mSizeY = 0;
+        mStride = 0;
+        mSamples.clear();
+        mData = nullptr;
+    }
+
+    bool empty() const
+    {
+        return mSizeX == 0 || mSizeY == 0;
+    }
+
+    int sizeX() const
+    {
+        return mSizeX;
+    }
+
+    int sizeY() const
+    {
+        return mSizeY;
+    }
+
+    // distance in samples between (x, y) and (x + 1, y)
+    std::size_t stride() const
+    {
+        return mStride;
+    }
+
+    T& operator()(int x, int y)
+    {
+        return mData[x * mStride + y];
+    }
+
+    const T& operator()(int x, int y) const
+    {
+        return mData[x * mStride + y];
+    }
+
+    T* row(int x)
+    {
+        return &mData[x * mStride];
+    }
+
+    const T* row(int x) const
+    {
+        return &mData[x * mStride];
+    }
+
+    T* data()
+    {
+        return mData;
+    }
+
+    const T* data() const
+    {
+        return mData;
+    }
+
+    // memory occupied by the samples, including row padding
+    std::size_t byteSize() const
+    {
+        return mStride * mSizeX * sizeof(T);
+    }
+
+private:
+    int mSizeX = 0;
+    int mSizeY = 0;
+    std::size_t mStride = 0;
+    std::vector<T, AlignedAllocator<T, Alignment>> mSamples;
+    T* mData = nullptr; // mSamples.data() or attached memory
+};
+
+#endif
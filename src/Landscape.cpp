@@ -1,25 +1,333 @@
 #include "Landscape.h"
 
 #include "Utils.h"
+#include "utils/CpuFeatures.h"
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
 #include <glm/gtc/type_ptr.hpp>
+#include <cassert>
 
 #define DEBUG 0
 
-Landscape::Landscape()
+const char* const Landscape::Heightmap = "images/Terrain/terrain01_1081x1081.jpeg";
+const char* const Landscape::BakedHeightmap = "images/Terrain/terrain01_1081x1081.bake";
+
+Landscape::Landscape() :
+                mClipmapSource(mSupportPoints, mScale)
 {
 }
 
 void Landscape::generate(Type type)
 {
     mType = type;
+    mPrefetcher.reset();
+    mTiled.close();
     generateSupportPoints();
-    interpolateTriangles();
+    mBaked.close();
+    mPlaneTable = nullptr;
+    if (mUsePlaneTable)
+    {
+        buildPlaneTable();
+    }
+    mTiles.reset(&mSupportPoints, mScale);
+    mClipmapSource = HeightfieldSource(mSupportPoints, mScale);
+    mClipmap.reset(&mClipmapSource);
+}
+
+bool Landscape::openTiled(const std::string& filename, std::size_t budgetBytes)
+{
+    mPrefetcher.reset();
+    if (!mTiled.open(filename, budgetBytes))
+    {
+        return false;
+    }
+    mSupportPoints.clear();
+    mBaked.close();
+    mPlanes.clear();
+    mPlaneTable = nullptr;
+    mTiles.reset(&mSupportPoints, mScale);
+    mClipmap.reset(&mTiled);
+    mPrefetcher = makeAligned<TilePrefetcher>(mTiled);
+    return true;
+}
+
+bool Landscape::isTiled() const
+{
+    return mTiled.isOpen();
+}
+
+void Landscape::prefetch(const glm::vec3& position, double velocity, float yaw)
+{
+    if (mPrefetcher)
+    {
+        mPrefetcher->update(position, velocity, yaw);
+    }
+}
+
+TilePrefetcher::Stats Landscape::prefetchStats() const
+{
+    return mPrefetcher ? mPrefetcher->stats() : TilePrefetcher::Stats();
+}
+
+namespace
+{
+    /* Layout of a baked landscape: the header, then 64 byte aligned sections
+     * with the heights (rows padded like Heightfield), the plane table, a
+     * directory entry per render tile and the vertices and indices of the
+     * tiles. Sizes of the stored structs are part of the header, so that a
+     * build with a different layout refuses the file.
+     */
+    struct BakeHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t planeSize;
+        std::uint32_t vertexSize;
+        std::int32_t sizeX;
+        std::int32_t sizeY;
+        std::uint64_t stride;
+        double scale;
+        std::int32_t tilesX;
+        std::int32_t tilesY;
+        std::uint64_t heightsOffset;
+        std::uint64_t planesOffset;
+        std::uint64_t tilesOffset;
+    };
+
+    struct BakeTileEntry
+    {
+        std::uint64_t vertexOffset;
+        std::uint64_t indexOffset;
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+    };
+
+    const std::uint32_t BakeMagic = 0x4b425254; // "TRBK"
+    const std::uint32_t BakeVersion = 1;
+
+    std::uint64_t bakeAlign(std::uint64_t offset)
+    {
+        return (offset + 63) / 64 * 64;
+    }
+
+    // pad the stream up to the next aligned offset and return it
+    std::uint64_t bakePad(std::ofstream& ofs)
+    {
+        const std::uint64_t offset = ofs.tellp();
+        const std::uint64_t aligned = bakeAlign(offset);
+        for (std::uint64_t i = offset; i < aligned; ++i)
+        {
+            ofs.put(0);
+        }
+        return aligned;
+    }
+}
+
+bool Landscape::bake(const std::string& filename)
+{
+    if (mSupportPoints.empty())
+    {
+        std::cerr << "Nothing to bake" << std::endl;
+        return false;
+    }
+
+    std::ofstream ofs(filename, std::ofstream::binary | std::ofstream::trunc);
+    if (ofs.fail())
+    {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    const bool hadPlaneTable = mPlaneTable != nullptr;
+    if (!hadPlaneTable)
+    {
+        buildPlaneTable();
+    }
+    const LandscapeMesh mesh = get();
+
+    BakeHeader header = BakeHeader();
+    header.magic = BakeMagic;
+    header.version = BakeVersion;
+    header.planeSize = sizeof(Plane);
+    header.vertexSize = sizeof(LandscapeTiles::Vertex);
+    header.sizeX = mSupportPoints.sizeX();
+    header.sizeY = mSupportPoints.sizeY();
+    header.stride = mSupportPoints.stride();
+    header.scale = mScale;
+    header.tilesX = mTiles.tilesX();
+    header.tilesY = mTiles.tilesY();
+    ofs.write((const char*) &header, sizeof(header));
+
+    header.heightsOffset = bakePad(ofs);
+    ofs.write((const char*) mSupportPoints.data(), mSupportPoints.byteSize());
+
+    header.planesOffset = bakePad(ofs);
+    ofs.write((const char*) mPlaneTable, mesh.size() * sizeof(Plane));
+
+    // the directory is written again once the offsets are known
+    std::vector<BakeTileEntry> entries(header.tilesX * header.tilesY);
+    header.tilesOffset = bakePad(ofs);
+    ofs.write((const char*) entries.data(), entries.size() * sizeof(BakeTileEntry));
+
+    std::vector<LandscapeTiles::Vertex> vertices;
+    std::vector<GLushort> indices;
+    for (int x = 0; x < header.tilesX; ++x)
+    {
+        for (int y = 0; y < header.tilesY; ++y)
+        {
+            mTiles.buildTile(x, y, vertices, indices);
+            BakeTileEntry& entry = entries[x * header.tilesY + y];
+            entry.vertexCount = vertices.size();
+            entry.indexCount = indices.size();
+            entry.vertexOffset = bakePad(ofs);
+            ofs.write((const char*) vertices.data(), vertices.size() * sizeof(LandscapeTiles::Vertex));
+            entry.indexOffset = bakePad(ofs);
+            ofs.write((const char*) indices.data(), indices.size() * sizeof(GLushort));
+        }
+    }
+
+    ofs.seekp(0);
+    ofs.write((const char*) &header, sizeof(header));
+    ofs.seekp(header.tilesOffset);
+    ofs.write((const char*) entries.data(), entries.size() * sizeof(BakeTileEntry));
+
+    if (!hadPlaneTable)
+    {
+        mPlanes.clear();
+        mPlanes.shrink_to_fit();
+        mPlaneTable = nullptr;
+    }
+
+    if (ofs.fail())
+    {
+        std::cerr << "An error occurred while writing the baked landscape: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Landscape::loadBaked(const std::string& filename)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        return false;
+    }
+
+    // check everything before the landscape is touched
+    const BakeHeader& header = *(const BakeHeader*) file.data();
+    const std::uint64_t size = file.size();
+    const bool valid = size >= sizeof(BakeHeader) && header.magic == BakeMagic && header.version == BakeVersion &&
+                    header.planeSize == sizeof(Plane) && header.vertexSize == sizeof(LandscapeTiles::Vertex) &&
+                    header.sizeX > 1 && header.sizeY > 1 && header.stride >= (std::uint64_t) header.sizeY &&
+                    header.heightsOffset + header.stride * header.sizeX * sizeof(float) <= size &&
+                    header.planesOffset + (std::uint64_t) (header.sizeX - 1) * (header.sizeY - 1) * 2 * sizeof(Plane) <= size &&
+                    header.tilesOffset + (std::uint64_t) header.tilesX * header.tilesY * sizeof(BakeTileEntry) <= size &&
+                    header.heightsOffset % 64 == 0 && header.planesOffset % 64 == 0 && header.tilesOffset % 64 == 0 &&
+                    header.tilesX == (header.sizeX - 1 + LandscapeTiles::TileCells - 1) / LandscapeTiles::TileCells &&
+                    header.tilesY == (header.sizeY - 1 + LandscapeTiles::TileCells - 1) / LandscapeTiles::TileCells;
+    if (!valid)
+    {
+        std::cerr << filename << " is not a baked landscape of this version" << std::endl;
+        return false;
+    }
+
+    const BakeTileEntry* entries = (const BakeTileEntry*) (file.data() + header.tilesOffset);
+    std::vector<LandscapeTiles::TileData> tiles(header.tilesX * header.tilesY);
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        const BakeTileEntry& entry = entries[i];
+        if (entry.vertexOffset + (std::uint64_t) entry.vertexCount * sizeof(LandscapeTiles::Vertex) > size ||
+            entry.indexOffset + (std::uint64_t) entry.indexCount * sizeof(GLushort) > size)
+        {
+            std::cerr << "Invalid tile " << i << " in " << filename << std::endl;
+            return false;
+        }
+        tiles[i].vertices = (const LandscapeTiles::Vertex*) (file.data() + entry.vertexOffset);
+        tiles[i].vertexCount = entry.vertexCount;
+        tiles[i].indices = (const GLushort*) (file.data() + entry.indexOffset);
+        tiles[i].indexCount = entry.indexCount;
+    }
+
+    mPrefetcher.reset();
+    mTiled.close();
+    mType = Type::FILE;
+    mScale = header.scale;
+    mSupportPoints.attach((float*) (file.data() + header.heightsOffset), header.sizeX, header.sizeY, header.stride);
+    mPlanes.clear();
+    mPlanes.shrink_to_fit();
+    mPlaneTable = (const Plane*) (file.data() + header.planesOffset);
+    mUsePlaneTable = true;
+    mTiles.reset(&mSupportPoints, mScale);
+    mTiles.setTileData(tiles);
+    mClipmapSource = HeightfieldSource(mSupportPoints, mScale);
+    mClipmap.reset(&mClipmapSource);
+
+    // the old mapping was in use until now
+    mBaked.swap(file);
+    return true;
+}
+
+bool Landscape::isBaked() const
+{
+    return mBaked.isOpen();
+}
+
+void Landscape::setUsePlaneTable(bool enable)
+{
+    mUsePlaneTable = enable;
+    if (mUsePlaneTable)
+    {
+        buildPlaneTable();
+    }
+    else
+    {
+        mPlanes.clear();
+        mPlanes.shrink_to_fit();
+        mPlaneTable = nullptr;
+    }
 }
 
-std::vector<Triangle> Landscape::get()
+bool Landscape::usesPlaneTable() const
 {
-    return mTriangles;
+    return mUsePlaneTable;
+}
+
+void Landscape::buildPlaneTable()
+{
+    const LandscapeMesh mesh = get();
+    mPlanes.resize(mesh.size());
+    for (int x = 0; x < mesh.cellsX(); ++x)
+    {
+        for (int y = 0; y < mesh.cellsY(); ++y)
+        {
+            const float h00 = mSupportPoints(x, y);
+            const float h01 = mSupportPoints(x, y + 1);
+            const float h10 = mSupportPoints(x + 1, y);
+            const float h11 = mSupportPoints(x + 1, y + 1);
+
+            // the interpolation weights of both halves expanded in fx and fy
+            Plane& upper = mPlanes[mesh.index(x, y, 0)];
+            upper.a = h11 - h01;
+            upper.b = h01 - h00;
+            upper.c = h00;
+            upper.normal = mesh.normal(mesh.index(x, y, 0));
+
+            Plane& lower = mPlanes[mesh.index(x, y, 1)];
+            lower.a = h10 - h00;
+            lower.b = h11 - h10;
+            lower.c = h00;
+            lower.normal = mesh.normal(mesh.index(x, y, 1));
+        }
+    }
+    mPlaneTable = mPlanes.data();
+}
+
+LandscapeMesh Landscape::get() const
+{
+    return LandscapeMesh(mSupportPoints, mScale);
 }
 
 void Landscape::generateSupportPoints()
@@ -42,16 +350,16 @@ void Landscape::generateSupportPoints()
 void Landscape::generateRandomSurface()
 {
     mScale = 10.0;
+    mSupportPoints.resize(mDimX, mDimY);
     std::mt19937 mRandomGenerator;
     for (int x = 0; x < mDimX; ++x)
     {
-        std::vector<double> row;
         for (int y = 0; y < mDimY; ++y)
         {
             // consider available neighbours: (x,y-1),(x-1, y-1), (x-1, y), (x-1, y+1)
             if (x == 0 && y == 0)
             {
-                row.push_back(0);
+                mSupportPoints(x, y) = 0;
             }
             else if (x == 0)
             {
@@ -59,20 +367,18 @@ void Landscape::generateRandomSurface()
                 // x x
                 // o x
                 // v x
-                double center = row[y - 1];
+                double center = mSupportPoints(x, y - 1);
                 std::uniform_real_distribution<> dis(center - mMaxDeviationBetweenSupportPoints, center + mMaxDeviationBetweenSupportPoints);
-                double newHeight = dis(mRandomGenerator);
-                row.push_back(newHeight);
+                mSupportPoints(x, y) = dis(mRandomGenerator);
             }
             else if (y == 0)
             {
                 // neighbours: only (x-1, y), (x-1, y+1)
                 // v x x
                 // v o x
-                double center = (mSupportPoints[x - 1][y] + mSupportPoints[x - 1][y + 1]) / 2.0;
+                double center = (mSupportPoints(x - 1, y) + mSupportPoints(x - 1, y + 1)) / 2.0;
                 std::uniform_real_distribution<> dis(center - mMaxDeviationBetweenSupportPoints, center + mMaxDeviationBetweenSupportPoints);
-                double newHeight = dis(mRandomGenerator);
-                row.push_back(newHeight);
+                mSupportPoints(x, y) = dis(mRandomGenerator);
             }
             else
             {
@@ -80,49 +386,39 @@ void Landscape::generateRandomSurface()
                 // v x x
                 // v o x
                 // v v x
-                double center = (mSupportPoints[x - 1][y - 1] + mSupportPoints[x - 1][y] +
-                                mSupportPoints[x - 1][y + 1] + row[y - 1]) / 4.0;
+                double center = (mSupportPoints(x - 1, y - 1) + mSupportPoints(x - 1, y) +
+                                mSupportPoints(x - 1, y + 1) + mSupportPoints(x, y - 1)) / 4.0;
                 std::uniform_real_distribution<> dis(center - mMaxDeviationBetweenSupportPoints, center + mMaxDeviationBetweenSupportPoints);
-                double newHeight = dis(mRandomGenerator);
-                row.push_back(newHeight);
+                mSupportPoints(x, y) = dis(mRandomGenerator);
             }
         }
-        mSupportPoints.push_back(row);
     }
 }
 
 void Landscape::generateFlatSurface()
 {
     mScale = 10.0;
-    for (int x = 0; x < mDimX; ++x)
-    {
-        std::vector<double> row;
-        for (int y = 0; y < mDimY; ++y)
-        {
-            row.push_back(0);
-        }
-        mSupportPoints.push_back(row);
-    }
+    mSupportPoints.resize(mDimX, mDimY, 0.0f);
 }
 
 void Landscape::generateHeightMapSurface()
 {
-    std::string filename = "images/Terrain/terrain01_1081x1081.jpeg";
+    std::string filename = Heightmap;
 //    std::string filename = "images/Terrain/Garmisch.jpeg";
     mScale = 2.0;
     bool ret = loadHeightmap(filename);
     if (ret)
     {
-        unsigned char* src = mHeightMap.data();
-        for (int x = 0; x < mHeightMap.width(); ++x)
+        const unsigned char* src = mHeightMap.data();
+        mSupportPoints.resize(mHeightMap.width(), mHeightMap.height());
+        for (int x = 0; x < mSupportPoints.sizeX(); ++x)
         {
-            std::vector<double> row;
-            for (int y = 0; y < mHeightMap.height(); ++y)
+            float* row = mSupportPoints.row(x);
+            for (int y = 0; y < mSupportPoints.sizeY(); ++y)
             {
-                row.push_back(*src);
+                row[y] = *src;
                 src++;
             }
-            mSupportPoints.push_back(row);
         }
     }
     else
@@ -132,36 +428,6 @@ void Landscape::generateHeightMapSurface()
     }
 }
 
-void Landscape::interpolateTriangles()
-{
-    mTriangles.clear();
-    for (int x = 0; x < mSupportPoints.size() - 1; ++x)
-    {
-        for (int y = 0; y < mSupportPoints[x].size() - 1; ++y)
-        {
-            {
-                Triangle t;
-                t.setCorner(0, glm::vec3(x * mScale, y * mScale, mSupportPoints[x][y]));
-                t.setCorner(1, glm::vec3((x + 1) * mScale, (y + 1) * mScale, mSupportPoints[x + 1][y + 1]));
-                t.setCorner(2, glm::vec3(x * mScale, (y + 1) * mScale, mSupportPoints[x][y + 1]));
-                mTriangles.push_back(t);
-            }
-            {
-                Triangle t;
-                t.setCorner(0, glm::vec3(x * mScale, y * mScale, mSupportPoints[x][y]));
-                t.setCorner(1, glm::vec3((x + 1) * mScale, y * mScale, mSupportPoints[x + 1][y]));
-                t.setCorner(2, glm::vec3((x + 1) * mScale, (y + 1) * mScale, mSupportPoints[x + 1][y + 1]));
-                mTriangles.push_back(t);
-            }
-        }
-    }
-    for (auto& triangle : mTriangles)
-    {
-        glm::vec3 normal = triangle.getNormal();
-        mTriangleNormals.push_back(normal);
-    }
-}
-
 double Landscape::interpolateBilinear(float x, float y, glm::vec3 x1y1, glm::vec3 x1y2, glm::vec3 x2y1, glm::vec3 x2y2) const
 {
     float dx2x1 = (x2y1 - x1y1)[0];
@@ -204,29 +470,19 @@ double Landscape::getHeight2(double x, double y) const
 //            << indexX << ", " << (indexX + 1) * mScale << ", "
 //            << indexY << ", " << (indexY + 1) * mScale
 //            << std::endl;
-    //std::cout << mSupportPoints[indexX][indexY] << std::endl;
-    return interpolateBilinear(x, y, glm::vec3(indexX, indexY, mSupportPoints[indexX][indexY]),
-                    glm::vec3(indexX * mScale, (indexY + 1) * mScale, mSupportPoints[indexX][indexY + 1]),
-                    glm::vec3((indexX + 1) * mScale, indexY, mSupportPoints[indexX + 1][indexY]),
-                    glm::vec3((indexX + 1) * mScale, (indexY + 1) * mScale, mSupportPoints[indexX + 1][indexY + 1]));
+    //std::cout << mSupportPoints(indexX, indexY) << std::endl;
+    return interpolateBilinear(x, y, glm::vec3(indexX, indexY, mSupportPoints(indexX, indexY)),
+                    glm::vec3(indexX * mScale, (indexY + 1) * mScale, mSupportPoints(indexX, indexY + 1)),
+                    glm::vec3((indexX + 1) * mScale, indexY, mSupportPoints(indexX + 1, indexY)),
+                    glm::vec3((indexX + 1) * mScale, (indexY + 1) * mScale, mSupportPoints(indexX + 1, indexY + 1)));
 }
 
-//void Landscape::getLocalEnvironment(double x, double y, double& altitude, Vec3& surfaceNormal)
-//{
-//    Triangle t = findTriangle(x, y);
-//    mCurrentTriangle = Triangle(t);
-//    altitude = t.interpolateHeight(x, y);
-//    surfaceNormal = t.getNormal();
-//}
-
 void Landscape::getLocalEnvironment(float x, float y, float& altitude, glm::vec3& surfaceNormal)
 {
-    Triangle t = findTriangle(x, y);
-    mCurrentTriangle = Triangle(t);
-    altitude = t.interpolateHeight(x, y);
-    surfaceNormal = t.getNormal();
+    getLocalEnvironment(x, y, altitude, surfaceNormal, mCurrentTriangle);
 
 #if DEBUG
+    const Triangle t = triangle(mCurrentTriangle);
     std::cout << "local environment for (" << x << "/" << y << "):"
                     << "\t" << "Triangle: " << t.getCorner(0) << " " << t.getCorner(1) << " " << t.getCorner(2)
                     << "\t" << "Normal: " << surfaceNormal
@@ -234,56 +490,480 @@ void Landscape::getLocalEnvironment(float x, float y, float& altitude, glm::vec3
 #endif
 }
 
+void Landscape::getLocalEnvironment(float x, float y, float& altitude, glm::vec3& surfaceNormal, std::uint32_t& triangle) const
+{
+    if (mTiled.isOpen())
+    {
+        tiledEnvironment(x, y, altitude, surfaceNormal, triangle);
+    }
+    else if (mUsePlaneTable)
+    {
+        float fx, fy;
+        const Plane& plane = planeAt(x, y, fx, fy);
+        altitude = plane.c + plane.a * fx + plane.b * fy;
+        surfaceNormal = plane.normal;
+        triangle = (std::uint32_t) (&plane - mPlaneTable);
+    }
+    else
+    {
+        const Location location = locate(x, y);
+        triangle = location.triangle;
+        altitude = interpolateHeight(location);
+        surfaceNormal = get().normal(location.triangle);
+    }
+}
+
+Triangle Landscape::triangle(std::uint32_t index) const
+{
+    if (!mTiled.isOpen())
+    {
+        return get()[index];
+    }
+    // the same triangles as LandscapeMesh
+    const float scale = mTiled.spacing();
+    const int cellsY = mTiled.sizeY() - 1;
+    const int x = (int) (index / 2 / cellsY);
+    const int y = (int) (index / 2 % cellsY);
+    const glm::vec3 c00(x * scale, y * scale, mTiled.height(x, y));
+    const glm::vec3 c11((x + 1) * scale, (y + 1) * scale, mTiled.height(x + 1, y + 1));
+    Triangle triangle;
+    triangle.setCorner(0, c00);
+    if (index % 2 == 0)
+    {
+        triangle.setCorner(1, c11);
+        triangle.setCorner(2, glm::vec3(x * scale, (y + 1) * scale, mTiled.height(x, y + 1)));
+    }
+    else
+    {
+        triangle.setCorner(1, glm::vec3((x + 1) * scale, y * scale, mTiled.height(x + 1, y)));
+        triangle.setCorner(2, c11);
+    }
+    return triangle;
+}
+
 double Landscape::getHeight(double x, double y)
 {
-    const Triangle& t = findTriangle(x, y);
-    double result = t.interpolateHeight(x, y);
-    return result;
+    if (mTiled.isOpen())
+    {
+        float altitude;
+        glm::vec3 normal;
+        std::uint32_t triangle;
+        tiledEnvironment(x, y, altitude, normal, triangle);
+        return altitude;
+    }
+    if (mUsePlaneTable)
+    {
+        float fx, fy;
+        const Plane& plane = planeAt(x, y, fx, fy);
+        return plane.c + plane.a * fx + plane.b * fy;
+    }
+    return interpolateHeight(locate(x, y));
 }
 
 Triangle Landscape::findTriangle(double x, double y) const
 {
-    glm::vec2 pos(x, y);
-    // find triangle via polar coordinates
-    // origin:
-    glm::vec2 origin((int) (x / mScale) * mScale, (int) (y / mScale) * mScale);
-    glm::vec2 diff = pos - origin;
-    double rho = 0;
-    if (diff[1] == 0.0)
+    if (mTiled.isOpen())
     {
-        if (diff[0] > 0) rho = 90.0;
-        else rho = 270.0;
+        float altitude;
+        glm::vec3 normal;
+        std::uint32_t index;
+        tiledEnvironment(x, y, altitude, normal, index);
+        return triangle(index);
     }
-    else
+    return get()[locate(x, y).triangle];
+}
+
+namespace
+{
+    // a point in units of cells, split into its cell and the position inside
+    struct CellPoint
+    {
+        int x;
+        int y;
+        float fx;
+        float fy;
+        bool upper;
+    };
+
+    /* Locate (x, y) given in units of cells. The point is clamped to the grid.
+     * Inside a cell the upper left triangle is the one with fy >= fx; points on
+     * the diagonal belong to it, except for the cell origin itself.
+     * The clamping is written the way SSE's max/min instructions evaluate it,
+     * so that the vectorised kernels below produce bit-identical results.
+     */
+    inline CellPoint cellPoint(float x, float y, int cellsX, int cellsY)
     {
-        rho = atan(diff[0] / diff[1]) / pi * 180.0;
+        x = x > 0.0f ? x : 0.0f;
+        x = x < (float) cellsX ? x : (float) cellsX;
+        y = y > 0.0f ? y : 0.0f;
+        y = y < (float) cellsY ? y : (float) cellsY;
+
+        CellPoint p;
+        p.x = std::min((int) x, cellsX - 1);
+        p.y = std::min((int) y, cellsY - 1);
+        p.fx = x - (float) p.x;
+        p.fy = y - (float) p.y;
+        p.upper = (p.fx <= p.fy) && (p.fy > 0.0f);
+        return p;
     }
-    if (rho < 0) rho += 360.0;
 
-    //std::cout << "pos: " << pos << "; origin: " << origin << "; rho: " << rho << "; diff: " << diff << std::endl;
-    int scale = (int)mScale;
-    int indexX = x / scale;
-    int indexY = y / scale;
+    inline Landscape::Location locatePoint(float x, float y, int cellsX, int cellsY)
+    {
+        const CellPoint p = cellPoint(x, y, cellsX, cellsY);
+
+        Landscape::Location location;
+        location.triangle = ((std::uint32_t) p.x * cellsY + p.y) * 2 + (p.upper ? 0 : 1);
+        // upper: (0,0), (1,1), (0,1)  lower: (0,0), (1,0), (1,1)
+        location.weights[0] = 1.0f - (p.upper ? p.fy : p.fx);
+        location.weights[1] = p.upper ? p.fx : p.fx - p.fy;
+        location.weights[2] = p.upper ? p.fy - p.fx : p.fy;
+        return location;
+    }
+
+    // what the batch kernels need to know about the landscape
+    struct QueryGrid
+    {
+        const float* heights;
+        size_t stride;
+        int cellsX;
+        int cellsY;
+        float invScale;
+        float scale;
+    };
+
+    inline QueryGrid makeQueryGrid(const Heightfield<float>& heights, double scale)
+    {
+        QueryGrid grid;
+        grid.heights = heights.data();
+        grid.stride = heights.stride();
+        grid.cellsX = heights.sizeX() - 1;
+        grid.cellsY = heights.sizeY() - 1;
+        // same expression as in Landscape::locate
+        grid.invScale = 1.0f / scale;
+        grid.scale = scale;
+        return grid;
+    }
+
+    /* The reference kernel for one point. Altitude and normal are evaluated in
+     * exactly the order of Landscape::interpolateHeight and LandscapeMesh::normal.
+     */
+    inline void localEnvironment(const QueryGrid& grid, const glm::vec2& position, float& altitude, glm::vec3& surfaceNormal)
+    {
+        const CellPoint p = cellPoint(position.x * grid.invScale, position.y * grid.invScale, grid.cellsX, grid.cellsY);
+        const float* h0 = grid.heights + p.x * grid.stride + p.y;
+        const float* h1 = h0 + grid.stride;
+        const float h00 = h0[0];
+        const float h01 = h0[1];
+        const float h10 = h1[0];
+        const float h11 = h1[1];
+
+        const float w0 = 1.0f - (p.upper ? p.fy : p.fx);
+        const float w1 = p.upper ? p.fx : p.fx - p.fy;
+        const float w2 = p.upper ? p.fy - p.fx : p.fy;
+        const float c1 = p.upper ? h11 : h10;
+        const float c2 = p.upper ? h01 : h11;
+        altitude = w0 * h00 + w1 * c1 + w2 * c2;
+
+        const float nx = p.upper ? h01 - h11 : h00 - h10;
+        const float ny = p.upper ? h00 - h01 : h10 - h11;
+        const float nz = grid.scale;
+        const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+        surfaceNormal = glm::vec3(nx / length, ny / length, nz / length);
+    }
+
+#if defined(AVX2_KERNEL)
+    AVX2_KERNEL inline __m256 select(__m256 mask, __m256 a, __m256 b)
+    {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+
+    // processes the largest multiple of 8 points, returns how many that were
+    AVX2_KERNEL size_t localEnvironmentsAvx2(const QueryGrid& grid, const glm::vec2* positions, size_t count, float* altitudes, glm::vec3* surfaceNormals)
+    {
+        const size_t BatchLanes = 8;
+        const __m256 invScale = _mm256_set1_ps(grid.invScale);
+        const __m256 scale = _mm256_set1_ps(grid.scale);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 maxX = _mm256_set1_ps((float) grid.cellsX);
+        const __m256 maxY = _mm256_set1_ps((float) grid.cellsY);
+        const __m256 lastX = _mm256_set1_ps((float) (grid.cellsX - 1));
+        const __m256 lastY = _mm256_set1_ps((float) (grid.cellsY - 1));
+        const __m256i stride = _mm256_set1_epi32((int) grid.stride);
+        const __m256i strideOne = _mm256_set1_epi32((int) grid.stride + 1);
+        const __m256i oneI = _mm256_set1_epi32(1);
+
+        alignas(32) float nx[BatchLanes];
+        alignas(32) float ny[BatchLanes];
+        alignas(32) float nz[BatchLanes];
+
+        size_t i = 0;
+        for (; i + BatchLanes <= count; i += BatchLanes)
+        {
+            // deinterleave x0 y0 x1 y1 ... into x0..x7 and y0..y7
+            const float* src = &positions[i].x;
+            const __m256 a = _mm256_loadu_ps(src);
+            const __m256 b = _mm256_loadu_ps(src + 8);
+            const __m256 xs = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+            const __m256 ys = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+
+            __m256 gx = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(xs, invScale), zero), maxX);
+            __m256 gy = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(ys, invScale), zero), maxY);
+            const __m256 cx = _mm256_min_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(gx)), lastX);
+            const __m256 cy = _mm256_min_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(gy)), lastY);
+            const __m256 fx = _mm256_sub_ps(gx, cx);
+            const __m256 fy = _mm256_sub_ps(gy, cy);
+            const __m256 upper = _mm256_and_ps(_mm256_cmp_ps(fx, fy, _CMP_LE_OQ), _mm256_cmp_ps(fy, zero, _CMP_GT_OQ));
+
+            const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(cx), stride), _mm256_cvttps_epi32(cy));
+            const __m256 h00 = _mm256_i32gather_ps(grid.heights, index, 4);
+            const __m256 h01 = _mm256_i32gather_ps(grid.heights, _mm256_add_epi32(index, oneI), 4);
+            const __m256 h10 = _mm256_i32gather_ps(grid.heights, _mm256_add_epi32(index, stride), 4);
+            const __m256 h11 = _mm256_i32gather_ps(grid.heights, _mm256_add_epi32(index, strideOne), 4);
+
+            const __m256 w0 = _mm256_sub_ps(one, select(upper, fy, fx));
+            const __m256 w1 = select(upper, fx, _mm256_sub_ps(fx, fy));
+            const __m256 w2 = select(upper, _mm256_sub_ps(fy, fx), fy);
+            const __m256 c1 = select(upper, h11, h10);
+            const __m256 c2 = select(upper, h01, h11);
+            const __m256 altitude = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, h00), _mm256_mul_ps(w1, c1)), _mm256_mul_ps(w2, c2));
+            _mm256_storeu_ps(altitudes + i, altitude);
+
+            const __m256 x = select(upper, _mm256_sub_ps(h01, h11), _mm256_sub_ps(h00, h10));
+            const __m256 y = select(upper, _mm256_sub_ps(h00, h01), _mm256_sub_ps(h10, h11));
+            const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(scale, scale)));
+            _mm256_store_ps(nx, _mm256_div_ps(x, length));
+            _mm256_store_ps(ny, _mm256_div_ps(y, length));
+            _mm256_store_ps(nz, _mm256_div_ps(scale, length));
+            for (size_t lane = 0; lane < BatchLanes; ++lane)
+            {
+                surfaceNormals[i + lane] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+    inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // processes the largest multiple of 4 points, returns how many that were
+    size_t localEnvironmentsSse2(const QueryGrid& grid, const glm::vec2* positions, size_t count, float* altitudes, glm::vec3* surfaceNormals)
+    {
+        const size_t BatchLanes = 4;
+        const __m128 invScale = _mm_set1_ps(grid.invScale);
+        const __m128 scale = _mm_set1_ps(grid.scale);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 maxX = _mm_set1_ps((float) grid.cellsX);
+        const __m128 maxY = _mm_set1_ps((float) grid.cellsY);
+        const __m128 lastX = _mm_set1_ps((float) (grid.cellsX - 1));
+        const __m128 lastY = _mm_set1_ps((float) (grid.cellsY - 1));
+
+        alignas(16) int cellX[BatchLanes];
+        alignas(16) int cellY[BatchLanes];
+        alignas(16) float nx[BatchLanes];
+        alignas(16) float ny[BatchLanes];
+        alignas(16) float nz[BatchLanes];
+
+        size_t i = 0;
+        for (; i + BatchLanes <= count; i += BatchLanes)
+        {
+            // deinterleave x0 y0 x1 y1 ... into x0..x3 and y0..y3
+            const float* src = &positions[i].x;
+            const __m128 a = _mm_loadu_ps(src);
+            const __m128 b = _mm_loadu_ps(src + 4);
+            const __m128 xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            __m128 gx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(xs, invScale), zero), maxX);
+            __m128 gy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(ys, invScale), zero), maxY);
+            const __m128 cx = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gx)), lastX);
+            const __m128 cy = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gy)), lastY);
+            const __m128 fx = _mm_sub_ps(gx, cx);
+            const __m128 fy = _mm_sub_ps(gy, cy);
+            const __m128 upper = _mm_and_ps(_mm_cmple_ps(fx, fy), _mm_cmpgt_ps(fy, zero));
+
+            // SSE2 has no gather, fetch the corners lane by lane
+            _mm_store_si128((__m128i*) cellX, _mm_cvttps_epi32(cx));
+            _mm_store_si128((__m128i*) cellY, _mm_cvttps_epi32(cy));
+            alignas(16) float c00[BatchLanes];
+            alignas(16) float c01[BatchLanes];
+            alignas(16) float c10[BatchLanes];
+            alignas(16) float c11[BatchLanes];
+            for (size_t lane = 0; lane < BatchLanes; ++lane)
+            {
+                const float* h0 = grid.heights + cellX[lane] * grid.stride + cellY[lane];
+                const float* h1 = h0 + grid.stride;
+                c00[lane] = h0[0];
+                c01[lane] = h0[1];
+                c10[lane] = h1[0];
+                c11[lane] = h1[1];
+            }
+            const __m128 h00 = _mm_load_ps(c00);
+            const __m128 h01 = _mm_load_ps(c01);
+            const __m128 h10 = _mm_load_ps(c10);
+            const __m128 h11 = _mm_load_ps(c11);
+
+            const __m128 w0 = _mm_sub_ps(one, select(upper, fy, fx));
+            const __m128 w1 = select(upper, fx, _mm_sub_ps(fx, fy));
+            const __m128 w2 = select(upper, _mm_sub_ps(fy, fx), fy);
+            const __m128 c1 = select(upper, h11, h10);
+            const __m128 c2 = select(upper, h01, h11);
+            const __m128 altitude = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, h00), _mm_mul_ps(w1, c1)), _mm_mul_ps(w2, c2));
+            _mm_storeu_ps(altitudes + i, altitude);
+
+            const __m128 x = select(upper, _mm_sub_ps(h01, h11), _mm_sub_ps(h00, h10));
+            const __m128 y = select(upper, _mm_sub_ps(h00, h01), _mm_sub_ps(h10, h11));
+            const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(scale, scale)));
+            _mm_store_ps(nx, _mm_div_ps(x, length));
+            _mm_store_ps(ny, _mm_div_ps(y, length));
+            _mm_store_ps(nz, _mm_div_ps(scale, length));
+            for (size_t lane = 0; lane < BatchLanes; ++lane)
+            {
+                surfaceNormals[i + lane] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__)
+    size_t localEnvironmentsSimd(const QueryGrid& grid, const glm::vec2* positions, size_t count, float* altitudes, glm::vec3* surfaceNormals)
+    {
+#if defined(__AVX2__)
+        return localEnvironmentsAvx2(grid, positions, count, altitudes, surfaceNormals);
+#else
+#if defined(AVX2_KERNEL)
+        if (hasAvx2())
+        {
+            return localEnvironmentsAvx2(grid, positions, count, altitudes, surfaceNormals);
+        }
+#endif
+        return localEnvironmentsSse2(grid, positions, count, altitudes, surfaceNormals);
+#endif
+    }
+#endif
+}
+
+Landscape::Location Landscape::locate(float x, float y) const
+{
+    const float invScale = 1.0f / mScale;
+    return locatePoint(x * invScale, y * invScale, mSupportPoints.sizeX() - 1, mSupportPoints.sizeY() - 1);
+}
+
+void Landscape::locate(const glm::vec2* points, size_t count, Location* locations) const
+{
+    const float invScale = 1.0f / mScale;
+    const int cellsX = mSupportPoints.sizeX() - 1;
+    const int cellsY = mSupportPoints.sizeY() - 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        locations[i] = locatePoint(points[i].x * invScale, points[i].y * invScale, cellsX, cellsY);
+    }
+}
+
+const Landscape::Plane& Landscape::planeAt(float x, float y, float& fx, float& fy) const
+{
+    const float invScale = 1.0f / mScale;
+    const int cellsY = mSupportPoints.sizeY() - 1;
+    const CellPoint p = cellPoint(x * invScale, y * invScale, mSupportPoints.sizeX() - 1, cellsY);
+    fx = p.fx;
+    fy = p.fy;
+    return mPlaneTable[((size_t) p.x * cellsY + p.y) * 2 + (p.upper ? 0 : 1)];
+}
 
-    Triangle t;
-    if (rho <= 45.0) // upper left triangle
+void Landscape::getLocalEnvironments(Span<const glm::vec2> positions, Span<float> altitudes, Span<glm::vec3> surfaceNormals) const
+{
+    assert(altitudes.size() >= positions.size());
+    assert(surfaceNormals.size() >= positions.size());
+
+    if (mTiled.isOpen())
     {
-        t.setCorner(0, glm::vec3(indexX * mScale, indexY * mScale, mSupportPoints[indexX][indexY]));
-        t.setCorner(1, glm::vec3((indexX + 1) * mScale, (indexY + 1) * mScale, mSupportPoints[indexX + 1][indexY + 1]));
-        t.setCorner(2, glm::vec3(indexX * mScale, (indexY + 1) * mScale, mSupportPoints[indexX][indexY + 1]));
+        // the kernels need the support points in memory
+        std::uint32_t triangle;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            tiledEnvironment(positions[i].x, positions[i].y, altitudes[i], surfaceNormals[i], triangle);
+        }
+        return;
     }
-    else // lower right triangle
+    assert(mSupportPoints.sizeX() > 1 && mSupportPoints.sizeY() > 1);
+
+    size_t done = 0;
+#if defined(__SSE2__)
+    const QueryGrid grid = makeQueryGrid(mSupportPoints, mScale);
+    done = localEnvironmentsSimd(grid, positions.data(), positions.size(), altitudes.data(), surfaceNormals.data());
+#endif
+    getLocalEnvironmentsScalar(positions.subspan(done, positions.size() - done),
+                    altitudes.subspan(done, positions.size() - done),
+                    surfaceNormals.subspan(done, positions.size() - done));
+}
+
+void Landscape::getLocalEnvironmentsScalar(Span<const glm::vec2> positions, Span<float> altitudes, Span<glm::vec3> surfaceNormals) const
+{
+    assert(!mTiled.isOpen());
+    const QueryGrid grid = makeQueryGrid(mSupportPoints, mScale);
+    for (size_t i = 0; i < positions.size(); ++i)
     {
-        t.setCorner(0, glm::vec3(indexX * mScale, indexY * mScale, mSupportPoints[indexX][indexY]));
-        t.setCorner(1, glm::vec3((indexX + 1) * mScale, indexY * mScale, mSupportPoints[indexX + 1][indexY]));
-        t.setCorner(2, glm::vec3((indexX + 1) * mScale, (indexY + 1) * mScale, mSupportPoints[indexX + 1][indexY + 1]));
+        localEnvironment(grid, positions[i], altitudes[i], surfaceNormals[i]);
     }
-    return t;
 }
 
-bool Landscape::isCurrentTriangle(const Triangle& triangle) const
+const char* Landscape::batchKernelName()
 {
-    return (mCurrentTriangle == triangle);
+#if defined(__SSE2__)
+    return hasAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void Landscape::tiledEnvironment(float x, float y, float& altitude, glm::vec3& surfaceNormal, std::uint32_t& triangle) const
+{
+    const float scale = mTiled.spacing();
+    const int cellsX = mTiled.sizeX() - 1;
+    const int cellsY = mTiled.sizeY() - 1;
+    const float invScale = 1.0f / scale;
+    const CellPoint p = cellPoint(x * invScale, y * invScale, cellsX, cellsY);
+
+    // the same triangles and normals as LandscapeMesh
+    float h00, h01, h10, h11;
+    mTiled.cellHeights(p.x, p.y, h00, h01, h10, h11);
+    triangle = ((std::uint32_t) p.x * cellsY + p.y) * 2 + (p.upper ? 0 : 1);
+    glm::vec3 n;
+    if (p.upper)
+    {
+        altitude = (1.0f - p.fy) * h00 + p.fx * h11 + (p.fy - p.fx) * h01;
+        n = glm::vec3(h01 - h11, h00 - h01, scale);
+    }
+    else
+    {
+        altitude = (1.0f - p.fx) * h00 + (p.fx - p.fy) * h10 + p.fy * h11;
+        n = glm::vec3(h00 - h10, h10 - h11, scale);
+    }
+    surfaceNormal = n / std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+}
+
+float Landscape::interpolateHeight(const Location& location) const
+{
+    const glm::vec3 heights = get().cornerHeights(location.triangle);
+    return location.weights[0] * heights[0] +
+           location.weights[1] * heights[1] +
+           location.weights[2] * heights[2];
+}
+
+bool Landscape::isCurrentTriangle(const Triangle& t) const
+{
+    return triangle(mCurrentTriangle) == t;
+}
+
+void Landscape::setCurrentTriangle(std::uint32_t triangle)
+{
+    mCurrentTriangle = triangle;
 }
 
 const GLfloat* Landscape::getMaterialSpecular()
@@ -296,51 +976,35 @@ const GLfloat* Landscape::getMaterialShininess()
     return &mat_shininess[0];
 }
 
+void Landscape::setRenderMode(RenderMode mode)
+{
+    mRenderMode = mode;
+}
+
+Landscape::RenderMode Landscape::renderMode() const
+{
+    return mRenderMode;
+}
+
 void Landscape::draw(glm::vec2 position, float radius)
 {
     unsigned long start = Utils::clockTimeMs();
 
-    for (size_t i = 0; i < mTriangles.size(); ++i)
-    {
-        auto& triangle = mTriangles[i];
-        glm::vec3 corner = triangle.getCorner(0);
-//        460ms
-//        glm::vec2 diff = position - glm::vec2(corner.x, corner.y);
-//        if (radius * radius < diff.length())
-//            continue;
-
-//        220ms
-//        if (pow(radius, 2) < (pow(position.x - corner.x, 2) + pow(position.y - corner.y, 2)))
-//            continue;
-
-        float dx = position.x - corner.x;
-        float dy = position.y - corner.y;
-        if (radius * radius < (dx * dx + dy * dy))
-            continue;
-        glBegin(GL_TRIANGLES);
-        glm::vec3 p;
-        for (int vertex = 0; vertex < 3; ++vertex)
-        {
-            if (vertex == 0)
-            {
-                glTexCoord2i(0, 0);
-            }
-            else if (vertex == 1)
-            {
-                glTexCoord2i(1, 1);
-            }
-            else
-            {
-                glTexCoord2i(0, 1);
-            }
-
-            p = triangle.getCorner(vertex);
-            glVertex3f(p.x, p.y, p.z);
-        }
-        glm::vec3 normalVec = mTriangleNormals[i / 3];
-        glNormal3fv(glm::value_ptr(normalVec));
-        glEnd();
+    if (mTiled.isOpen() || mRenderMode == RenderMode::CLIPMAP)
+    {
+        // the rings cover a fixed area around position, radius is not used
+        mClipmap.update(position);
+        mClipmap.draw();
     }
+    else if (mRenderMode == RenderMode::TILES)
+    {
+        mTiles.draw(position, radius);
+    }
+    else
+    {
+        drawImmediate(position, radius);
+    }
+
     unsigned long end = Utils::clockTimeMs();
     if (end - start > 16)
     {
@@ -348,60 +1012,126 @@ void Landscape::draw(glm::vec2 position, float radius)
     }
 }
 
-void Landscape::drawNormals(glm::vec2 position, float radius)
+void Landscape::drawImmediate(glm::vec2 position, float radius)
 {
-    Triangle localTriangle = findTriangle(position.x,  position.y);
-    for (const auto& triangle : mTriangles)
+    const LandscapeMesh mesh = get();
+    int minX, maxX, minY, maxY;
+    cellRange(position, radius, minX, maxX, minY, maxY);
+    for (int x = minX; x <= maxX; ++x)
     {
-        glm::vec3 corner = triangle.getCorner(0);
-        float dx = position.x - corner.x;
-        float dy = position.y - corner.y;
-
-        if (radius > 0)
+        for (int y = minY; y <= maxY; ++y)
         {
-            if (radius * radius < (dx * dx + dy * dy))
-                continue;
+            for (int half = 0; half < 2; ++half)
+            {
+                const size_t i = mesh.index(x, y, half);
+                glm::vec3 corner = mesh.corner(i, 0);
+                float dx = position.x - corner.x;
+                float dy = position.y - corner.y;
+                if (radius * radius < (dx * dx + dy * dy))
+                    continue;
+                glBegin(GL_TRIANGLES);
+                glm::vec3 normalVec = mesh.normal(i);
+                glNormal3fv(glm::value_ptr(normalVec));
+                glm::vec3 p;
+                for (int vertex = 0; vertex < 3; ++vertex)
+                {
+                    if (vertex == 0)
+                    {
+                        glTexCoord2i(0, 0);
+                    }
+                    else if (vertex == 1)
+                    {
+                        glTexCoord2i(1, 1);
+                    }
+                    else
+                    {
+                        glTexCoord2i(0, 1);
+                    }
+
+                    p = mesh.corner(i, vertex);
+                    glVertex3f(p.x, p.y, p.z);
+                }
+                glEnd();
+            }
         }
-        else
+    }
+}
+
+void Landscape::drawNormals(glm::vec2 position, float radius)
+{
+    const LandscapeMesh mesh = get();
+    Triangle localTriangle = findTriangle(position.x,  position.y);
+    int minX, maxX, minY, maxY;
+    // without a radius only the triangle below position is drawn
+    cellRange(position, std::max(radius, 0.0f), minX, maxX, minY, maxY);
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int y = minY; y <= maxY; ++y)
         {
-            if (triangle != localTriangle) continue;
-        }
+            for (int half = 0; half < 2; ++half)
+            {
+                const Triangle triangle = mesh[mesh.index(x, y, half)];
+                glm::vec3 corner = triangle.getCorner(0);
+                float dx = position.x - corner.x;
+                float dy = position.y - corner.y;
+
+                if (radius > 0)
+                {
+                    if (radius * radius < (dx * dx + dy * dy))
+                        continue;
+                }
+                else
+                {
+                    if (triangle != localTriangle) continue;
+                }
 
-        glMatrixMode( GL_MODELVIEW );
-        glPushMatrix();
+                glMatrixMode( GL_MODELVIEW );
+                glPushMatrix();
 
-        glPushAttrib( GL_ENABLE_BIT );
-        glDisable( GL_LIGHTING );
+                glPushAttrib( GL_ENABLE_BIT );
+                glDisable( GL_LIGHTING );
 
-        glColor3f( 1.0f, 1.0f, 0.0f );// Yellow
+                glColor3f( 1.0f, 1.0f, 0.0f );// Yellow
 
-        const float factor = 2.0;
-        glBegin( GL_LINES );
+                const float factor = 2.0;
+                glBegin( GL_LINES );
 #if 1
-        glm::vec3 p = triangle.getIncircleCenter();
-        glm::vec3 normalVec = triangle.getNormal();
-        glVertex3f(p.x, p.y, p.z);
-        glVertex3fv(glm::value_ptr(p + normalVec * factor));
+                glm::vec3 p = triangle.getIncircleCenter();
+                glm::vec3 normalVec = triangle.getNormal();
+                glVertex3f(p.x, p.y, p.z);
+                glVertex3fv(glm::value_ptr(p + normalVec * factor));
 //        std::cout << p.x << " " << p.y << " " << p.z << "\n";
 #else
-        for (int i = 0 ; i < 3; ++i)
-        {
-            glm::vec3 p = triangle.getCorner(i);
-            glm::vec3 normalVec = triangle.getNormal();
+                for (int i = 0 ; i < 3; ++i)
+                {
+                    glm::vec3 p = triangle.getCorner(i);
+                    glm::vec3 normalVec = triangle.getNormal();
 
-            glVertex3f(p.x, p.y, p.z);
-            glVertex3fv(glm::value_ptr(p + normalVec * factor));
+                    glVertex3f(p.x, p.y, p.z);
+                    glVertex3fv(glm::value_ptr(p + normalVec * factor));
 //            std::cout << i << " " << p.x << " " << p.y << " " << p.z << " - " << normalVec.x << " " << normalVec.y << " " << normalVec.z << "\n";
-        }
+                }
 #endif
-        glEnd();
+                glEnd();
 
-        glPopAttrib();
+                glPopAttrib();
 
-        glPopMatrix();
+                glPopMatrix();
+            }
+        }
     }
 }
 
+void Landscape::cellRange(glm::vec2 position, float radius, int& minX, int& maxX, int& minY, int& maxY) const
+{
+    const int cellsX = mSupportPoints.sizeX() - 1;
+    const int cellsY = mSupportPoints.sizeY() - 1;
+    minX = std::max(0, (int) std::floor((position.x - radius) / mScale));
+    maxX = std::min(cellsX - 1, (int) std::floor((position.x + radius) / mScale));
+    minY = std::max(0, (int) std::floor((position.y - radius) / mScale));
+    maxY = std::min(cellsY - 1, (int) std::floor((position.y + radius) / mScale));
+}
+
 bool Landscape::loadHeightmap(const std::string& filename)
 {
     int ret = mHeightMap.load(filename);
@@ -2,11 +2,23 @@
 #define LANDSCAPE_H
 
 #include "Triangle.h"
+#include "Heightfield.h"
+#include "LandscapeMesh.h"
+#include "LandscapeTiles.h"
+#include "HeightSource.h"
+#include "TiledHeightfield.h"
+#include "TilePrefetcher.h"
+#include "Clipmap.h"
+#include "utils/Span.h"
+#include "utils/AlignedAllocator.h"
 #include "utils/Jpeg.h"
+#include "utils/MappedFile.h"
 
 #include <GL/glut.h>
 #include <vector>
 #include <random>
+#include <cstdint>
+#include <memory>
 
 /**
  @brief A landscape consisting of a mesh of triangles, regular in x and y, with
@@ -22,48 +34,157 @@ public:
         FILE
     };
 
+    enum class RenderMode
+    {
+        IMMEDIATE, // one glBegin/glEnd per triangle
+        TILES,     // one vertex buffer draw call per tile, see LandscapeTiles
+        CLIPMAP    // nested rings around the position, see Clipmap
+    };
+
+    /* @brief the position of a point on the landscape: the triangle it lies in
+     * (an index into get()) and its barycentric weights with respect to the
+     * three corners of that triangle.
+     */
+    struct Location
+    {
+        std::uint32_t triangle;
+        float weights[3];
+    };
+
+    /* @brief the plane of one triangle in coordinates local to its cell:
+     * height = c + a * fx + b * fy for fx, fy in [0, 1], plus its unit normal.
+     */
+    struct Plane
+    {
+        float a;
+        float b;
+        float c;
+        glm::vec3 normal;
+    };
+
+    // the heightmap of Type::FILE and the default output of terrainbake
+    static const char* const Heightmap;
+    static const char* const BakedHeightmap;
+
     Landscape();
     ~Landscape() = default;
 
     void generate(Type type);
 
-    std::vector<Triangle> get();
+    /* @brief use the heights of a TiledHeightfield file instead of generated
+     * support points. Tiles are paged in as queries and the clipmap touch
+     * them, keeping at most budgetBytes of them in memory; generate() closes
+     * the file again. While a file is open, the landscape is always drawn
+     * as a clipmap and the batched queries, get() and the plane table are
+     * not available.
+     */
+    bool openTiled(const std::string& filename, std::size_t budgetBytes);
+
+    /* @brief write everything generate() derives from the support points to
+     * one file: the heights, the plane table and the geometry of all render
+     * tiles. loadBaked maps such a file and uses its contents in place, which
+     * is much faster than generate(Type::FILE). It fails on files written by
+     * another version or build with a different layout.
+     */
+    bool bake(const std::string& filename);
+    bool loadBaked(const std::string& filename);
+    bool isBaked() const;
+
+    bool isTiled() const;
+    /* @brief load the tiles along the predicted path of a vehicle in the
+     * background, see TilePrefetcher. Does nothing without a tiled file.
+     */
+    void prefetch(const glm::vec3& position, double velocity, float yaw);
+    TilePrefetcher::Stats prefetchStats() const;
+
+    /* @brief precompute the plane of every triangle, so that getHeight and
+     * getLocalEnvironment neither interpolate nor normalise per query. The
+     * table takes 24 bytes per triangle and is rebuilt by generate().
+     */
+    void setUsePlaneTable(bool enable);
+    bool usesPlaneTable() const;
+
+    /* @brief the triangle mesh of the landscape. The triangles are derived
+     * from the support points on access and are not stored.
+     */
+    LandscapeMesh get() const;
     //void getLocalEnvironment(double x, double y, double& altitude, Vec3& surfaceNormal);
     void getLocalEnvironment(float x, float y, float& altitude, glm::vec3& surfaceNormal);
+    /* @brief getLocalEnvironment that also returns the index of the triangle
+     * below (x, y) instead of remembering it as the current triangle. It
+     * changes nothing, so it may run next to draw() on another thread.
+     */
+    void getLocalEnvironment(float x, float y, float& altitude, glm::vec3& surfaceNormal, std::uint32_t& triangle) const;
+    // the triangle of an index from getLocalEnvironment, as in get(), also while tiled
+    Triangle triangle(std::uint32_t index) const;
     double getHeight(double x, double y);
     double getHeight2(double x, double y) const;
 
     Triangle findTriangle(double x, double y) const;
 
+    /* @brief find the triangle below (x, y). Points outside of the landscape
+     * are clamped to its border.
+     */
+    Location locate(float x, float y) const;
+    void locate(const glm::vec2* points, size_t count, Location* locations) const;
+    float interpolateHeight(const Location& location) const;
+
+    /* @brief getLocalEnvironment for many points at once, e.g. all vehicles of
+     * a simulation step. Uses an AVX2 kernel on CPUs that have it, an SSE2
+     * one on other x86 CPUs; the results are bit-identical to the scalar kernel. On a tiled
+     * landscape the points are looked up one by one. Needs a generated or
+     * loaded landscape.
+     */
+    void getLocalEnvironments(Span<const glm::vec2> positions, Span<float> altitudes, Span<glm::vec3> surfaceNormals) const;
+
+    // name of the vectorised kernel getLocalEnvironments uses on this CPU
+    static const char* batchKernelName();
+
     bool isCurrentTriangle(const Triangle& triangle) const;
+    // the index of the triangle draw() highlights, usually set by getLocalEnvironment
+    void setCurrentTriangle(std::uint32_t triangle);
 
     const GLfloat* getMaterialSpecular();
     const GLfloat* getMaterialShininess();
 
+    void setRenderMode(RenderMode mode);
+    RenderMode renderMode() const;
+
     void draw(glm::vec2 position, float radius);
     void drawNormals(glm::vec2 position, float radius);
 
 protected:
     bool loadHeightmap(const std::string& filename);
 
+    void getLocalEnvironmentsScalar(Span<const glm::vec2> positions, Span<float> altitudes, Span<glm::vec3> surfaceNormals) const;
+
     void generateSupportPoints();
-    void interpolateTriangles();
+    void drawImmediate(glm::vec2 position, float radius);
+    void buildPlaneTable();
+    // getLocalEnvironment on the tiled heightfield
+    void tiledEnvironment(float x, float y, float& altitude, glm::vec3& surfaceNormal, std::uint32_t& triangle) const;
+    // the plane below (x, y) and the position of the point inside its cell
+    const Plane& planeAt(float x, float y, float& fx, float& fy) const;
     double interpolateBilinear(float x, float y, glm::vec3 x1y1, glm::vec3 x1y2, glm::vec3 x2y1, glm::vec3 x2y2) const;
 
     void generateRandomSurface();
     void generateFlatSurface();
     void generateHeightMapSurface();
 
+    // the range of cells (inclusive) touched by a circle around position
+    void cellRange(glm::vec2 position, float radius, int& minX, int& maxX, int& minY, int& maxY) const;
+
     Type mType = Type::FLAT;
-    const double pi = 3.1415926536;
     int mDimX = 101;
     int mDimY = 101;
-    std::vector<std::vector<double>> mSupportPoints; // spacing between points is 10m
-    std::vector<Triangle> mTriangles;
-    std::vector<glm::vec3> mTriangleNormals;
+    Heightfield<float> mSupportPoints; // spacing between points is mScale
     double mMaxDeviationBetweenSupportPoints = 3.0;
     double mScale = 10.0;
-    Triangle mCurrentTriangle;
+    std::uint32_t mCurrentTriangle = 0;
+    bool mUsePlaneTable = false;
+    std::vector<Plane, AlignedAllocator<Plane>> mPlanes; // indexed like get()
+    const Plane* mPlaneTable = nullptr; // mPlanes or the baked file
+    MappedFile mBaked;
 
     std::array<GLfloat, 4> mat_specular =
                     { 1.0, 1.0, 1.0, 1.0 };
@@ -71,5 +192,12 @@ protected:
                     { 50.0 };
 
     Jpeg mHeightMap;
+
+    RenderMode mRenderMode = RenderMode::TILES;
+    LandscapeTiles mTiles;
+    HeightfieldSource mClipmapSource;
+    Clipmap mClipmap;
+    TiledHeightfield mTiled;
+    AlignedPtr<TilePrefetcher> mPrefetcher; // uses mTiled, holds cache line aligned queues
 };
 #endif
@@ -0,0 +1,190 @@
+#ifndef LANDSCAPEMESH_H
+#define LANDSCAPEMESH_H
+
+#include "Triangle.h"
+#include "Heightfield.h"
+
+#include "glm/vec3.hpp"
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+
+/**
+ @brief Read-only view of the triangle mesh spanned by a heightfield.
+        Every grid cell (x, y) is split along its diagonal into two triangles:
+        half 0 is the upper left one (x,y), (x+1,y+1), (x,y+1) and half 1 the
+        lower right one (x,y), (x+1,y), (x+1,y+1). Triangle i is half (i % 2)
+        of cell (i / 2) in row-major cell order. Nothing is stored; corners and
+        normals are derived from the heightfield on demand.
+        The view is invalidated when the underlying landscape is regenerated.
+ */
+class LandscapeMesh
+{
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Triangle value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Triangle* pointer;
+        typedef Triangle reference;
+
+        const_iterator(const LandscapeMesh* mesh, std::size_t index) :
+                        mMesh(mesh), mIndex(index)
+        {
+        }
+
+        Triangle operator*() const
+        {
+            return (*mMesh)[mIndex];
+        }
+
+        const_iterator& operator++()
+        {
+            ++mIndex;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++mIndex;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return mIndex == other.mIndex;
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return mIndex != other.mIndex;
+        }
+
+        std::size_t index() const
+        {
+            return mIndex;
+        }
+
+    private:
+        const LandscapeMesh* mMesh;
+        std::size_t mIndex;
+    };
+
+    LandscapeMesh(const Heightfield<float>& heights, float scale) :
+                    mHeights(&heights), mScale(scale)
+    {
+    }
+
+    int cellsX() const
+    {
+        return mHeights->sizeX() > 1 ? mHeights->sizeX() - 1 : 0;
+    }
+
+    int cellsY() const
+    {
+        return mHeights->sizeY() > 1 ? mHeights->sizeY() - 1 : 0;
+    }
+
+    std::size_t size() const
+    {
+        return static_cast<std::size_t>(cellsX()) * cellsY() * 2;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    std::size_t index(int cellX, int cellY, int half) const
+    {
+        return (static_cast<std::size_t>(cellX) * cellsY() + cellY) * 2 + half;
+    }
+
+    glm::vec3 corner(std::size_t index, int corner) const
+    {
+        int x, y, half;
+        cellOf(index, x, y, half);
+        const int cx = x + cornerOffsetX(half, corner);
+        const int cy = y + cornerOffsetY(half, corner);
+        return glm::vec3(cx * mScale, cy * mScale, (*mHeights)(cx, cy));
+    }
+
+    // the heights of the three corners of a triangle
+    glm::vec3 cornerHeights(std::size_t index) const
+    {
+        int x, y, half;
+        cellOf(index, x, y, half);
+        const Heightfield<float>& h = *mHeights;
+        return glm::vec3(h(x, y),
+                         h(x + 1, y + 1 - half),
+                         h(x + half, y + 1));
+    }
+
+    glm::vec3 normal(std::size_t index) const
+    {
+        int x, y, half;
+        cellOf(index, x, y, half);
+        const Heightfield<float>& h = *mHeights;
+        // closed form of cross(b - a, c - a) for the two halves, divided by mScale
+        glm::vec3 n;
+        if (half == 0)
+        {
+            n = glm::vec3(h(x, y + 1) - h(x + 1, y + 1), h(x, y) - h(x, y + 1), mScale);
+        }
+        else
+        {
+            n = glm::vec3(h(x, y) - h(x + 1, y), h(x + 1, y) - h(x + 1, y + 1), mScale);
+        }
+        return n / std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    }
+
+    Triangle operator[](std::size_t index) const
+    {
+        Triangle t;
+        for (int i = 0; i < 3; ++i)
+        {
+            t.setCorner(i, corner(index, i));
+        }
+        return t;
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+private:
+    // offsets of the corners of both halves, relative to the cell origin
+    static int cornerOffsetX(int half, int corner)
+    {
+        static const int dx[2][3] = { { 0, 1, 0 }, { 0, 1, 1 } };
+        return dx[half][corner];
+    }
+
+    static int cornerOffsetY(int half, int corner)
+    {
+        static const int dy[2][3] = { { 0, 1, 1 }, { 0, 0, 1 } };
+        return dy[half][corner];
+    }
+
+    void cellOf(std::size_t index, int& x, int& y, int& half) const
+    {
+        const std::size_t cell = index / 2;
+        half = static_cast<int>(index % 2);
+        x = static_cast<int>(cell / cellsY());
+        y = static_cast<int>(cell % cellsY());
+    }
+
+    const Heightfield<float>* mHeights;
+    float mScale;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "LandscapeTiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+LandscapeTiles::~LandscapeTiles()
+{
+    release();
+}
+
+void LandscapeTiles::reset(const Heightfield<float>* heights, float scale)
+{
+    release();
+    mHeights = heights;
+    mScale = scale;
+    mCellsX = heights && heights->sizeX() > 1 ? heights->sizeX() - 1 : 0;
+    mCellsY = heights && heights->sizeY() > 1 ? heights->sizeY() - 1 : 0;
+    mTiles.assign(tilesX() * tilesY(), Tile());
+    mTileData.clear();
+}
+
+void LandscapeTiles::setTileData(const std::vector<TileData>& tiles)
+{
+    mTileData = tiles;
+}
+
+const LandscapeTiles::TileData* LandscapeTiles::tileData(int tileX, int tileY) const
+{
+    return mTileData.empty() ? nullptr : &mTileData[tileX * tilesY() + tileY];
+}
+
+void LandscapeTiles::release()
+{
+    for (Tile& tile : mTiles)
+    {
+        if (tile.vertexBuffer != 0)
+        {
+            glDeleteBuffersARB(1, &tile.vertexBuffer);
+            glDeleteBuffersARB(1, &tile.indexBuffer);
+        }
+    }
+    mTiles.clear();
+    mUploadedTiles = 0;
+    mDrawnTiles = 0;
+}
+
+int LandscapeTiles::tilesX() const
+{
+    return (mCellsX + TileCells - 1) / TileCells;
+}
+
+int LandscapeTiles::tilesY() const
+{
+    return (mCellsY + TileCells - 1) / TileCells;
+}
+
+int LandscapeTiles::uploadedTiles() const
+{
+    return mUploadedTiles;
+}
+
+int LandscapeTiles::drawnTiles() const
+{
+    return mDrawnTiles;
+}
+
+glm::vec3 LandscapeTiles::vertexNormal(int x, int y) const
+{
+    // central differences, one sided at the border
+    const Heightfield<float>& h = *mHeights;
+    const int x0 = std::max(x - 1, 0);
+    const int x1 = std::min(x + 1, mCellsX);
+    const int y0 = std::max(y - 1, 0);
+    const int y1 = std::min(y + 1, mCellsY);
+    const glm::vec3 n((h(x0, y) - h(x1, y)) / (x1 - x0),
+                      (h(x, y0) - h(x, y1)) / (y1 - y0),
+                      mScale);
+    return n / std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+}
+
+void LandscapeTiles::buildTile(int tileX, int tileY, std::vector<Vertex>& vertices, std::vector<GLushort>& indices) const
+{
+    const int x0 = tileX * TileCells;
+    const int y0 = tileY * TileCells;
+    const int cellsX = std::min(TileCells, mCellsX - x0);
+    const int cellsY = std::min(TileCells, mCellsY - y0);
+    const int rowLength = cellsY + 1;
+
+    vertices.clear();
+    vertices.reserve((cellsX + 1) * rowLength);
+    for (int x = x0; x <= x0 + cellsX; ++x)
+    {
+        for (int y = y0; y <= y0 + cellsY; ++y)
+        {
+            Vertex vertex;
+            vertex.position = glm::vec3(x * mScale, y * mScale, (*mHeights)(x, y));
+            vertex.normal = vertexNormal(x, y);
+            vertex.texCoord = glm::vec2(x, y);
+            vertices.push_back(vertex);
+        }
+    }
+
+    indices.clear();
+    indices.reserve(cellsX * cellsY * 6);
+    for (int x = 0; x < cellsX; ++x)
+    {
+        for (int y = 0; y < cellsY; ++y)
+        {
+            const GLushort v00 = x * rowLength + y;
+            const GLushort v01 = v00 + 1;
+            const GLushort v10 = v00 + rowLength;
+            const GLushort v11 = v10 + 1;
+            // upper left half, then lower right half
+            indices.push_back(v00);
+            indices.push_back(v11);
+            indices.push_back(v01);
+            indices.push_back(v00);
+            indices.push_back(v10);
+            indices.push_back(v11);
+        }
+    }
+}
+
+void LandscapeTiles::upload(int tileX, int tileY, Tile& tile)
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLushort> indices;
+    TileData data;
+    if (const TileData* prepared = tileData(tileX, tileY))
+    {
+        data = *prepared;
+    }
+    else
+    {
+        buildTile(tileX, tileY, vertices, indices);
+        data.vertices = vertices.data();
+        data.vertexCount = vertices.size();
+        data.indices = indices.data();
+        data.indexCount = indices.size();
+    }
+
+    glGenBuffersARB(1, &tile.vertexBuffer);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, tile.vertexBuffer);
+    glBufferDataARB(GL_ARRAY_BUFFER_ARB, sizeof(Vertex) * data.vertexCount, data.vertices, GL_STATIC_DRAW_ARB);
+
+    glGenBuffersARB(1, &tile.indexBuffer);
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, tile.indexBuffer);
+    glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(GLushort) * data.indexCount, data.indices, GL_STATIC_DRAW_ARB);
+
+    tile.indexCount = data.indexCount;
+    mUploadedTiles++;
+}
+
+void LandscapeTiles::draw(glm::vec2 position, float radius)
+{
+    mDrawnTiles = 0;
+    if (mTiles.empty())
+    {
+        return;
+    }
+
+    const float tileSize = TileCells * mScale;
+    const int minX = std::max(0, (int) std::floor((position.x - radius) / tileSize));
+    const int maxX = std::min(tilesX() - 1, (int) std::floor((position.x + radius) / tileSize));
+    const int minY = std::max(0, (int) std::floor((position.y - radius) / tileSize));
+    const int maxY = std::min(tilesY() - 1, (int) std::floor((position.y + radius) / tileSize));
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            // skip tiles whose closest point is outside of the circle
+            const float dx = std::max(std::max(x * tileSize - position.x, 0.0f), position.x - (x + 1) * tileSize);
+            const float dy = std::max(std::max(y * tileSize - position.y, 0.0f), position.y - (y + 1) * tileSize);
+            if (radius * radius < dx * dx + dy * dy)
+                continue;
+
+            Tile& tile = mTiles[x * tilesY() + y];
+            if (tile.vertexBuffer == 0)
+            {
+                upload(x, y, tile);
+            }
+
+            glBindBufferARB(GL_ARRAY_BUFFER_ARB, tile.vertexBuffer);
+            glVertexPointer(3, GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, position)));
+            glNormalPointer(GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, normal)));
+            glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, texCoord)));
+
+            glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, tile.indexBuffer);
+            glDrawElements(GL_TRIANGLES, tile.indexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(0));
+            mDrawnTiles++;
+        }
+    }
+
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
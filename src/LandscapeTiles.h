@@ -0,0 +1,94 @@
+#ifndef LANDSCAPETILES_H
+#define LANDSCAPETILES_H
+
+#include "Heightfield.h"
+
+#include <GL/glut.h>
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include <vector>
+
+/**
+ @brief GPU copy of a landscape, split into tiles of TileCells x TileCells
+        cells. Every tile has its own vertex and index buffer, uploaded the
+        first time the tile is drawn and kept until the landscape changes.
+        The triangles are the ones of LandscapeMesh, with smooth per-vertex
+        normals and texture coordinates that repeat the texture once per cell.
+ */
+class LandscapeTiles
+{
+public:
+    static const int TileCells = 64;
+
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+
+    // the geometry of one tile, prepared elsewhere, see setTileData
+    struct TileData
+    {
+        const Vertex* vertices;
+        GLsizei vertexCount;
+        const GLushort* indices;
+        GLsizei indexCount;
+    };
+
+    LandscapeTiles() = default;
+    ~LandscapeTiles();
+    LandscapeTiles(const LandscapeTiles&) = delete;
+    LandscapeTiles& operator=(const LandscapeTiles&) = delete;
+
+    /* @brief use a new heightfield. Uploaded buffers are deleted, so a GL
+     * context has to be current if anything was drawn before.
+     */
+    void reset(const Heightfield<float>* heights, float scale);
+
+    /* @brief upload these tiles, indexed tileX * tilesY() + tileY, instead of
+     * building them from the heightfield. The memory has to stay valid until
+     * the next reset.
+     */
+    void setTileData(const std::vector<TileData>& tiles);
+    // the data passed to setTileData for a tile, or nullptr
+    const TileData* tileData(int tileX, int tileY) const;
+
+    // draw all tiles that intersect the circle around position
+    void draw(glm::vec2 position, float radius);
+
+    int tilesX() const;
+    int tilesY() const;
+    int uploadedTiles() const;
+    // the number of tiles issued by the last draw call
+    int drawnTiles() const;
+
+    /* @brief the geometry of one tile as it is uploaded: the vertices of its
+     * grid points, row by row, and three indices per triangle in the order
+     * of LandscapeMesh.
+     */
+    void buildTile(int tileX, int tileY, std::vector<Vertex>& vertices, std::vector<GLushort>& indices) const;
+
+private:
+    struct Tile
+    {
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        GLsizei indexCount = 0;
+    };
+
+    void upload(int tileX, int tileY, Tile& tile);
+    void release();
+    glm::vec3 vertexNormal(int x, int y) const;
+
+    const Heightfield<float>* mHeights = nullptr;
+    float mScale = 1.0f;
+    int mCellsX = 0;
+    int mCellsY = 0;
+    std::vector<Tile> mTiles;
+    std::vector<TileData> mTileData;
+    int mUploadedTiles = 0;
+    int mDrawnTiles = 0;
+};
+
+#endif
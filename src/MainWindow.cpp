@@ -10,13 +10,17 @@
 
 #include <iostream>
 
-constexpr auto EPSILON = (1e-8);
-
 #define DEBUG 0
 
+const float MainWindow::TrafficDrawRadius = 100.0f;
+
 MainWindow::MainWindow()
 {
     mRandomGenerator = new std::mt19937();
+    for (auto& pressed : mKeyPressState)
+    {
+        pressed = false;
+    }
 
     glClearColor(0.0, 0.0, 0.0, 0.0);
 	glShadeModel(GL_SMOOTH);
@@ -31,7 +35,7 @@ MainWindow::MainWindow()
     glEnable(GL_LIGHT0);
     glEnable(GL_DEPTH_TEST);
 
-    mLandscape.generate(Landscape::Type::FILE);
+    mSimulation.loadLandscape();
 
     Jpeg jpeg;
     jpeg.load("images/Textures/grass.jpg");
@@ -42,16 +46,38 @@ MainWindow::MainWindow()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, jpeg.width(), jpeg.height(), 0, GL_RGB, GL_UNSIGNED_BYTE, jpeg.data());
 
-    mTank.setPosition(glm::vec3(0, 0, 0));
+    mTank = mSimulation.addVehicle(glm::vec3(0, 0, 0));
+    // falls back to a draw call per vehicle
+    mTrafficInstances.setInstancingEnabled(true);
 
     mAnimationStart = Utils::clockTimeMs();
 }
 
 MainWindow::~MainWindow()
 {
+    // the thread still uses the simulation and the key states
+    mSimulationThread.reset();
     delete mRandomGenerator;
 }
 
+bool MainWindow::openTiledLandscape(const std::string& filename)
+{
+    // enough for the clipmap and the prefetched tiles around the tank
+    const std::size_t budget = 256 << 20;
+    return mSimulation.openTiledLandscape(filename, budget);
+}
+
+void MainWindow::addTraffic(std::size_t count)
+{
+    // 10 units apart, driving circles of different sizes, as in tools/Headless.cpp
+    const std::size_t columns = 32;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        mSimulation.traffic().add(glm::vec3(20.0f + (i % columns) * 10.0f, (i / columns) * 10.0f, 0.0f),
+                        (i * 37) % 360, 0.05f + (i % 7) * 0.01f, 0.1f + (i % 11) * 0.1f);
+    }
+}
+
 void MainWindow::reshape(int width, int height)
 {
     glViewport(0, 0, (GLsizei)width, (GLsizei)height);
@@ -61,10 +87,25 @@ void MainWindow::reshape(int width, int height)
     glMatrixMode(GL_MODELVIEW);
 }
 
+void MainWindow::startSimulation()
+{
+    using namespace std::placeholders;
+    // the model and its parts do not change, the poses come with the snapshots
+    mDrawnTank = mSimulation.vehicle(mTank);
+    mSimulationThread = makeAligned<SimulationThread>(mSimulation, std::bind(&MainWindow::applyKeyboardInput, this, _1, _2));
+    mSimulationThread->start();
+}
+
 void MainWindow::display()
 {
+    if (!mSimulationThread)
+    {
+        startSimulation();
+    }
+
     mFrame++;
     unsigned long start = Utils::clockTimeMs();
+    const unsigned long frameStart = Utils::clockTimeUs();
     //std::cout << "display" << std::endl;
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode (GL_MODELVIEW);
@@ -72,39 +113,23 @@ void MainWindow::display()
     glLightfv(GL_LIGHT0, GL_POSITION, &light_position[0]);
     //glColor3f(0.0f, 1.0, 0.0f);
 
-    // calculate new position of tank
-    glm::vec3 newPos = mTank.move();
-    mPosition.x = newPos.x;
-    mPosition.y = newPos.y;
-
-    // get landscape at new position
-    float height = 0;
-    glm::vec3 surfaceNormal;
-    mLandscape.getLocalEnvironment(mPosition.x, mPosition.y, height, surfaceNormal);
-
-    // adjust tank position
-    if (height > newPos.z)
-    {
-        newPos.z = std::max(height, newPos.z);
-        mTank.setPosition(newPos);
-    }
-
-    // adjust tank orientation according to surface normal if tank touches the ground
-    mIsTankOnGround = (fabs(height - newPos.z) < EPSILON);
-    if (mIsTankOnGround)
-    {
-        mTank.rotateToMatchSurfaceNormal(surfaceNormal);
-    }
+    // the tank between the last two ticks, so that it moves smoothly at any frame rate
+    const SimulationThread::Snapshot& snapshot = mSimulationThread->latest();
+    const float alpha = mSimulationThread->alpha(snapshot, frameStart);
+    const Simulation::Pose pose = Simulation::interpolate(snapshot.previous[mTank], snapshot.current[mTank], alpha);
+    const SimulationThread::Camera& camera = snapshot.camera;
+    mPosition.x = pose.position.x;
+    mPosition.y = pose.position.y;
 
     // camera position
-    glm::vec3 tankToCamera(-10.0, 0.0, mCameraHeight);
-    glm::quat rot = glm::angleAxis((mTank.yaw() + mCameraAngle) / 180.0f * pi / 2.0f, glm::vec3(0, 0, 1));
+    glm::vec3 tankToCamera(-10.0, 0.0, camera.height);
+    glm::quat rot = glm::angleAxis((pose.yaw + camera.angle) / 180.0f * pi / 2.0f, glm::vec3(0, 0, 1));
     tankToCamera = rot * tankToCamera * glm::conjugate(rot);
-    glm::vec3 cameraPos = mTank.position();
+    glm::vec3 cameraPos = pose.position;
     cameraPos += tankToCamera;
 
     glm::vec3 eye(cameraPos.x, cameraPos.y, cameraPos.z);
-    glm::vec3 center(mPosition.x, mPosition.y, mTank.position().z);
+    glm::vec3 center(mPosition.x, mPosition.y, pose.position.z);
     glm::vec3 up(0, 0, 1);
 
 #if DEBUG
@@ -119,17 +144,59 @@ void MainWindow::display()
 
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, mGrassTexture);
-    mLandscape.draw(mPosition, 100);
+    unsigned long landscapeStart = Utils::clockTimeUs();
+    Landscape& landscape = mSimulation.landscape();
+    landscape.setCurrentTriangle(snapshot.groundTriangle);
+    // the time to submit the landscape; bench/LandscapeDrawBench includes the rendering
+    landscape.draw(mPosition, 100);
+    mLandscapeDrawUs += Utils::clockTimeUs() - landscapeStart;
     glBindTexture(GL_TEXTURE_2D, 0);
     glDisable(GL_TEXTURE_2D);
 
-    mLandscape.drawNormals(mPosition, 0);
-    mTank.draw();
+    landscape.drawNormals(mPosition, 0);
+    mDrawnTank.draw(pose.position, pose.orientation, pose.wheelSpin, pose.steering);
+
+    // all AI vehicles share the model of the tank
+    const unsigned long trafficStart = Utils::clockTimeUs();
+    mTrafficInstances.begin(eye, TrafficDrawRadius, Tank::modelTransform());
+    for (const Simulation::Pose& vehicle : snapshot.traffic)
+    {
+        mTrafficInstances.add(vehicle.position, vehicle.orientation);
+    }
+    if (mDrawnTank.model())
+    {
+        mTrafficInstances.draw(*mDrawnTank.model());
+    }
+    mTrafficDrawUs += Utils::clockTimeUs() - trafficStart;
 
     unsigned long end = Utils::clockTimeMs();
+    mFrameUs += Utils::clockTimeUs() - frameStart;
     if (mFrame % 100 == 0)
     {
         std::cout << "FPS: " << 1000.0 / (end - start) << std::endl;
+        const char* modes[] = { "immediate", "tiles", "clipmap" };
+        std::cout << "Landscape (" << modes[(int) landscape.renderMode()] << "): " << mLandscapeDrawUs / 100 / 1000.0 << "ms/frame" << std::endl;
+        mLandscapeDrawUs = 0;
+        const VehicleInstances::Stats& traffic = mTrafficInstances.stats();
+        std::cout << "Traffic (" << (mTrafficInstances.isInstancingEnabled() ? "instanced" : "one by one") << "): "
+                  << traffic.drawn << " of " << traffic.vehicles << " vehicles in " << traffic.drawCalls << " draw calls, "
+                  << mTrafficDrawUs / 100 / 1000.0 << "ms/frame" << std::endl;
+        mTrafficDrawUs = 0;
+        // the two threads overlap if both together take longer than the frames
+        const unsigned long ticks = snapshot.tick - mLastTick;
+        std::cout << "Render thread: " << mFrameUs / 100 / 1000.0 << "ms/frame, simulation "
+                  << (mSimulationThread->isRunning() ? "thread" : "inline") << ": "
+                  << (ticks > 0 ? (snapshot.busyUs - mLastBusyUs) / ticks / 1000.0 : 0.0) << "ms/tick, "
+                  << ticks << " ticks, " << snapshot.droppedTicks << " dropped" << std::endl;
+        mFrameUs = 0;
+        mLastTick = snapshot.tick;
+        mLastBusyUs = snapshot.busyUs;
+        if (landscape.isTiled())
+        {
+            const TilePrefetcher::Stats stats = landscape.prefetchStats();
+            std::cout << "Prefetch: " << stats.hitRate() * 100.0 << "% hits, "
+                      << stats.misses << " stalls, " << stats.stallUs / 1000.0 << "ms stalled" << std::endl;
+        }
     }
     glFlush();
 }
@@ -143,132 +210,169 @@ void MainWindow::handleKeyboardUp(unsigned char key, int x, int y)
 {
     mKeyPressState[key] = false;
     std::cout << "up: " << key << std::endl;
+
+    if (key == 'r')
+    {
+        // switch between the render paths to compare their frame times
+        Landscape& landscape = mSimulation.landscape();
+        switch (landscape.renderMode())
+        {
+        case Landscape::RenderMode::IMMEDIATE:
+            landscape.setRenderMode(Landscape::RenderMode::TILES);
+            break;
+        case Landscape::RenderMode::TILES:
+            landscape.setRenderMode(Landscape::RenderMode::CLIPMAP);
+            break;
+        case Landscape::RenderMode::CLIPMAP:
+            landscape.setRenderMode(Landscape::RenderMode::IMMEDIATE);
+            break;
+        }
+        mLandscapeDrawUs = 0;
+    }
+    else if (key == 'n')
+    {
+        // compare the instanced traffic with a draw call per vehicle
+        mTrafficInstances.setInstancingEnabled(!mTrafficInstances.isInstancingEnabled());
+        mTrafficDrawUs = 0;
+    }
 }
 
 void MainWindow::idle()
 {
-    const unsigned long now = Utils::clockTimeMs();
-    if (now - mLastStepTimestamp > 16)
+    if (!mSimulationThread)
+    {
+        startSimulation();
+    }
+
+    // without its own thread, run the ticks that are due since the last frame
+    if (!mSimulationThread->isRunning())
     {
-        //std::cout << "step: " << mTank.position() << std::endl;
-        applyKeyboardInput();
-        glutPostRedisplay();
-        mLastStepTimestamp = now;
+        mSimulationThread->poll();
     }
+    glutPostRedisplay();
 }
 
-void MainWindow::applyKeyboardInput()
+void MainWindow::applyKeyboardInput(Simulation& simulation, SimulationThread::Camera& camera)
 {
     const double accelerationStep = 0.005;
     const double rotationStep = 0.6;
     const int stepSize = 2.0;
-    for (const auto& entry : mKeyPressState)
+    const float steeringAngle = 25.0f;
+    Tank& tank = simulation.vehicle(mTank);
+    const bool isTankOnGround = simulation.isOnGround(mTank);
+    float steering = 0.0f;
+    for (unsigned int key = 0; key < mKeyPressState.size(); ++key)
     {
-        if (entry.second)
+        if (mKeyPressState[key])
         {
-            if (entry.first == 'a' && mIsTankOnGround)
+            if (key == 'a' && isTankOnGround)
             {
                 //std::cout << "left" << std::endl;
-                float yaw = mTank.yaw();
+                float yaw = tank.yaw();
                 yaw += rotationStep;
-                mTank.setYaw(yaw);
+                tank.setYaw(yaw);
+                steering = steeringAngle;
             }
-            else if (entry.first == 'A' && mIsTankOnGround)
+            else if (key == 'A' && isTankOnGround)
             {
-                float yaw = mTank.yaw();
+                float yaw = tank.yaw();
                 yaw += rotationStep / 10.0f;
-                mTank.setYaw(yaw);
+                tank.setYaw(yaw);
+                steering = steeringAngle;
             }
-            else if (entry.first == 'd' && mIsTankOnGround)
+            else if (key == 'd' && isTankOnGround)
             {
                 //std::cout << "right" << std::endl;
-                float yaw = mTank.yaw();
+                float yaw = tank.yaw();
                 yaw -= rotationStep;
-                mTank.setYaw(yaw);
+                tank.setYaw(yaw);
+                steering = -steeringAngle;
             }
-            else if (entry.first == 'D' && mIsTankOnGround)
+            else if (key == 'D' && isTankOnGround)
             {
                 //std::cout << "right" << std::endl;
-                float yaw = mTank.yaw();
+                float yaw = tank.yaw();
                 yaw -= rotationStep / 10.0f;
-                mTank.setYaw(yaw);
+                tank.setYaw(yaw);
+                steering = -steeringAngle;
             }
-            else if (entry.first == 'w' && mIsTankOnGround)
+            else if (key == 'w' && isTankOnGround)
             {
                 //std::cout << "speed up" << std::endl;
-                mTank.accelerate(accelerationStep);
+                tank.accelerate(accelerationStep);
             }
-            else if (entry.first == 'W' && mIsTankOnGround)
+            else if (key == 'W' && isTankOnGround)
             {
                 //std::cout << "speed up" << std::endl;
-                mTank.accelerate(accelerationStep / 10.0f);
+                tank.accelerate(accelerationStep / 10.0f);
             }
-            else if (entry.first == 's' && mIsTankOnGround)
+            else if (key == 's' && isTankOnGround)
             {
                 //std::cout << "slow down" << std::endl;
-                mTank.accelerate(-accelerationStep);
+                tank.accelerate(-accelerationStep);
             }
-            else if (entry.first == 'S' && mIsTankOnGround)
+            else if (key == 'S' && isTankOnGround)
             {
                 //std::cout << "slow down" << std::endl;
-                mTank.accelerate(-accelerationStep / 10.0f);
+                tank.accelerate(-accelerationStep / 10.0f);
             }
-            else if (entry.first == 'j') // roll left
+            else if (key == 'j') // roll left
             {
                 //std::cout << "roll left" << std::endl;
-                float roll = mTank.roll();
+                float roll = tank.roll();
                 roll -= rotationStep;
-                mTank.setRoll(roll);
+                tank.setRoll(roll);
             }
-            else if (entry.first == 'l') // roll right
+            else if (key == 'l') // roll right
             {
                 //std::cout << "roll right" << std::endl;
-                float roll = mTank.roll();
+                float roll = tank.roll();
                 roll += rotationStep;
-                mTank.setRoll(roll);
+                tank.setRoll(roll);
             }
-            else if (entry.first == 'i') // pitch up
+            else if (key == 'i') // pitch up
             {
                 //std::cout << "pitch up" << std::endl;
-                float pitch = mTank.pitch();
+                float pitch = tank.pitch();
                 pitch += rotationStep;
-                mTank.setPitch(pitch);
+                tank.setPitch(pitch);
             }
-            else if (entry.first == 'k') // pitch down
+            else if (key == 'k') // pitch down
             {
                 //std::cout << "pitch down" << std::endl;
-                float pitch = mTank.pitch();
+                float pitch = tank.pitch();
                 pitch -= rotationStep;
-                mTank.setPitch(pitch);
+                tank.setPitch(pitch);
             }
-            else if (entry.first == 'u') // rotate camera
+            else if (key == 'u') // rotate camera
             {
-                mCameraAngle += 1.0f;
+                camera.angle += 1.0f;
             }
-            else if (entry.first == 'o') // rotate camera
+            else if (key == 'o') // rotate camera
             {
-                mCameraAngle -= 1.0f;
+                camera.angle -= 1.0f;
             }
-            else if (entry.first == '+')
+            else if (key == '+')
             {
                 //std::cout << "camera up" << std::endl;
-                mCameraHeight += 1.0;
+                camera.height += 1.0;
             }
-            else if (entry.first == '-')
+            else if (key == '-')
             {
                 //std::cout << "camera down" << std::endl;
-                mCameraHeight -= 1.0;
+                camera.height -= 1.0;
             }
-            else if (entry.first == ' ')
+            else if (key == ' ')
             {
-                mTank.stop();
+                tank.stop();
             }
-            else if (entry.first == '0')
+            else if (key == '0')
             {
-                mTank.setPitch(0.f);
-                mTank.setRoll(0.f);
-                mTank.setYaw(0.f);
+                tank.setPitch(0.f);
+                tank.setRoll(0.f);
+                tank.setYaw(0.f);
             }
         }
     }
+    tank.setSteering(steering);
 }
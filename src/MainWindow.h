@@ -1,12 +1,16 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "Landscape.h"
-#include "Tank.h"
+#include "Simulation.h"
+#include "SimulationThread.h"
+#include "VehicleInstances.h"
+#include "utils/AlignedAllocator.h"
 
 #include <GL/glut.h>
 #include "glm/vec2.hpp"
-#include <map>
+#include <array>
+#include <atomic>
+#include <memory>
 
 class MainWindow
 {
@@ -20,32 +24,39 @@ public:
     void handleKeyboardUp(unsigned char key, int x, int y);
     void idle();
 
+    // drive on a TiledHeightfield file instead of the generated landscape
+    bool openTiledLandscape(const std::string& filename);
+    // spawn AI vehicles in a grid next to the tank, before the first frame
+    void addTraffic(std::size_t count);
+
 private:
     void stepAnimation();
-    void applyKeyboardInput();
+    void startSimulation();
+    // on the simulation thread, before every tick
+    void applyKeyboardInput(Simulation& simulation, SimulationThread::Camera& camera);
 
     long unsigned int mAnimationStart = 0;
-    unsigned long mLastStepTimestamp = 0;
     double mProgress = 0.0;
 
-    Landscape mLandscape;
+    Simulation mSimulation;
+    // started with the first frame, after a tiled landscape may have been opened
+    AlignedPtr<SimulationThread> mSimulationThread; // holds a cache line aligned TripleBuffer
+    // a copy of the tank for its model, drawn at the poses of the snapshots
+    Tank mDrawnTank;
 
     glm::vec2 mPosition;
     //double mDirection; // 0..360 deg
-    double mCameraHeight = 5.0;
-    float mCameraAngle = 0.0;
 
     std::mt19937* mRandomGenerator;
 
     glm::vec2 mStartPosition = glm::vec2(0.0, 0.0);
     glm::vec2 mTargetPosition = glm::vec2(0.0, 100.0);
 
-    Tank mTank;
-    bool mIsTankOnGround = false;
+    // the vehicle driven by the keyboard
+    std::size_t mTank = 0;
 
-    typedef unsigned char Key;
-    typedef bool Pressed;
-    std::map<Key, Pressed> mKeyPressState;
+    // written by the GLUT callbacks, read on the simulation thread
+    std::array<std::atomic<bool>, 256> mKeyPressState;
 
     // light from up at infinity
     std::array<GLfloat, 4> light_position =
@@ -53,7 +64,18 @@ private:
 
     GLuint mGrassTexture;
 
+    // the AI vehicles within TrafficDrawRadius of the camera
+    static const float TrafficDrawRadius;
+    VehicleInstances mTrafficInstances;
+
     unsigned int mFrame = 0;
+    // time spent in Landscape::draw since the last FPS output
+    unsigned long mLandscapeDrawUs = 0;
+    unsigned long mTrafficDrawUs = 0;
+    // time spent in display() and in simulation ticks since then
+    unsigned long mFrameUs = 0;
+    unsigned long mLastTick = 0;
+    unsigned long mLastBusyUs = 0;
 };
 
 #endif
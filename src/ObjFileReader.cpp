@@ -6,12 +6,10 @@
  */
 
 #include "ObjFileReader.h"
-#include "Utils.h"
-#include "glm/vec2.hpp"
+#include "ObjParser.h"
+#include "utils/Parallel.h"
 #include "glm/vec3.hpp"
-#include <stdio.h>
-#include <iostream>
-#include <fstream>
+#include <algorithm>
 
 ObjFileReader::ObjFileReader()
 {
@@ -33,111 +31,65 @@ std::map<std::string, VertexObject> ObjFileReader::getObjects()
     }
 }
 
-bool ObjFileReader::loadFile(std::string filename, float scaleFactor)
+bool ObjFileReader::loadFile(std::string filename, float scaleFactor, unsigned int threads)
 {
     mLoadedFileSuccessfully = false;
     mObjects.clear();
 
-    std::vector < glm::vec3 > temp_vertices;
-    std::vector < glm::vec2 > temp_uvs;
-    std::vector < glm::vec3 > temp_normals;
-
-    VertexObject obj;
-    bool objIsValid = false;
-
-    std::ifstream infile(filename);
-    if (infile.good() == false)
+    ObjParser parser;
+    if (!parser.parseFile(filename, scaleFactor, threads))
     {
-        printf("Impossible to open the file !\n");
         return false;
     }
 
-    std::string line;
-    while (std::getline(infile, line))
+    // the last object of a name wins, as it always has; the map entries are
+    // made here, then filled in parallel
+    const std::vector<ObjParser::Object>& objects = parser.objects();
+    std::vector<VertexObject*> targets(objects.size(), nullptr);
+    for (std::size_t i = objects.size(); i-- > 0;)
     {
-        std::vector<std::string> words = Utils::split(line, ' ');
+        if (mObjects.count(objects[i].name) == 0)
+        {
+            VertexObject& obj = mObjects[objects[i].name];
+            obj.setName(objects[i].name);
+            targets[i] = &obj;
+        }
+    }
 
-        std::string lineHeader = words[0];
-        if (lineHeader == "o")
+    const std::vector<glm::vec3>& positions = parser.positions();
+    const std::vector<glm::vec3>& normals = parser.normals();
+    const std::vector<ObjParser::Corner>& corners = parser.corners();
+    const std::vector<ObjParser::Face>& faces = parser.faces();
+    // as many threads as the parse used, so small models stay on this one
+    const unsigned int workers = (unsigned int) std::min<std::size_t>(parser.chunkCount(), objects.size());
+    parallelFor(workers, [&](unsigned int worker)
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec3> faceNormals;
+        for (std::size_t k = worker; k < objects.size(); k += workers)
         {
-            if (objIsValid)
+            if (targets[k] == nullptr)
             {
-                mObjects[obj.getName()] = obj;
-                obj = VertexObject();
+                continue;
             }
-            objIsValid = true;
-        }
-        else if (lineHeader == "g")
-        {
-            obj.setName(words[1]);
-        }
-        else if (lineHeader == "v")
-        {
-            glm::vec3 vertex;
-            vertex.x = std::stof(words[1]);
-            vertex.y = std::stof(words[2]);
-            vertex.z = std::stof(words[3]);
-            temp_vertices.push_back(vertex * scaleFactor);
-        }
-        else if (lineHeader == "vt")
-        {
-            glm::vec2 uv;
-            uv.x = std::stof(words[1]);
-            uv.y = std::stof(words[2]);
-            temp_uvs.push_back(uv);
-        }
-        else if (lineHeader == "vn")
-        {
-            glm::vec3 normal;
-            normal.x = std::stof(words[1]);
-            normal.y = std::stof(words[2]);
-            normal.z = std::stof(words[3]);
-            temp_normals.push_back(normal);
-        }
-        else if (lineHeader == "f")
-        {
-            int vertexCounter = 0;
-            int matches = 0;
-            std::vector<unsigned int> vertexIndices;
-            std::vector<unsigned int> uvIndices;
-            std::vector<unsigned int> normalIndices;
-
-            int index = 0;
-            for (int i = 1; i < words.size(); ++i)
+            const ObjParser::Object& object = objects[k];
+            for (std::size_t i = object.firstFace; i < object.firstFace + object.faceCount; ++i)
             {
-                std::vector<std::string> indices = Utils::split(words[i], '/');
-                if (indices.size() > 2)
+                const ObjParser::Face& face = faces[i];
+                vertices.clear();
+                faceNormals.clear();
+                for (std::size_t j = face.firstCorner; j < face.firstCorner + face.cornerCount; ++j)
                 {
-                    unsigned int vertexIndex = indices[0].empty() ? 0 : std::stoi(indices[0]);
-                    unsigned int uvIndex = indices[1].empty() ? 0 : std::stoi(indices[1]);
-                    unsigned int normalIndex = indices[2].empty() ? 0 : std::stoi(indices[2]);
-
-                    vertexCounter++;
-                    vertexIndices.push_back(vertexIndex);
-                    uvIndices.push_back(uvIndex);
-                    normalIndices.push_back(normalIndex);
+                    vertices.push_back(positions[corners[j].position]);
+                    if (corners[j].normal >= 0)
+                    {
+                        faceNormals.push_back(normals[corners[j].normal]);
+                    }
                 }
-                index++;
-            }
-
-            std::vector<glm::vec3> vertices;
-            std::vector<glm::vec3> normals;
-            for (const auto& vertexIndex : vertexIndices)
-            {
-                vertices.push_back(temp_vertices[vertexIndex - 1]);
+                targets[k]->addFace(face.cornerCount, vertices, faceNormals);
             }
-            for (const auto& normalIndex : normalIndices)
-            {
-                normals.push_back(temp_normals[normalIndex - 1]);
-            }
-
-            obj.addFace(vertexCounter, vertices, normals);
         }
-    }
-    if (objIsValid)
-    {
-        mObjects[obj.getName()] = obj;
-    }
+    });
 
     mLoadedFileSuccessfully = true;
     return true;
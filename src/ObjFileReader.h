@@ -19,7 +19,8 @@ public:
     ObjFileReader();
     virtual ~ObjFileReader();
 
-    bool loadFile(std::string filename, float scaleFactor = 1.0);
+    // parse on up to threads threads, 0 uses one per core
+    bool loadFile(std::string filename, float scaleFactor = 1.0, unsigned int threads = 0);
 
     std::map<std::string, VertexObject> getObjects();
 
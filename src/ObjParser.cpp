@@ -0,0 +1,556 @@
+#include "ObjParser.h"
+#include "utils/MappedFile.h"
+#include "utils/Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+const std::size_t ObjParser::MinChunkBytes;
+
+namespace
+{
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    void skipSpaces(const char*& cursor, const char* end)
+    {
+        while (cursor < end && isSpace(*cursor))
+        {
+            ++cursor;
+        }
+    }
+
+    // the keyword or name at cursor, up to the next space
+    bool matches(const char* begin, const char* end, const char* word)
+    {
+        const std::size_t length = std::strlen(word);
+        return (std::size_t) (end - begin) == length && std::memcmp(begin, word, length) == 0;
+    }
+
+    const float FloatPowers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    const double DoublePowers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    /* mantissa * 10^exponent rounded to the nearest float, if that can be done
+     * exactly without strtof
+     */
+    bool fastFloat(std::uint64_t mantissa, int exponent, float& value)
+    {
+        // both factors are exact floats, so the one rounding is correct
+        if (mantissa <= (1u << 24) && exponent >= -10 && exponent <= 10)
+        {
+            value = exponent < 0 ? (float) mantissa / FloatPowers[-exponent] : (float) mantissa * FloatPowers[exponent];
+            return true;
+        }
+        if (mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+        {
+            return false;
+        }
+
+        // exact in double, then rounded again to float: that is only wrong if
+        // the double is exactly halfway between two floats
+        const double exact = exponent < 0 ? (double) mantissa / DoublePowers[-exponent] : (double) mantissa * DoublePowers[exponent];
+        if (exact != 0.0 && (exact < FLT_MIN || exact > FLT_MAX))
+        {
+            return false;
+        }
+        std::uint64_t bits;
+        std::memcpy(&bits, &exact, sizeof(bits));
+        const std::uint64_t dropped = bits & ((1ull << 29) - 1);
+        if (dropped == (1ull << 28))
+        {
+            return false;
+        }
+        value = (float) exact;
+        return true;
+    }
+}
+
+bool ObjParser::parseFloat(const char*& cursor, const char* end, float& value)
+{
+    const char* p = cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // up to 19 significant digits, the rest only counts for the exponent
+    const std::uint64_t mantissaLimit = 1000000000000000000ull;
+    std::uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool isTruncated = false;
+    for (; p < end && isDigit(*p); ++p)
+    {
+        hasDigits = true;
+        if (mantissa < mantissaLimit)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        else
+        {
+            exponent++;
+            isTruncated = isTruncated || *p != '0';
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && isDigit(*p); ++p)
+        {
+            hasDigits = true;
+            if (mantissa < mantissaLimit)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+            else
+            {
+                isTruncated = isTruncated || *p != '0';
+            }
+        }
+    }
+    if (!hasDigits)
+    {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if (e < end && (*e == '-' || *e == '+'))
+        {
+            negativeExponent = *e == '-';
+            ++e;
+        }
+        if (e < end && isDigit(*e))
+        {
+            int power = 0;
+            for (; e < end && isDigit(*e); ++e)
+            {
+                power = power < 100000 ? power * 10 + (*e - '0') : power;
+            }
+            exponent += negativeExponent ? -power : power;
+            p = e;
+        }
+    }
+
+    float magnitude;
+    if (isTruncated || !fastFloat(mantissa, exponent, magnitude))
+    {
+        // rare: too many digits, a large exponent or a tie, strtof rounds it
+        char digits[64];
+        const std::size_t length = p - cursor;
+        if (length < sizeof(digits))
+        {
+            std::memcpy(digits, cursor, length);
+            digits[length] = '\0';
+            value = std::strtof(digits, nullptr);
+        }
+        else
+        {
+            value = std::strtof(std::string(cursor, p).c_str(), nullptr);
+        }
+        cursor = p;
+        return true;
+    }
+    value = negative ? -magnitude : magnitude;
+    cursor = p;
+    return true;
+}
+
+bool ObjParser::parseInt(const char*& cursor, const char* end, int& value)
+{
+    const char* p = cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == end || !isDigit(*p))
+    {
+        return false;
+    }
+    long long number = 0;
+    for (; p < end && isDigit(*p); ++p)
+    {
+        number = number * 10 + (*p - '0');
+        if (number > INT_MAX)
+        {
+            return false;
+        }
+    }
+    value = (int) (negative ? -number : number);
+    cursor = p;
+    return true;
+}
+
+bool ObjParser::parseCorner(const char*& cursor, const char* end, Corner& corner) const
+{
+    // v, v/vt, v//vn or v/vt/vn, one-based or counting back from the end
+    int indices[3] = { 0, 0, 0 };
+    bool given[3] = { false, false, false };
+    const std::size_t counts[3] = { mBase.positions + mPositions.size(), mBase.texCoords + mTexCoords.size(),
+                                    mBase.normals + mNormals.size() };
+    int* resolved[3] = { &corner.position, &corner.texCoord, &corner.normal };
+    for (int slot = 0; slot < 3; ++slot)
+    {
+        if (slot > 0)
+        {
+            if (cursor == end || *cursor != '/')
+            {
+                break;
+            }
+            ++cursor;
+        }
+        given[slot] = parseInt(cursor, end, indices[slot]);
+        if (!given[slot] && slot == 0)
+        {
+            return false;
+        }
+    }
+    for (int slot = 0; slot < 3; ++slot)
+    {
+        // 0 is no index in OBJ, it is as much out of range as any other
+        const long long index = indices[slot] > 0 ? indices[slot] - 1 : (long long) counts[slot] + indices[slot];
+        if (!given[slot])
+        {
+            *resolved[slot] = -1;
+        }
+        else if (indices[slot] == 0 || index < 0 || index >= (long long) counts[slot])
+        {
+            return false;
+        }
+        else
+        {
+            *resolved[slot] = (int) index;
+        }
+    }
+    return cursor == end || isSpace(*cursor);
+}
+
+bool ObjParser::parse(const char* data, std::size_t size, float scaleFactor, unsigned int threads)
+{
+    clear();
+    const char* const end = data + size;
+
+    // every chunk starts at the beginning of a line
+    const unsigned int chunks = chunkCount(size, threads);
+    mChunkCount = chunks;
+    std::vector<const char*> bounds(chunks + 1, end);
+    bounds[0] = data;
+    for (unsigned int chunk = 1; chunk < chunks; ++chunk)
+    {
+        const char* split = std::max(data + size / chunks * chunk, bounds[chunk - 1]);
+        const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+        bounds[chunk] = newline != nullptr ? newline + 1 : end;
+    }
+
+    bool ok = true;
+    std::vector<ObjParser> parsers(chunks - 1);
+    if (chunks == 1)
+    {
+        ok = parseLines(data, end, scaleFactor, Counts());
+    }
+    else
+    {
+        std::vector<Counts> bases(chunks);
+        parallelFor(chunks, [&](unsigned int chunk)
+        {
+            bases[chunk] = countLines(bounds[chunk], bounds[chunk + 1]);
+        });
+        // from the counts of each chunk to those of all chunks before it
+        Counts base;
+        for (Counts& counts : bases)
+        {
+            const Counts chunk = counts;
+            counts = base;
+            base.lines += chunk.lines;
+            base.positions += chunk.positions;
+            base.texCoords += chunk.texCoords;
+            base.normals += chunk.normals;
+        }
+
+        std::vector<char> results(chunks, 0);
+        parallelFor(chunks, [&](unsigned int chunk)
+        {
+            ObjParser& parser = chunk == 0 ? *this : parsers[chunk - 1];
+            results[chunk] = parser.parseLines(bounds[chunk], bounds[chunk + 1], scaleFactor, bases[chunk]);
+        });
+        ok = std::find(results.begin(), results.end(), 0) == results.end();
+    }
+    if (!ok)
+    {
+        return false;
+    }
+
+    bool hasPendingName = false;
+    std::string pendingName;
+    adoptLeadingName(*this, 0, hasPendingName, pendingName);
+    for (const ObjParser& parser : parsers)
+    {
+        const std::size_t firstCorner = mCorners.size();
+        const std::size_t firstFace = mFaces.size();
+        const std::size_t objectsBefore = mObjects.size();
+        mPositions.insert(mPositions.end(), parser.mPositions.begin(), parser.mPositions.end());
+        mTexCoords.insert(mTexCoords.end(), parser.mTexCoords.begin(), parser.mTexCoords.end());
+        mNormals.insert(mNormals.end(), parser.mNormals.begin(), parser.mNormals.end());
+        // the corners already index the whole file
+        mCorners.insert(mCorners.end(), parser.mCorners.begin(), parser.mCorners.end());
+        for (Face face : parser.mFaces)
+        {
+            face.firstCorner += firstCorner;
+            mFaces.push_back(face);
+        }
+        for (Object object : parser.mObjects)
+        {
+            object.firstFace += firstFace;
+            mObjects.push_back(object);
+        }
+        adoptLeadingName(parser, objectsBefore, hasPendingName, pendingName);
+        mLineCount += parser.mLineCount;
+    }
+
+    for (std::size_t i = 0; i < mObjects.size(); ++i)
+    {
+        const std::size_t next = i + 1 < mObjects.size() ? mObjects[i + 1].firstFace : mFaces.size();
+        mObjects[i].faceCount = next - mObjects[i].firstFace;
+    }
+    return true;
+}
+
+bool ObjParser::parseLines(const char* begin, const char* end, float scaleFactor, const Counts& base)
+{
+    mBase = base;
+    const char* cursor = begin;
+    while (cursor < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        lineEnd = lineEnd != nullptr ? lineEnd : end;
+        mLineCount++;
+
+        skipSpaces(cursor, lineEnd);
+        const char* keyword = cursor;
+        while (cursor < lineEnd && !isSpace(*cursor))
+        {
+            ++cursor;
+        }
+        const char* keywordEnd = cursor;
+
+        bool ok = true;
+        if (matches(keyword, keywordEnd, "v") || matches(keyword, keywordEnd, "vn"))
+        {
+            glm::vec3 vector;
+            for (int i = 0; i < 3 && ok; ++i)
+            {
+                skipSpaces(cursor, lineEnd);
+                ok = parseFloat(cursor, lineEnd, vector[i]);
+            }
+            if (keywordEnd - keyword == 1)
+            {
+                mPositions.push_back(vector * scaleFactor);
+            }
+            else
+            {
+                mNormals.push_back(vector);
+            }
+        }
+        else if (matches(keyword, keywordEnd, "vt"))
+        {
+            glm::vec2 uv;
+            for (int i = 0; i < 2 && ok; ++i)
+            {
+                skipSpaces(cursor, lineEnd);
+                ok = parseFloat(cursor, lineEnd, uv[i]);
+            }
+            mTexCoords.push_back(uv);
+        }
+        else if (matches(keyword, keywordEnd, "f"))
+        {
+            Face face = { mCorners.size(), 0 };
+            for (skipSpaces(cursor, lineEnd); ok && cursor < lineEnd; skipSpaces(cursor, lineEnd))
+            {
+                Corner corner;
+                ok = parseCorner(cursor, lineEnd, corner);
+                mCorners.push_back(corner);
+                face.cornerCount++;
+            }
+            // every corner has a normal or none has, so that they line up with the vertices
+            for (std::size_t i = face.firstCorner + 1; ok && i < mCorners.size(); ++i)
+            {
+                ok = (mCorners[i].normal < 0) == (mCorners[face.firstCorner].normal < 0);
+            }
+            mFaces.push_back(face);
+        }
+        else if (matches(keyword, keywordEnd, "o"))
+        {
+            // the face counts follow when all chunks are in
+            mObjects.push_back({ std::string(), mFaces.size(), 0 });
+        }
+        else if (matches(keyword, keywordEnd, "g"))
+        {
+            skipSpaces(cursor, lineEnd);
+            const char* name = cursor;
+            while (cursor < lineEnd && !isSpace(*cursor))
+            {
+                ++cursor;
+            }
+            if (mObjects.empty())
+            {
+                mHasLeadingName = true;
+                mLeadingName.assign(name, cursor);
+            }
+            else
+            {
+                mObjects.back().name.assign(name, cursor);
+            }
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Malformed OBJ line " << mBase.lines + mLineCount << ": "
+                      << std::string(keyword, lineEnd - keyword) << std::endl;
+            return false;
+        }
+        cursor = lineEnd + 1;
+    }
+    return true;
+}
+
+ObjParser::Counts ObjParser::countLines(const char* begin, const char* end)
+{
+    Counts counts;
+    const char* cursor = begin;
+    while (cursor < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        lineEnd = lineEnd != nullptr ? lineEnd : end;
+        counts.lines++;
+
+        skipSpaces(cursor, lineEnd);
+        if (cursor < lineEnd && *cursor == 'v')
+        {
+            const char* keywordEnd = cursor;
+            while (keywordEnd < lineEnd && !isSpace(*keywordEnd))
+            {
+                ++keywordEnd;
+            }
+            counts.positions += matches(cursor, keywordEnd, "v") ? 1 : 0;
+            counts.texCoords += matches(cursor, keywordEnd, "vt") ? 1 : 0;
+            counts.normals += matches(cursor, keywordEnd, "vn") ? 1 : 0;
+        }
+        cursor = lineEnd + 1;
+    }
+    return counts;
+}
+
+void ObjParser::adoptLeadingName(const ObjParser& chunk, std::size_t objectsBefore, bool& hasPendingName, std::string& pendingName)
+{
+    if (chunk.mHasLeadingName)
+    {
+        if (objectsBefore > 0)
+        {
+            mObjects[objectsBefore - 1].name = chunk.mLeadingName;
+        }
+        else
+        {
+            hasPendingName = true;
+            pendingName = chunk.mLeadingName;
+        }
+    }
+    if (objectsBefore == 0 && !mObjects.empty())
+    {
+        // the faces before the first object belong to it
+        mObjects[0].firstFace = 0;
+        if (hasPendingName && mObjects[0].name.empty())
+        {
+            mObjects[0].name = pendingName;
+        }
+        hasPendingName = false;
+    }
+}
+
+unsigned int ObjParser::chunkCount(std::size_t size, unsigned int threads)
+{
+    return (unsigned int) std::max<std::size_t>(1, std::min<std::size_t>(threadsFor(threads), size / MinChunkBytes));
+}
+
+bool ObjParser::parseFile(const std::string& filename, float scaleFactor, unsigned int threads)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        std::cerr << "Impossible to open " << filename << std::endl;
+        return false;
+    }
+    return parse(file.data(), file.size(), scaleFactor, threads);
+}
+
+void ObjParser::clear()
+{
+    mPositions.clear();
+    mTexCoords.clear();
+    mNormals.clear();
+    mCorners.clear();
+    mFaces.clear();
+    mObjects.clear();
+    mLineCount = 0;
+    mChunkCount = 1;
+    mBase = Counts();
+    mHasLeadingName = false;
+    mLeadingName.clear();
+}
+
+const std::vector<glm::vec3>& ObjParser::positions() const
+{
+    return mPositions;
+}
+
+const std::vector<glm::vec2>& ObjParser::texCoords() const
+{
+    return mTexCoords;
+}
+
+const std::vector<glm::vec3>& ObjParser::normals() const
+{
+    return mNormals;
+}
+
+const std::vector<ObjParser::Corner>& ObjParser::corners() const
+{
+    return mCorners;
+}
+
+const std::vector<ObjParser::Face>& ObjParser::faces() const
+{
+    return mFaces;
+}
+
+const std::vector<ObjParser::Object>& ObjParser::objects() const
+{
+    return mObjects;
+}
+
+std::size_t ObjParser::lineCount() const
+{
+    return mLineCount;
+}
+
+unsigned int ObjParser::chunkCount() const
+{
+    return mChunkCount;
+}
@@ -0,0 +1,120 @@
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ @brief Parses an OBJ file in place, e.g. from a MappedFile: lines are
+        scanned between pointers into the buffer and numbers are converted
+        without copying them, so nothing is allocated per line; the output
+        arrays only grow, and keep their capacity from one parse to the
+        next. Faces are flat ranges of corners, objects ranges of faces.
+        Objects start at 'o' lines and are named by the following 'g' line,
+        as ObjFileReader has always read them. Indices are zero-based,
+        negative ones in the file count back from the last vertex, -1 here
+        means not given.
+        Floats are rounded as by std::strtof, as std::stof did.
+        Unlike the line by line reader before it, 'v' and 'vn' lines need
+        three numbers and 'vt' lines two, corners without a normal (v and
+        v/vt) are kept instead of dropped from their face, and a face must
+        give a normal for all of its corners or for none.
+        Large files are split at line boundaries into chunks that are parsed
+        on threads of their own: a first pass counts the vertices of every
+        chunk, so that indices are resolved to the whole file while parsing,
+        and the chunks are then appended in order. The result is the same
+        for any number of threads.
+ */
+class ObjParser
+{
+public:
+    struct Corner
+    {
+        int position;
+        int texCoord;
+        int normal;
+    };
+
+    struct Face
+    {
+        std::size_t firstCorner;
+        unsigned int cornerCount;
+    };
+
+    struct Object
+    {
+        std::string name;
+        std::size_t firstFace;
+        std::size_t faceCount;
+    };
+
+    // chunks are at least that large, smaller files are not worth a thread
+    static const std::size_t MinChunkBytes = 1 << 20;
+
+    /* @brief parse size bytes, with all positions multiplied by scaleFactor,
+     * on up to threads threads; 0 uses one thread per core. Returns false
+     * and reports the line on malformed numbers or indices out of range.
+     */
+    bool parse(const char* data, std::size_t size, float scaleFactor = 1.0f, unsigned int threads = 0);
+    // map the file and parse it
+    bool parseFile(const std::string& filename, float scaleFactor = 1.0f, unsigned int threads = 0);
+    void clear();
+
+    // the number of chunks parse splits that many bytes into
+    static unsigned int chunkCount(std::size_t size, unsigned int threads);
+
+    const std::vector<glm::vec3>& positions() const;
+    const std::vector<glm::vec2>& texCoords() const;
+    const std::vector<glm::vec3>& normals() const;
+    const std::vector<Corner>& corners() const;
+    const std::vector<Face>& faces() const;
+    const std::vector<Object>& objects() const;
+    // the number of lines of the last parse
+    std::size_t lineCount() const;
+    // the number of chunks the last parse was split into, 1 for small files
+    unsigned int chunkCount() const;
+
+    /* @brief a decimal number with optional sign, fraction and exponent at
+     * cursor, which is moved past it. Returns false if there is none.
+     */
+    static bool parseFloat(const char*& cursor, const char* end, float& value);
+    static bool parseInt(const char*& cursor, const char* end, int& value);
+
+private:
+    // lines and vertex attributes in a part of the file
+    struct Counts
+    {
+        std::size_t lines = 0;
+        std::size_t positions = 0;
+        std::size_t texCoords = 0;
+        std::size_t normals = 0;
+    };
+
+    static Counts countLines(const char* begin, const char* end);
+    // parse the lines of a chunk that follows base lines and attributes
+    bool parseLines(const char* begin, const char* end, float scaleFactor, const Counts& base);
+    bool parseCorner(const char*& cursor, const char* end, Corner& corner) const;
+    /* @brief the name of a 'g' line before the first 'o' of chunk goes to the
+     * last object before it, or if there is none, to the first object
+     */
+    void adoptLeadingName(const ObjParser& chunk, std::size_t objectsBefore, bool& hasPendingName, std::string& pendingName);
+
+    std::vector<glm::vec3> mPositions;
+    std::vector<glm::vec2> mTexCoords;
+    std::vector<glm::vec3> mNormals;
+    std::vector<Corner> mCorners;
+    std::vector<Face> mFaces;
+    std::vector<Object> mObjects;
+    std::size_t mLineCount = 0;
+    unsigned int mChunkCount = 1;
+
+    // of the chunk being parsed
+    Counts mBase;
+    bool mHasLeadingName = false;
+    std::string mLeadingName;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "Simulation.h"
+#include "Utils.h"
+
+#include <cmath>
+#include <iostream>
+
+constexpr auto EPSILON = (1e-8);
+
+const unsigned int Simulation::TicksPerSecond;
+
+void Simulation::loadLandscape(const std::string& bakedFile)
+{
+    const unsigned long landscapeStart = Utils::clockTimeMs();
+    if (!mLandscape.loadBaked(bakedFile))
+    {
+        mLandscape.generate(Landscape::Type::FILE);
+    }
+    std::cout << "Landscape " << (mLandscape.isBaked() ? "mapped" : "generated") << " in "
+              << Utils::clockTimeMs() - landscapeStart << "ms" << std::endl;
+}
+
+bool Simulation::openTiledLandscape(const std::string& filename, std::size_t budgetBytes)
+{
+    return mLandscape.openTiled(filename, budgetBytes);
+}
+
+Landscape& Simulation::landscape()
+{
+    return mLandscape;
+}
+
+const Landscape& Simulation::landscape() const
+{
+    return mLandscape;
+}
+
+std::size_t Simulation::addVehicle(const glm::vec3& position)
+{
+    mVehicles.emplace_back();
+    mVehicles.back().setPosition(position);
+    mOnGround.push_back(false);
+    mPreviousPoses.push_back(currentPose(mVehicles.back()));
+    return mVehicles.size() - 1;
+}
+
+std::size_t Simulation::vehicleCount() const
+{
+    return mVehicles.size();
+}
+
+Tank& Simulation::vehicle(std::size_t index)
+{
+    return mVehicles[index];
+}
+
+const Tank& Simulation::vehicle(std::size_t index) const
+{
+    return mVehicles[index];
+}
+
+VehicleSystem& Simulation::traffic()
+{
+    return mTraffic;
+}
+
+const VehicleSystem& Simulation::traffic() const
+{
+    return mTraffic;
+}
+
+bool Simulation::isOnGround(std::size_t index) const
+{
+    return mOnGround[index];
+}
+
+void Simulation::step()
+{
+    for (std::size_t i = 0; i < mVehicles.size(); ++i)
+    {
+        Tank& tank = mVehicles[i];
+        mPreviousPoses[i] = currentPose(tank);
+
+        // calculate new position of tank
+        glm::vec3 newPos = tank.move();
+        if (i == 0)
+        {
+            mLandscape.prefetch(newPos, tank.velocity(), tank.yaw());
+        }
+
+        // get landscape at new position
+        float height = 0;
+        glm::vec3 surfaceNormal;
+        std::uint32_t triangle;
+        mLandscape.getLocalEnvironment(newPos.x, newPos.y, height, surfaceNormal, triangle);
+        if (i == 0)
+        {
+            mGroundTriangle = triangle;
+        }
+
+        // adjust tank position
+        if (height > newPos.z)
+        {
+            newPos.z = height;
+            tank.setPosition(newPos);
+        }
+
+        // adjust tank orientation according to surface normal if tank touches the ground
+        mOnGround[i] = (fabs(height - newPos.z) < EPSILON);
+        if (mOnGround[i])
+        {
+            tank.rotateToMatchSurfaceNormal(surfaceNormal);
+        }
+    }
+    mTraffic.step(mLandscape);
+    mTick++;
+}
+
+Simulation::Pose Simulation::pose(std::size_t index, float alpha) const
+{
+    const Tank& tank = mVehicles[index];
+    return interpolate(mPreviousPoses[index], currentPose(tank), alpha);
+}
+
+Simulation::Pose Simulation::interpolate(const Pose& from, const Pose& to, float alpha)
+{
+    Pose pose;
+    pose.position = from.position + (to.position - from.position) * alpha;
+    pose.orientation = glm::slerp(from.orientation, to.orientation, alpha);
+    // the short way round where the wheel angle wraps at 360
+    float spin = to.wheelSpin - from.wheelSpin;
+    spin -= spin > 180.0f ? 360.0f : (spin < -180.0f ? -360.0f : 0.0f);
+    pose.wheelSpin = from.wheelSpin + spin * alpha;
+    pose.steering = from.steering + (to.steering - from.steering) * alpha;
+    float yaw = to.yaw - from.yaw;
+    yaw -= yaw > 180.0f ? 360.0f : (yaw < -180.0f ? -360.0f : 0.0f);
+    pose.yaw = from.yaw + yaw * alpha;
+    return pose;
+}
+
+Simulation::Pose Simulation::currentPose(const Tank& tank)
+{
+    return { tank.position(), tank.orientation(), tank.wheelSpin(), tank.steering(), tank.yaw() };
+}
+
+std::uint32_t Simulation::groundTriangle() const
+{
+    return mGroundTriangle;
+}
+
+unsigned long Simulation::tick() const
+{
+    return mTick;
+}
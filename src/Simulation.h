@@ -0,0 +1,97 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "Landscape.h"
+#include "Tank.h"
+#include "VehicleSystem.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ @brief The simulated world: the landscape and the vehicles driving on it,
+        the tanks and any number of simple AI vehicles in a VehicleSystem.
+        step() moves every vehicle, puts it onto the ground and aligns it
+        with the surface below. Nothing here makes GL calls, so a simulation
+        can run without a window or GL context, see tools/Headless.cpp.
+        MainWindow steps its simulation at TicksPerSecond on its own thread,
+        see SimulationThread. step() only reads the landscape, so that it
+        can be drawn at the same time. The reads of a tiled landscape also
+        fill its tile cache, which TiledHeightfield guards with a lock.
+ */
+class Simulation
+{
+public:
+    // the rate step() is run at; velocities and gravity are per tick
+    static const unsigned int TicksPerSecond = 60;
+
+    struct Pose
+    {
+        glm::vec3 position;
+        glm::quat orientation;
+        // of the wheels, in degrees, see Tank::draw
+        float wheelSpin;
+        float steering;
+        // in degrees, see Tank::yaw; the camera follows it
+        float yaw;
+    };
+
+    Simulation() = default;
+    ~Simulation() = default;
+
+    /* @brief map the baked landscape, or generate it from the heightmap if
+     * there is no baked file, see terrainbake.
+     */
+    void loadLandscape(const std::string& bakedFile = Landscape::BakedHeightmap);
+
+    // drive on a TiledHeightfield file instead
+    bool openTiledLandscape(const std::string& filename, std::size_t budgetBytes);
+
+    Landscape& landscape();
+    const Landscape& landscape() const;
+
+    /* @brief add a vehicle and return its index. References returned by
+     * vehicle() are invalidated by adding further vehicles. The landscape
+     * prefetches its tiles around vehicle 0.
+     */
+    std::size_t addVehicle(const glm::vec3& position);
+    std::size_t vehicleCount() const;
+    Tank& vehicle(std::size_t index);
+    const Tank& vehicle(std::size_t index) const;
+
+    // the AI vehicles, stepped after the tanks
+    VehicleSystem& traffic();
+    const VehicleSystem& traffic() const;
+
+    // whether the vehicle touched the ground in the last step
+    bool isOnGround(std::size_t index) const;
+
+    void step();
+
+    /* @brief the pose of a vehicle alpha of the way from the one before the
+     * last step (0) to the one after it (1).
+     */
+    Pose pose(std::size_t index, float alpha) const;
+    static Pose interpolate(const Pose& from, const Pose& to, float alpha);
+    // the pose of a tank after the last step
+    static Pose currentPose(const Tank& tank);
+
+    // the index of the triangle below vehicle 0 after the last step, see Landscape::triangle
+    std::uint32_t groundTriangle() const;
+
+    // steps taken since the simulation was created
+    unsigned long tick() const;
+
+private:
+    Landscape mLandscape;
+    std::vector<Tank> mVehicles;
+    VehicleSystem mTraffic;
+    std::vector<bool> mOnGround;
+    // the poses before the last step
+    std::vector<Pose> mPreviousPoses;
+    std::uint32_t mGroundTriangle = 0;
+    unsigned long mTick = 0;
+};
+
+#endif
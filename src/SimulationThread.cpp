@@ -0,0 +1,126 @@
+#include "SimulationThread.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+
+SimulationThread::SimulationThread(Simulation& simulation, Input input, unsigned long tickUs, unsigned int maxTicks) :
+                mSimulation(simulation),
+                mInput(input),
+                mTimestep(tickUs, maxTicks)
+{
+    // the state before the first tick
+    publish(Utils::clockTimeUs());
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start()
+{
+    if (!mRunning)
+    {
+        mRunning = true;
+        mThread = std::thread(&SimulationThread::run, this);
+    }
+}
+
+void SimulationThread::stop()
+{
+    mRunning = false;
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+bool SimulationThread::isRunning() const
+{
+    return mRunning;
+}
+
+void SimulationThread::poll()
+{
+    runDueTicks(Utils::clockTimeUs());
+}
+
+const SimulationThread::Snapshot& SimulationThread::latest()
+{
+    mSnapshots.update();
+    return mSnapshots.front();
+}
+
+float SimulationThread::alpha(const Snapshot& snapshot, unsigned long nowUs) const
+{
+    if (nowUs <= snapshot.tickTimeUs)
+    {
+        return 0.0f;
+    }
+    return std::min((nowUs - snapshot.tickTimeUs) / (float) mTimestep.tickUs(), 1.0f);
+}
+
+void SimulationThread::run()
+{
+    while (mRunning)
+    {
+        runDueTicks(Utils::clockTimeUs());
+
+        // sleep until the next tick is due
+        const float remaining = 1.0f - mTimestep.alpha();
+        std::this_thread::sleep_for(std::chrono::microseconds((long) (remaining * mTimestep.tickUs()) + 1));
+    }
+}
+
+unsigned int SimulationThread::runDueTicks(unsigned long nowUs)
+{
+    const unsigned int ticks = mTimestep.update(nowUs);
+    for (unsigned int i = 0; i < ticks; ++i)
+    {
+        const unsigned long start = Utils::clockTimeUs();
+        if (mInput)
+        {
+            mInput(mSimulation, mCamera);
+        }
+        mSimulation.step();
+        mLastTickUs = Utils::clockTimeUs() - start;
+        mBusyUs += mLastTickUs;
+    }
+    if (ticks > 0)
+    {
+        publish(nowUs);
+    }
+    return ticks;
+}
+
+void SimulationThread::publish(unsigned long nowUs)
+{
+    Snapshot& snapshot = mSnapshots.back();
+    snapshot.tick = mSimulation.tick();
+    snapshot.tickTimeUs = nowUs - (unsigned long) (mTimestep.alpha() * mTimestep.tickUs());
+
+    // the vectors of the slot keep their capacity, so this does not allocate
+    const std::size_t vehicles = mSimulation.vehicleCount();
+    snapshot.previous.resize(vehicles);
+    snapshot.current.resize(vehicles);
+    for (std::size_t i = 0; i < vehicles; ++i)
+    {
+        snapshot.previous[i] = mSimulation.pose(i, 0.0f);
+        snapshot.current[i] = mSimulation.pose(i, 1.0f);
+    }
+    const VehicleSystem& traffic = mSimulation.traffic();
+    snapshot.traffic.resize(traffic.size());
+    for (std::size_t i = 0; i < traffic.size(); ++i)
+    {
+        snapshot.traffic[i] = { traffic.position(i), traffic.orientation(i), 0.0f, 0.0f, 0.0f };
+    }
+    snapshot.isOnGround = vehicles > 0 && mSimulation.isOnGround(0);
+    snapshot.groundTriangle = mSimulation.groundTriangle();
+    snapshot.camera = mCamera;
+
+    snapshot.lastTickUs = mLastTickUs;
+    snapshot.busyUs = mBusyUs;
+    snapshot.droppedTicks = mTimestep.droppedTicks();
+    mSnapshots.publish();
+}
@@ -0,0 +1,91 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include "Simulation.h"
+#include "FixedTimestep.h"
+#include "utils/TripleBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ @brief Runs a Simulation at its fixed tick rate on a thread of its own, so
+        that slow frames do not hold up the physics and the other way round.
+        After every batch of ticks the thread publishes a snapshot of what
+        the renderer needs through a TripleBuffer; the render thread reads
+        only the latest snapshot and never touches the simulation. Input is
+        applied on the simulation thread by a callback before every tick.
+        A simulation that must not be drawn at the same time can be run by
+        poll() on the render thread instead.
+ */
+class SimulationThread
+{
+public:
+    struct Camera
+    {
+        float height = 5.0f;
+        float angle = 0.0f; // around the vehicle, in degrees
+    };
+
+    struct Snapshot
+    {
+        unsigned long tick = 0;
+        // Utils::clockTimeUs the state of tick belongs to
+        unsigned long tickTimeUs = 0;
+        // all vehicles before and after the last tick
+        std::vector<Simulation::Pose> previous;
+        std::vector<Simulation::Pose> current;
+        // the AI vehicles after the last tick, not interpolated
+        std::vector<Simulation::Pose> traffic;
+        // vehicle 0, which the camera follows
+        bool isOnGround = false;
+        std::uint32_t groundTriangle = 0;
+        Camera camera;
+
+        // timings of the simulation thread
+        unsigned long lastTickUs = 0;
+        unsigned long busyUs = 0; // in all ticks so far
+        unsigned long droppedTicks = 0;
+    };
+
+    // called on the simulation thread before every tick
+    typedef std::function<void(Simulation& simulation, Camera& camera)> Input;
+
+    SimulationThread(Simulation& simulation, Input input,
+                    unsigned long tickUs = 1000000 / Simulation::TicksPerSecond, unsigned int maxTicks = 5);
+    ~SimulationThread();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // without a thread: run the ticks that are due on the calling thread
+    void poll();
+
+    // render thread only: the latest published snapshot
+    const Snapshot& latest();
+    // progress of the time nowUs into the tick after snapshot, in [0, 1]
+    float alpha(const Snapshot& snapshot, unsigned long nowUs) const;
+
+private:
+    void run();
+    // returns the number of ticks run
+    unsigned int runDueTicks(unsigned long nowUs);
+    void publish(unsigned long nowUs);
+
+    Simulation& mSimulation;
+    Input mInput;
+    FixedTimestep mTimestep;
+    Camera mCamera;
+    unsigned long mLastTickUs = 0;
+    unsigned long mBusyUs = 0;
+
+    TripleBuffer<Snapshot> mSnapshots;
+    std::atomic<bool> mRunning { false };
+    std::thread mThread;
+};
+
+#endif
@@ -1,7 +1,6 @@
 #include "Tank.h"
 #include "Constants.h"
 #include "Utils.h"
-#include "ObjFileReader.h"
 #include <glu.h>
 #include <GL/glut.h>
 #include "glm/mat4x4.hpp"
@@ -11,7 +10,6 @@
 #include <glm/gtx/transform.hpp>
 
 #include <iostream>
-#include <array>
 
 #define DEBUG 0
 
@@ -19,12 +17,20 @@ Tank::Tank()
 {
     mPosition = glm::vec3(0.0, 0.0, 0.0);
 
-    ObjFileReader rdr;
-    bool ret = rdr.loadFile("./Vehicle.obj", 0.005);
-    if (ret)
+    mModel = AssetCache::instance().loadVehicleMesh("./Vehicle.obj", 0.005);
+    mWheels.fill(-1);
+    if (mModel)
     {
-        mObjects = rdr.getObjects();
-        mModelLoaded = true;
+        mChassis = mModel->partIndex("Chassis");
+        const char* wheels[] = { "Wheel_FL", "Wheel_FR", "Wheel_BL", "Wheel_BR" };
+        for (std::size_t i = 0; i < mWheels.size(); ++i)
+        {
+            mWheels[i] = mModel->partIndex(wheels[i]);
+        }
+        if (mWheels[0] >= 0)
+        {
+            mWheelRadius = mModel->parts()[mWheels[0]].radius;
+        }
     }
 }
 
@@ -34,26 +40,38 @@ glm::vec3 Tank::move()
     glm::quat direction = rot * glm::quat(0, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::inverse(rot);
     mPosition = mPosition + glm::axis(direction) * mVelocity;
     mPosition.z -= 0.1; // apply gravity
+
+    // roll the wheels along
+    float wheelSpin = mWheelSpin + mVelocity / mWheelRadius / pi * 180.0f;
+    while (wheelSpin >= 360.f)
+        wheelSpin -= 360.f;
+    while (wheelSpin < 0.f)
+        wheelSpin += 360.f;
+    mWheelSpin = wheelSpin;
     return mPosition;
 }
 
-void Tank::draw()
+void Tank::draw() const
+{
+    draw(mPosition, orientation(), mWheelSpin, mSteering);
+}
+
+void Tank::draw(const glm::vec3& position, const glm::quat& orientation, float wheelSpin, float steering) const
 {
     glPushMatrix();
 
-    glm::quat eulerQuat = Utils::quatFromEuler(mRoll, mPitch, mYaw);
-    glm::mat4 rotationMatrix = glm::toMat4(eulerQuat);
-    glm::mat4 translationMatrix = glm::translate(glm::mat4(), glm::vec3(mPosition.x, mPosition.y, mPosition.z));
+    glm::mat4 rotationMatrix = glm::toMat4(orientation);
+    glm::mat4 translationMatrix = glm::translate(glm::mat4(), position);
     glm::mat4 mat = translationMatrix * rotationMatrix;
     glMultMatrixf(glm::value_ptr(mat));
 
-    if (mModelLoaded)
+    if (mModel)
     {
-        drawModel(Model::File);
+        drawModel(Model::File, wheelSpin, steering);
     }
     else
     {
-        drawModel(Model::Cube);
+        drawModel(Model::Cube, wheelSpin, steering);
     }
 
 #if DEBUG
@@ -99,6 +117,31 @@ void Tank::stop()
     mVelocity = 0.0f;
 }
 
+void Tank::setSteering(float steering)
+{
+    mSteering = steering;
+}
+
+float Tank::steering() const
+{
+    return mSteering;
+}
+
+float Tank::wheelSpin() const
+{
+    return mWheelSpin;
+}
+
+const AssetCache::VehicleMeshHandle& Tank::model() const
+{
+    return mModel;
+}
+
+glm::mat4 Tank::modelTransform()
+{
+    return glm::rotate(glm::mat4(), glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
 void Tank::setPosition(glm::vec3 position)
 {
     mPosition = position;
@@ -158,7 +201,12 @@ float Tank::roll() const
     return mRoll;
 }
 
-void Tank::drawModel(Model model)
+glm::quat Tank::orientation() const
+{
+    return Utils::quatFromEuler(mRoll, mPitch, mYaw);
+}
+
+void Tank::drawModel(Model model, float wheelSpin, float steering) const
 {
     if (model == Model::Simple)
     {
@@ -218,66 +266,29 @@ void Tank::drawModel(Model model)
     else if (model == Model::File)
     {
         glPushMatrix();
-        glRotatef(90.0f, 0.0f, 0.0f, 1.0f);
-        std::array<VertexObject, 4> wheels =
-                        { mObjects["Wheel_FL"], mObjects["Wheel_FR"], mObjects["Wheel_BL"], mObjects["Wheel_BR"] };
-        for (auto& wheel : wheels)
+        glMultMatrixf(glm::value_ptr(modelTransform()));
+        mModel->bind();
+        if (mChassis >= 0)
         {
-            auto faces = wheel.getFaces();
-            for (const auto& face : faces)
-            {
-                if (face.type == VertexObject::Type::Triangle)
-                {
-                    glBegin(GL_TRIANGLES);
-                }
-                else if (face.type == VertexObject::Type::Quad)
-                {
-                    glBegin(GL_QUADS);
-                }
-                else
-                {
-                    glBegin(GL_POLYGON);
-                }
-
-                const std::vector<glm::vec3>& vertices = face.vertices;
-                const std::vector<glm::vec3>& normals = face.normals;
-                for (int i = 0; i < vertices.size(); ++i)
-                {
-                    glVertex3f(vertices[i].x, vertices[i].y, vertices[i].z);
-                    glNormal3f(normals[i].x, normals[i].y, normals[i].z);
-                }
-                glEnd();
-            }
+            mModel->drawPart(mChassis);
         }
-
-#if 1
-        VertexObject chassis = mObjects["Chassis"];
-        auto faces = chassis.getFaces();
-        for (const auto& face : faces)
+        for (std::size_t i = 0; i < mWheels.size(); ++i)
         {
-            if (face.type == VertexObject::Type::Triangle)
-            {
-                glBegin(GL_TRIANGLES);
-            }
-            else if (face.type == VertexObject::Type::Quad)
-            {
-                glBegin(GL_QUADS);
-            }
-            else
-            {
-                glBegin(GL_POLYGON);
-            }
+            if (mWheels[i] < 0)
+                continue;
 
-            const std::vector<glm::vec3>& vertices = face.vertices;
-            const std::vector<glm::vec3>& normals = face.normals;
-            for (int i = 0; i < vertices.size(); ++i)
+            // spin around the axle and steer the front wheels around the vertical through the hub
+            const VehicleMesh::Part& wheel = mModel->parts()[mWheels[i]];
+            glm::mat4 transform = glm::translate(glm::mat4(), wheel.pivot);
+            if (i < 2)
             {
-                glVertex3f(vertices[i].x, vertices[i].y, vertices[i].z);
-                glNormal3f(normals[i].x, normals[i].y, normals[i].z);
+                transform = glm::rotate(transform, glm::radians(steering), glm::vec3(0.0f, 0.0f, 1.0f));
             }
-            glEnd();
+            transform = glm::rotate(transform, glm::radians(wheelSpin), wheel.axle);
+            transform = glm::translate(transform, -wheel.pivot);
+            mModel->drawPart(mWheels[i], transform);
         }
-#endif
+        mModel->unbind();
         glPopMatrix();
     }
     else
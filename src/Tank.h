@@ -1,10 +1,12 @@
 #ifndef TANK_H
 #define TANK_H
 
+#include "glm/mat4x4.hpp"
 #include "glm/vec3.hpp"
-#include "VertexObject.h"
+#include "glm/gtc/quaternion.hpp"
+#include "AssetCache.h"
+#include <array>
 #include <vector>
-#include <map>
 
 class Tank
 {
@@ -13,11 +15,16 @@ public:
     ~Tank() = default;
 
     // move the tank according to its position speed orientation, ...
-    // returns the new position
+    // by one simulation tick; returns the new position
     glm::vec3 move();
 
     // draw the tank at mPosition
-    void draw();
+    void draw() const;
+    /* @brief draw the tank at another position, e.g. interpolated between two
+     * ticks, with its wheels turned by wheelSpin and the front wheels steered
+     * by steering degrees.
+     */
+    void draw(const glm::vec3& position, const glm::quat& orientation, float wheelSpin = 0.0f, float steering = 0.0f) const;
 
     void setOrientation(float pitch, float yaw, float roll);
     void setRoll(float roll);
@@ -32,14 +39,28 @@ public:
     float roll() const;
     float pitch() const;
     float yaw() const;
+    // the orientation as rotation from model to world space
+    glm::quat orientation() const;
 
     void setPosition(glm::vec3 position);
     glm::vec3 position() const;
 
+    // velocities are distances per tick
     void accelerate(double acceleration);
     double velocity() const;
     void stop();
 
+    // angle of the front wheels in degrees, positive to the left; only drawn
+    void setSteering(float steering);
+    float steering() const;
+    // how far the wheels have turned, in degrees
+    float wheelSpin() const;
+
+    // the model shared by all tanks, empty if it could not be loaded
+    const AssetCache::VehicleMeshHandle& model() const;
+    // from the coordinates of the model file to those of the tank, x forward and z up
+    static glm::mat4 modelTransform();
+
 private:
     enum class Model
     {
@@ -49,7 +70,7 @@ private:
     };
     /* @brief just draw the model; no positioning transformations.
      */
-    void drawModel(Model model);
+    void drawModel(Model model, float wheelSpin, float steering) const;
 
     // x, y, z
     glm::vec3 mPosition;
@@ -60,9 +81,16 @@ private:
     float mRoll = 0.0f;
 
     float mVelocity = 0.0f;
+    float mSteering = 0.0f;
+    float mWheelSpin = 0.0f;
+    float mWheelRadius = 0.2f;
 
-    std::map<std::string, VertexObject> mObjects;
-    bool mModelLoaded = false;
+    // shared with all other tanks, see AssetCache
+    AssetCache::VehicleMeshHandle mModel;
+    // parts of mModel, -1 if it has none of that name
+    int mChassis = -1;
+    // front left, front right, back left, back right
+    std::array<int, 4> mWheels;
 };
 
 #endif
@@ -1,12 +1,19 @@
 #include "Terrain.h"
+#include "TerrainNormals.h"
+#include "TerrainVertex.h"
 #include "utils/Jpeg.h"
 
 #include <glm/gtx/compatibility.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/matrix.hpp>
+#include <cmath>
 #include <istream>
 #include <fstream>
 #include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 // Enable multitexture blending across the terrain
 #ifndef ENABLE_MULTITEXTURE
@@ -26,18 +33,6 @@ inline float getPercentage(float value, const float min, const float max)
     return ( value - min ) / ( max - min );
 }
 
-// Get's the size of the file in bytes.
-inline int getFileLength(std::istream& file)
-{
-    int pos = file.tellg();
-    file.seekg(0, std::ios::end );
-    int length = file.tellg();
-    // Restore the position of the get pointer
-    file.seekg(pos);
-
-    return length;
-}
-
 inline void deleteVertexBuffer(GLuint& vboID)
 {
     if ( vboID != 0 )
@@ -54,6 +49,25 @@ inline void createVertexBuffer(GLuint& vboID)
     glGenBuffersARB( 1, &vboID );
 }
 
+// texture coordinates from (0, 0) to (1, 1) across the terrain, derived from the position
+inline void enableTexCoordGen(float terrainWidth, float terrainHeight)
+{
+    const GLfloat planeS[] = { 1.0f / terrainWidth, 0.0f, 0.0f, 0.5f };
+    const GLfloat planeT[] = { 0.0f, 0.0f, 1.0f / terrainHeight, 0.5f };
+    glTexGeni( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
+    glTexGenfv( GL_S, GL_OBJECT_PLANE, planeS );
+    glTexGeni( GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
+    glTexGenfv( GL_T, GL_OBJECT_PLANE, planeT );
+    glEnable( GL_TEXTURE_GEN_S );
+    glEnable( GL_TEXTURE_GEN_T );
+}
+
+inline void disableTexCoordGen()
+{
+    glDisable( GL_TEXTURE_GEN_S );
+    glDisable( GL_TEXTURE_GEN_T );
+}
+
 inline void deleteTexture(GLuint& texID)
 {
     if ( texID != 0 )
@@ -103,11 +117,6 @@ inline float getHeightValue(const unsigned char* data, unsigned char numBytes)
 
 Terrain::Terrain(float heightScale /* = 500.0f */, float blockScale /* = 2.0f */) :
                 mGLVertexBuffer(0),
-                                mGLNormalBuffer(0),
-                                mGLColorBuffer(0),
-                                mGLTex0Buffer(0),
-                                mGLTex1Buffer(0),
-                                mGLTex2Buffer(0),
                                 mGLIndexBuffer(0),
                                 mLocalToWorldMatrix(1),
                                 mInverseLocalToWorldMatrix(1),
@@ -126,12 +135,9 @@ Terrain::~Terrain()
 void Terrain::terminate()
 {
     deleteVertexBuffer(mGLVertexBuffer);
-    deleteVertexBuffer(mGLNormalBuffer);
-    deleteVertexBuffer(mGLColorBuffer);
-    deleteVertexBuffer(mGLTex0Buffer);
-    deleteVertexBuffer(mGLTex1Buffer);
-    deleteVertexBuffer(mGLTex2Buffer);
     deleteVertexBuffer(mGLIndexBuffer);
+    mShader.release();
+    mShaderEnabled = false;
 
     for (unsigned int i = 0; i < mNumTextures; ++i)
     {
@@ -189,17 +195,10 @@ bool Terrain::loadHeightmap(const std::string& filename, unsigned char bitsPerPi
         return false;
     }
 
-    std::ifstream ifs;
-    ifs.open(filename, std::ifstream::binary);
-    if ( ifs.fail() )
-    {
-        std::cerr << "Failed to open file: " << filename << std::endl;
-        return false;
-    }
-
-    const unsigned int bytesPerPixel = bitsPerPixel / 8;
-    const unsigned int expectedFileSize = ( bytesPerPixel * width * height );
-    const unsigned int fileSize = getFileLength(ifs);
+    // sizes in 64 bit, a heightmap may well be larger than 4 GB
+    const size_t bytesPerPixel = bitsPerPixel / 8;
+    const size_t expectedFileSize = bytesPerPixel * width * height;
+    const size_t fileSize = buffer.st_size;
 
     if ( expectedFileSize != fileSize )
     {
@@ -207,22 +206,29 @@ bool Terrain::loadHeightmap(const std::string& filename, unsigned char bitsPerPi
         return false;
     }
 
-    unsigned char* heightMap = new unsigned char[fileSize];
-    ifs.read( (char*)heightMap, fileSize);
-    if ( ifs.fail() )
+    // map the file instead of copying it, the pages are only read once
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if ( file < 0 )
+    {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+    void* mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if ( mapping == MAP_FAILED )
     {
         std::cerr << "An error occurred while reading from the height map file: " << filename << std::endl;
-        ifs.close();
-        delete [] heightMap;
         return false;
     }
-    ifs.close();
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    const unsigned char* heightMap = (const unsigned char*) mapping;
 
-    unsigned int numVerts = width * height;
+    size_t numVerts = (size_t) width * height;
     mPositionBuffer.resize(numVerts);
-    mColorBuffer.resize(numVerts);
-    mNormalBuffer.resize(numVerts);
-    mTex0Buffer.resize(numVerts);
+    // the heights alone and the blend weights, for the normals
+    std::vector<float> heights(numVerts);
+    std::vector<glm::vec4> colors(numVerts);
+    mHeightTexels.resize(numVerts);
 
     mHeightmapDimensions = glm::uvec2(width, height);
 
@@ -237,7 +243,7 @@ bool Terrain::loadHeightmap(const std::string& filename, unsigned char bitsPerPi
     {
         for ( unsigned i = 0; i < width; ++i )
         {
-            unsigned int index = ( j * width ) + i;
+            size_t index = ( (size_t) j * width ) + i;
             assert( index * bytesPerPixel < fileSize );
             float heightValue = getHeightValue(&heightMap[index * bytesPerPixel], bytesPerPixel);
 
@@ -252,23 +258,27 @@ bool Terrain::loadHeightmap(const std::string& filename, unsigned char bitsPerPi
             float tex0Contribution = 1.0f - getPercentage(heightValue, 0.0f, 0.75f);
             float tex2Contribution = 1.0f - getPercentage(heightValue, 0.75f, 1.0f);
 
-            mNormalBuffer[index] = glm::vec3(0);
             mPositionBuffer[index] = glm::vec3(X, Y, Z);
+            heights[index] = Y;
+            mHeightTexels[index] = (GLushort) std::lround(heightValue * 65535.0f);
 #if ENABLE_MULTITEXTURE
-            mColorBuffer[index] = glm::vec4(tex0Contribution, tex0Contribution, tex0Contribution, tex2Contribution);
+            colors[index] = glm::vec4(tex0Contribution, tex0Contribution, tex0Contribution, tex2Contribution);
 #else
-            mColorBuffer[index] = glm::vec4(1.0f);
+            colors[index] = glm::vec4(1.0f);
 #endif
-            mTex0Buffer[index] = glm::vec2(S, T);
         }
     }
 
     std::cout << "Terrain has been loaded!" << std::endl;
-    delete [] heightMap;
+    munmap(mapping, fileSize);
 
     generateIndexBuffer();
-    generateNormals();
+    generateNormals(heights, colors);
     generateVertexBuffers();
+    if (mShaderEnabled && !mShader.setHeightmap(mHeightTexels, width, height))
+    {
+        mShaderEnabled = false;
+    }
 
     return true;
 }
@@ -281,59 +291,34 @@ void Terrain::generateIndexBuffer()
         return;
     }
 
-    const unsigned int terrainWidth = mHeightmapDimensions.x;
-    const unsigned int terrainHeight = mHeightmapDimensions.y;
-
-    // 2 triangles for every quad of the terrain mesh
-    const unsigned int numTriangles = ( terrainWidth - 1 ) * ( terrainHeight - 1 ) * 2;
-
-    // 3 indices for each triangle in the terrain mesh
-    mIndexBuffer.resize(numTriangles * 3);
-
-    unsigned int index = 0; // Index in the index buffer
-    for (unsigned int j = 0; j < (terrainHeight - 1); ++j )
-    {
-        for (unsigned int i = 0; i < (terrainWidth - 1); ++i )
-        {
-            int vertexIndex = ( j * terrainWidth ) + i;
-            // Top triangle (T0)
-            mIndexBuffer[index++] = vertexIndex;                           // V0
-            mIndexBuffer[index++] = vertexIndex + terrainWidth + 1;        // V3
-            mIndexBuffer[index++] = vertexIndex + 1;                       // V1
-            // Bottom triangle (T1)
-            mIndexBuffer[index++] = vertexIndex;                           // V0
-            mIndexBuffer[index++] = vertexIndex + terrainWidth;            // V2
-            mIndexBuffer[index++] = vertexIndex + terrainWidth + 1;        // V3
-        }
-    }
+    // the quadtree leaves are the chunks of the LOD patterns, which also
+    // draw the full resolution: 16 bit indices per chunk, in cache sized strips
+    mQuadtree.build(mPositionBuffer, mHeightmapDimensions.x, mHeightmapDimensions.y, TerrainLod::ChunkQuads);
+    mLod.build(mPositionBuffer, mHeightmapDimensions.x, mHeightmapDimensions.y);
+    std::cout << "Terrain index buffer: " << mLod.indices().size() * sizeof(GLushort) / 1024 << " KB, ACMR "
+              << mLod.fullResolutionAcmr(16) << " (16 entry FIFO)" << std::endl;
 }
 
-void Terrain::generateNormals()
+void Terrain::generateNormals(const std::vector<float>& heights, std::vector<glm::vec4>& colors)
 {
-    for (unsigned int i = 0; i < mIndexBuffer.size(); i += 3)
-    {
-        glm::vec3 v0 = mPositionBuffer[mIndexBuffer[i + 0]];
-        glm::vec3 v1 = mPositionBuffer[mIndexBuffer[i + 1]];
-        glm::vec3 v2 = mPositionBuffer[mIndexBuffer[i + 2]];
-
-        glm::vec3 normal = glm::normalize( glm::cross( v1 - v0, v2 - v0 ) );
-
-        mNormalBuffer[mIndexBuffer[i + 0]] += normal;
-        mNormalBuffer[mIndexBuffer[i + 1]] += normal;
-        mNormalBuffer[mIndexBuffer[i + 2]] += normal;
-    }
-
-    const glm::vec3 UP( 0.0f, 1.0f, 0.0f );
-    for (unsigned int i = 0; i < mNormalBuffer.size(); ++i)
-    {
-        mNormalBuffer[i] = glm::normalize(mNormalBuffer[i]);
-
+    // gathered from the neighbouring heights on all cores, see TerrainNormals;
+    // the slope based blend is computed in the same pass
+    std::vector<glm::vec3> normals(heights.size());
 #if ENABLE_SLOPE_BASED_BLEND
-        float val = glm::dot(mNormalBuffer[i], UP) - 0.1f;
-        float fTexture0Contribution = glm::saturate<float, glm::highp>(val);
-        mColorBuffer[i] = glm::vec4(fTexture0Contribution, fTexture0Contribution, fTexture0Contribution, mColorBuffer[i].w);
+    glm::vec4* slopeColors = colors.data();
+#else
+    glm::vec4* slopeColors = nullptr;
 #endif
+    TerrainNormals::generate(heights.data(), mHeightmapDimensions.x, mHeightmapDimensions.y, mBlockScale, mBlockScale,
+                    normals.data(), slopeColors);
 
+    // chunk after chunk, in the layout of the LOD patterns
+    const std::vector<GLuint> gridVertices = mLod.gridVertices();
+    mVertices.resize(gridVertices.size());
+    for (size_t i = 0; i < mVertices.size(); ++i)
+    {
+        const GLuint v = gridVertices[i];
+        mVertices[i] = TerrainVertex::pack(mPositionBuffer[v], normals[v], colors[v]);
     }
 }
 
@@ -341,34 +326,15 @@ void Terrain::generateVertexBuffers()
 {
     // First generate the buffer object ID's
     createVertexBuffer(mGLVertexBuffer);
-    createVertexBuffer(mGLNormalBuffer);
-    createVertexBuffer(mGLColorBuffer);
-    createVertexBuffer(mGLTex0Buffer);
-    createVertexBuffer(mGLTex1Buffer);
-    createVertexBuffer(mGLTex2Buffer);
     createVertexBuffer(mGLIndexBuffer);
 
     // Copy the host data into the vertex buffer objects
+    // positions, normals and colours interleaved, see TerrainVertex
     glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLVertexBuffer);
-    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(glm::vec3) * mPositionBuffer.size(), &(mPositionBuffer[0]), GL_STATIC_DRAW_ARB);
-
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLColorBuffer);
-    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(glm::vec4) * mColorBuffer.size(), &(mColorBuffer[0]), GL_STATIC_DRAW_ARB);
-
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLNormalBuffer);
-    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(glm::vec3) * mNormalBuffer.size(), &(mNormalBuffer[0]), GL_STATIC_DRAW_ARB);
-
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLTex0Buffer);
-    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(glm::vec2) * mTex0Buffer.size(), &(mTex0Buffer[0]), GL_STATIC_DRAW_ARB);
-
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLTex1Buffer);
-    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(glm::vec2) * mTex0Buffer.size(), &(mTex0Buffer[0]), GL_STATIC_DRAW_ARB);
-
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLTex2Buffer);
-    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(glm::vec2) * mTex0Buffer.size(), &(mTex0Buffer[0]), GL_STATIC_DRAW_ARB);
+    glBufferDataARB( GL_ARRAY_BUFFER_ARB, sizeof(TerrainVertex) * mVertices.size(), &(mVertices[0]), GL_STATIC_DRAW_ARB);
 
     glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, mGLIndexBuffer);
-    glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(GLuint) * mIndexBuffer.size(), &(mIndexBuffer[0]), GL_STATIC_DRAW_ARB);
+    glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(GLushort) * mLod.indices().size(), &(mLod.indices()[0]), GL_STATIC_DRAW_ARB);
 }
 
 float Terrain::getHeightAt(const glm::vec3& position)
@@ -402,10 +368,11 @@ float Terrain::getHeightAt(const glm::vec3& position)
 
     if (u0 >= 0 && u1 < (int) mHeightmapDimensions.x && v0 >= 0 && v1 < (int) mHeightmapDimensions.y)
     {
-        glm::vec3 p00 = mPositionBuffer[(v0 * mHeightmapDimensions.x) + u0];    // Top-left vertex
-        glm::vec3 p10 = mPositionBuffer[(v0 * mHeightmapDimensions.x) + u1];    // Top-right vertex
-        glm::vec3 p01 = mPositionBuffer[(v1 * mHeightmapDimensions.x) + u0];    // Bottom-left vertex
-        glm::vec3 p11 = mPositionBuffer[(v1 * mHeightmapDimensions.x) + u1];    // Bottom-right vertex
+        const size_t width = mHeightmapDimensions.x;
+        glm::vec3 p00 = mPositionBuffer[(v0 * width) + u0];    // Top-left vertex
+        glm::vec3 p10 = mPositionBuffer[(v0 * width) + u1];    // Top-right vertex
+        glm::vec3 p01 = mPositionBuffer[(v1 * width) + u0];    // Bottom-left vertex
+        glm::vec3 p11 = mPositionBuffer[(v1 * width) + u1];    // Bottom-right vertex
 
         // Which triangle are we over?
         float percentU = vertexIndices.x - u0;
@@ -434,6 +401,16 @@ float Terrain::getHeightAt(const glm::vec3& position)
 
 void Terrain::render()
 {
+    if (mShaderEnabled)
+    {
+        renderShader();
+        return;
+    }
+
+    // Size of the terrain in world units, for the texture coordinates
+    const float terrainWidth = (mHeightmapDimensions.x - 1) * mBlockScale;
+    const float terrainHeight = (mHeightmapDimensions.y - 1) * mBlockScale;
+
     glMatrixMode( GL_MODELVIEW );
     glPushMatrix();
     glMultMatrixf(glm::value_ptr(mLocalToWorldMatrix));
@@ -451,10 +428,7 @@ void Terrain::render()
     glEnable( GL_TEXTURE_2D );
     glBindTexture( GL_TEXTURE_2D, mGLTextures[0]);
 
-    glClientActiveTextureARB(GL_TEXTURE0_ARB);
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLTex0Buffer);
-    glTexCoordPointer( 2, GL_FLOAT, 0, BUFFER_OFFSET(0) );
+    enableTexCoordGen(terrainWidth, terrainHeight);
 
 #if ENABLE_MULTITEXTURE
     // Disable lighting because it changes the color of the vertices that are
@@ -488,10 +462,7 @@ void Terrain::render()
     glTexEnvi( GL_TEXTURE_ENV, GL_SOURCE2_RGB_ARB, GL_PRIMARY_COLOR_ARB );
     glTexEnvi( GL_TEXTURE_ENV, GL_OPERAND2_RGB_ARB, GL_SRC_COLOR );
 
-    glClientActiveTextureARB(GL_TEXTURE1_ARB);
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLTex1Buffer);
-    glTexCoordPointer( 2, GL_FLOAT, 0, BUFFER_OFFSET(0) );
+    enableTexCoordGen(terrainWidth, terrainHeight);
 
     //
     // Texture Stage 2
@@ -520,53 +491,38 @@ void Terrain::render()
     glTexEnvi( GL_TEXTURE_ENV, GL_SOURCE2_RGB_ARB, GL_PRIMARY_COLOR_ARB );
     glTexEnvi( GL_TEXTURE_ENV, GL_OPERAND2_RGB_ARB, GL_SRC_ALPHA );
 
-    glClientActiveTextureARB(GL_TEXTURE2_ARB);
-    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLTex2Buffer);
-    glTexCoordPointer( 2, GL_FLOAT, 0, BUFFER_OFFSET(0) );
+    enableTexCoordGen(terrainWidth, terrainHeight);
 
 #else
     glEnable( GL_TEXTURE );
     glEnable( GL_LIGHTING );
 #endif
 
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_COLOR_ARRAY );
-    glEnableClientState( GL_NORMAL_ARRAY );
+    TerrainVertex::enableArrays();
+    setVertexPointers(0);
 
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLVertexBuffer);
-    glVertexPointer( 3, GL_FLOAT, 0, BUFFER_OFFSET(0) );
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLColorBuffer);
-    glColorPointer( 4, GL_FLOAT, 0, BUFFER_OFFSET(0) );
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLNormalBuffer);
-    glNormalPointer( GL_FLOAT, 0, BUFFER_OFFSET(0) );
+    // the modelview matrix includes mLocalToWorldMatrix, so the frustum is in terrain space
+    const Frustum frustum = Frustum::fromGL();
+    renderChunks(frustum);
 
-    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, mGLIndexBuffer);
-    glDrawElements( GL_TRIANGLES, mIndexBuffer.size(), GL_UNSIGNED_INT, BUFFER_OFFSET(0));
-
-    glDisableClientState( GL_NORMAL_ARRAY );
-    glDisableClientState( GL_COLOR_ARRAY );
-    glDisableClientState( GL_VERTEX_ARRAY );
+    TerrainVertex::disableArrays();
 
 #if ENABLE_MULTITEXTURE
     glActiveTextureARB(GL_TEXTURE2_ARB);
     glPopMatrix();
     glDisable(GL_TEXTURE_2D);
-    glClientActiveTextureARB(GL_TEXTURE2_ARB);
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+    disableTexCoordGen();
 
     glActiveTextureARB(GL_TEXTURE1_ARB);
     glPopMatrix();
     glDisable(GL_TEXTURE_2D);
-    glClientActiveTextureARB(GL_TEXTURE1_ARB);
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+    disableTexCoordGen();
 #endif
 
     glActiveTextureARB(GL_TEXTURE0_ARB);
     glPopMatrix();
     glDisable(GL_TEXTURE_2D);
-    glClientActiveTextureARB(GL_TEXTURE0_ARB);
-    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+    disableTexCoordGen();
 
     glMatrixMode( GL_MODELVIEW );
     glPopMatrix();
@@ -577,6 +533,131 @@ void Terrain::render()
 
 }
 
+void Terrain::renderChunks(const Frustum& frustum)
+{
+    if (mLodEnabled)
+    {
+        // the camera in terrain space and the size in pixels of one unit at distance one
+        glm::mat4 projection;
+        glm::mat4 modelview;
+        GLint viewport[4];
+        glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projection));
+        glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(modelview));
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        const glm::vec3 camera(glm::inverse(modelview)[3]);
+        mLod.select(camera, viewport[3] * 0.5f * projection[1][1], mLodThreshold);
+    }
+
+    mLodStats = TerrainLod::Stats();
+    mQuadtree.collectLeaves(frustum, mVisibleLeaves);
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, mGLIndexBuffer);
+    for (int leaf : mVisibleLeaves)
+    {
+        const TerrainQuadtree::Node& node = mQuadtree.nodes()[leaf];
+        const int chunk = mLod.chunkAt(node.quadX, node.quadY);
+        const int level = mLodEnabled ? mLod.level(chunk) : 0;
+        const TerrainLod::Pattern& pattern = mLodEnabled ? mLod.pattern(chunk) : mLod.pattern(chunk, 0, 0);
+
+        // the pattern indices are relative to the first vertex of the chunk
+        setVertexPointers(mLod.baseVertex(chunk));
+        glDrawRangeElements( GL_TRIANGLES, 0, pattern.maxVertex, pattern.indexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(pattern.firstIndex * sizeof(GLushort)));
+
+        mLodStats.chunksPerLevel[level]++;
+        mLodStats.drawnChunks++;
+        mLodStats.triangles += pattern.indexCount / 3;
+    }
+    setVertexPointers(0);
+    mVisibleTriangles = mLodStats.triangles;
+}
+
+void Terrain::renderShader()
+{
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glMultMatrixf(glm::value_ptr(mLocalToWorldMatrix));
+
+    // the modelview matrix includes mLocalToWorldMatrix, so the frustum is in terrain space
+    const Frustum frustum = Frustum::fromGL();
+    mQuadtree.collectLeaves(frustum, mVisibleLeaves);
+    mLodStats = TerrainLod::Stats();
+    mShader.begin(mBlockScale, mHeightScale, mGLTextures);
+    for (int leaf : mVisibleLeaves)
+    {
+        const TerrainQuadtree::Node& node = mQuadtree.nodes()[leaf];
+        mShader.drawChunk(node.quadX, node.quadY);
+        mLodStats.chunksPerLevel[0]++;
+        mLodStats.drawnChunks++;
+        mLodStats.triangles += mShader.patchTriangles();
+    }
+    mShader.end();
+    mVisibleTriangles = mLodStats.triangles;
+
+    glPopMatrix();
+}
+
+bool Terrain::setShaderEnabled(bool enabled)
+{
+    mShaderEnabled = false;
+    if (!enabled)
+    {
+        mShader.release();
+        return true;
+    }
+    if (!mShader.init())
+    {
+        return false;
+    }
+    if (!mHeightTexels.empty() && !mShader.setHeightmap(mHeightTexels, mHeightmapDimensions.x, mHeightmapDimensions.y))
+    {
+        mShader.release();
+        return false;
+    }
+    mShaderEnabled = true;
+    return true;
+}
+
+bool Terrain::isShaderEnabled() const
+{
+    return mShaderEnabled;
+}
+
+void Terrain::setVertexPointers(GLuint baseVertex)
+{
+    // the texture coordinates are generated from the positions
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, mGLVertexBuffer);
+    TerrainVertex::setPointers(baseVertex);
+}
+
+size_t Terrain::visibleTriangles() const
+{
+    return mVisibleTriangles;
+}
+
+void Terrain::setLodEnabled(bool enabled)
+{
+    mLodEnabled = enabled;
+}
+
+bool Terrain::isLodEnabled() const
+{
+    return mLodEnabled;
+}
+
+void Terrain::setLodThreshold(float pixels)
+{
+    mLodThreshold = pixels;
+}
+
+float Terrain::lodThreshold() const
+{
+    return mLodThreshold;
+}
+
+const TerrainLod::Stats& Terrain::lodStats() const
+{
+    return mLodStats;
+}
+
 void Terrain::renderNormals()
 {
     glMatrixMode( GL_MODELVIEW );
@@ -590,10 +671,10 @@ void Terrain::renderNormals()
 
     glBegin( GL_LINES );
     {
-        for (unsigned int i = 0; i < mPositionBuffer.size(); ++i)
+        for (unsigned int i = 0; i < mVertices.size(); ++i)
         {
-            glm::vec3 p0 = mPositionBuffer[i];
-            glm::vec3 p1 = (mPositionBuffer[i] + mNormalBuffer[i]);
+            glm::vec3 p0(mVertices[i].position[0], mVertices[i].position[1], mVertices[i].position[2]);
+            glm::vec3 p1 = (p0 + mVertices[i].unpackNormal());
 
             glVertex3fv( glm::value_ptr(p0) );
             glVertex3fv( glm::value_ptr(p1) );
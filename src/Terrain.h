@@ -1,6 +1,11 @@
 #ifndef TERRAIN_H
 #define TERRAIN_H
 
+#include "TerrainQuadtree.h"
+#include "TerrainLod.h"
+#include "TerrainVertex.h"
+#include "TerrainShader.h"
+
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
 #include "glm/mat4x4.hpp"
@@ -22,41 +27,69 @@ public:
     // Get the height of the terrain at a position in world space
     float getHeightAt(const glm::vec3& position);
 
+    // draws the parts of the terrain that are inside the current view frustum
     void render();
+    // the number of triangles drawn by the last render call
+    size_t visibleTriangles() const;
+
+    // draw distant chunks with fewer vertices, see TerrainLod
+    void setLodEnabled(bool enabled);
+    bool isLodEnabled() const;
+    // the largest height error of a chunk on screen, in pixels
+    void setLodThreshold(float pixels);
+    float lodThreshold() const;
+    // the levels and triangles of the last render call
+    const TerrainLod::Stats& lodStats() const;
+    /* draw with GLSL instead of the fixed function stages, see TerrainShader.
+     * Needs a GL context and fails without GLSL 1.20 or vertex textures.
+     * Always draws the full resolution.
+     */
+    bool setShaderEnabled(bool enabled);
+    bool isShaderEnabled() const;
     // In debug builds, the terrain normals will be rendered.
     void debugRender();
 
 protected:
     void generateIndexBuffer();
-    void generateNormals();
+    /* the normal of every vertex from the heights (y) of the grid, packed
+     * into mVertices with the positions and the blend weights in colors
+     */
+    void generateNormals(const std::vector<float>& heights, std::vector<glm::vec4>& colors);
 
     // Generates the vertex buffer objects from the
     // position, normal, texture, and color buffers
     void generateVertexBuffers();
 
     void renderNormals();
+    void renderShader();
+    // draws the visible chunks, at the levels of the LOD if it is enabled
+    void renderChunks(const Frustum& frustum);
+    // point all vertex arrays at baseVertex
+    void setVertexPointers(GLuint baseVertex);
 
 private:
     typedef std::vector<glm::vec3>  PositionBuffer;
-    typedef std::vector<glm::vec4>  ColorBuffer;
-    typedef std::vector<glm::vec3>  NormalBuffer;
-    typedef std::vector<glm::vec2>  TexCoordBuffer;
-    typedef std::vector<GLuint>     IndexBuffer;
 
     PositionBuffer mPositionBuffer;
-    ColorBuffer mColorBuffer;
-    NormalBuffer mNormalBuffer;
-    TexCoordBuffer mTex0Buffer;
-    IndexBuffer mIndexBuffer;
+    // the heights 0 to 65535, for the texture of the shader path
+    std::vector<GLushort> mHeightTexels;
+    // what is uploaded, chunk by chunk; mPositionBuffer is kept for the queries
+    std::vector<TerrainVertex> mVertices;
+
+    TerrainQuadtree mQuadtree;
+    size_t mVisibleTriangles = 0;
+
+    TerrainLod mLod;
+    TerrainShader mShader;
+    bool mShaderEnabled = false;
+    bool mLodEnabled = true;
+    float mLodThreshold = 2.0f;
+    TerrainLod::Stats mLodStats = TerrainLod::Stats();
+    std::vector<int> mVisibleLeaves;
 
     // ID's for the VBO's
     GLuint mGLVertexBuffer;
-    GLuint mGLNormalBuffer;
-    GLuint mGLColorBuffer;
-    GLuint mGLTex0Buffer;
-    GLuint mGLTex1Buffer;
-    GLuint mGLTex2Buffer;
-    GLuint mGLIndexBuffer;
+    GLuint mGLIndexBuffer; // the patterns of mLod
 
     static const unsigned int mNumTextures = 3;
     GLuint mGLTextures[mNumTextures];
@@ -0,0 +1,350 @@
+#include "TerrainLod.h"
+#include "utils/VertexCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+const unsigned int TerrainLod::ChunkQuads;
+const int TerrainLod::MaxLevel;
+const unsigned int TerrainLod::StripQuads;
+
+void TerrainLod::build(const std::vector<glm::vec3>& positions, unsigned int width, unsigned int height,
+                       unsigned int stripQuads)
+{
+    mShapes.clear();
+    mChunks.clear();
+    mPatterns.clear();
+    mIndices.clear();
+    mWidth = width;
+    mStripQuads = std::max(stripQuads, 1u);
+    mVertexCount = 0;
+    mChunksX = 0;
+    mChunksY = 0;
+    if (width < 2 || height < 2)
+    {
+        return;
+    }
+
+    const unsigned int quadsX = width - 1;
+    const unsigned int quadsY = height - 1;
+    mChunksX = (quadsX + ChunkQuads - 1) / ChunkQuads;
+    mChunksY = (quadsY + ChunkQuads - 1) / ChunkQuads;
+
+    // full chunks and the narrower ones at the far borders
+    const unsigned int lastWidth = quadsX - (mChunksX - 1) * ChunkQuads;
+    const unsigned int lastHeight = quadsY - (mChunksY - 1) * ChunkQuads;
+    const unsigned int widths[2] = { ChunkQuads, lastWidth };
+    const unsigned int heights[2] = { ChunkQuads, lastHeight };
+    for (int shape = 0; shape < 4; ++shape)
+    {
+        Shape s;
+        s.width = widths[shape % 2];
+        s.height = heights[shape / 2];
+        // the step of a level has to divide the size of the chunk
+        s.maxLevel = 0;
+        while (s.maxLevel < MaxLevel && s.width % (2u << s.maxLevel) == 0 && s.height % (2u << s.maxLevel) == 0)
+        {
+            s.maxLevel++;
+        }
+        mShapes.push_back(s);
+    }
+
+    // one pattern for every combination keeps the lookup a plain index; the
+    // ones with sides that can never border a coarser chunk are not selected
+    for (int shape = 0; shape < 4; ++shape)
+    {
+        for (int level = 0; level <= MaxLevel; ++level)
+        {
+            for (int mask = 0; mask < 16; ++mask)
+            {
+                buildPattern(mShapes[shape], std::min(level, mShapes[shape].maxLevel), mask);
+            }
+        }
+    }
+
+    mChunks.resize(mChunksX * mChunksY);
+    for (int cy = 0; cy < mChunksY; ++cy)
+    {
+        for (int cx = 0; cx < mChunksX; ++cx)
+        {
+            Chunk& chunk = mChunks[cy * mChunksX + cx];
+            chunk.shape = (cx == mChunksX - 1 ? 1 : 0) + (cy == mChunksY - 1 ? 2 : 0);
+            chunk.gridVertex = cy * ChunkQuads * width + cx * ChunkQuads;
+            chunk.level = 0;
+            chunk.stitchMask = 0;
+
+            const Shape& shape = mShapes[chunk.shape];
+            chunk.baseVertex = mVertexCount;
+            mVertexCount += (shape.width + 1) * (shape.height + 1);
+            chunk.min = chunk.max = positions[chunk.gridVertex];
+            for (unsigned int j = 0; j <= shape.height; ++j)
+            {
+                for (unsigned int i = 0; i <= shape.width; ++i)
+                {
+                    chunk.min = glm::min(chunk.min, positions[chunk.gridVertex + j * width + i]);
+                    chunk.max = glm::max(chunk.max, positions[chunk.gridVertex + j * width + i]);
+                }
+            }
+
+            // errors grow with the level, a coarser level never looks better
+            chunk.errors[0] = 0.0f;
+            for (int level = 1; level <= MaxLevel; ++level)
+            {
+                chunk.errors[level] = level <= shape.maxLevel ?
+                                std::max(chunk.errors[level - 1], chunkError(positions, chunk, shape, level)) :
+                                chunk.errors[level - 1];
+            }
+        }
+    }
+}
+
+float TerrainLod::chunkError(const std::vector<glm::vec3>& positions, const Chunk& chunk, const Shape& shape, int level) const
+{
+    const unsigned int step = 1u << level;
+    float error = 0.0f;
+    for (unsigned int j = 0; j <= shape.height; ++j)
+    {
+        for (unsigned int i = 0; i <= shape.width; ++i)
+        {
+            // the quad of the level that contains the vertex, and the position inside it
+            const unsigned int qi = std::min(i / step * step, shape.width - step);
+            const unsigned int qj = std::min(j / step * step, shape.height - step);
+            const float fx = (i - qi) / (float) step;
+            const float fy = (j - qj) / (float) step;
+            const GLuint v00 = chunk.gridVertex + qj * mWidth + qi;
+            const float y00 = positions[v00].y;
+            const float y10 = positions[v00 + step].y;
+            const float y01 = positions[v00 + step * mWidth].y;
+            const float y11 = positions[v00 + step * mWidth + step].y;
+            // same split of the quad as in the patterns
+            const float y = fx >= fy ?
+                            y00 + fx * (y10 - y00) + fy * (y11 - y10) :
+                            y00 + fy * (y01 - y00) + fx * (y11 - y01);
+            error = std::max(error, std::fabs(positions[chunk.gridVertex + j * mWidth + i].y - y));
+        }
+    }
+    return error;
+}
+
+void TerrainLod::buildPattern(const Shape& shape, int level, int mask)
+{
+    const unsigned int step = 1u << level;
+    Pattern pattern;
+    pattern.firstIndex = mIndices.size();
+    pattern.maxVertex = 0;
+
+    // move odd vertices on stitched sides onto the previous even one
+    const unsigned int stride = shape.width + 1;
+    auto vertex = [&](unsigned int i, unsigned int j) -> GLushort
+    {
+        if (((mask & LEFT) && i == 0) || ((mask & RIGHT) && i == shape.width))
+        {
+            j -= (j / step) % 2 * step;
+        }
+        if (((mask & BOTTOM) && j == 0) || ((mask & TOP) && j == shape.height))
+        {
+            i -= (i / step) % 2 * step;
+        }
+        return j * stride + i;
+    };
+    auto triangle = [&](GLushort a, GLushort b, GLushort c)
+    {
+        if (a == b || b == c || a == c)
+            return;
+        mIndices.push_back(a);
+        mIndices.push_back(b);
+        mIndices.push_back(c);
+        pattern.maxVertex = std::max<GLuint>(pattern.maxVertex, std::max(a, std::max(b, c)));
+    };
+
+    // strips of mStripQuads quads of the level, each row by row
+    const unsigned int stripWidth = mStripQuads * step;
+    for (unsigned int i0 = 0; i0 < shape.width; i0 += stripWidth)
+    {
+        const unsigned int i1 = std::min(i0 + stripWidth, shape.width);
+        for (unsigned int j = 0; j < shape.height; j += step)
+        {
+            for (unsigned int i = i0; i < i1; i += step)
+            {
+                // Top triangle (T0)
+                triangle(vertex(i, j), vertex(i + step, j + step), vertex(i + step, j));
+                // Bottom triangle (T1)
+                triangle(vertex(i, j), vertex(i, j + step), vertex(i + step, j + step));
+            }
+        }
+    }
+
+    pattern.indexCount = mIndices.size() - pattern.firstIndex;
+    mPatterns.push_back(pattern);
+}
+
+int TerrainLod::patternIndex(int shape, int level, int mask) const
+{
+    return (shape * (MaxLevel + 1) + level) * 16 + mask;
+}
+
+void TerrainLod::select(const glm::vec3& camera, float pixelsPerUnit, float threshold)
+{
+    for (Chunk& chunk : mChunks)
+    {
+        // distance from the camera to the bounding box of the chunk
+        const glm::vec3 d = glm::max(glm::max(chunk.min - camera, camera - chunk.max), glm::vec3(0.0f));
+        const float distance = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        chunk.level = 0;
+        if (distance > 0.0f)
+        {
+            const int maxLevel = mShapes[chunk.shape].maxLevel;
+            while (chunk.level < maxLevel && chunk.errors[chunk.level + 1] * pixelsPerUnit / distance <= threshold)
+            {
+                chunk.level++;
+            }
+        }
+    }
+
+    // neighbours may differ by one level only, refine the coarser ones
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int cy = 0; cy < mChunksY; ++cy)
+        {
+            for (int cx = 0; cx < mChunksX; ++cx)
+            {
+                int& level = mChunks[cy * mChunksX + cx].level;
+                const int neighbours[4][2] = { { cx - 1, cy }, { cx + 1, cy }, { cx, cy - 1 }, { cx, cy + 1 } };
+                for (const auto& n : neighbours)
+                {
+                    if (n[0] < 0 || n[0] >= mChunksX || n[1] < 0 || n[1] >= mChunksY)
+                        continue;
+                    const int limit = mChunks[n[1] * mChunksX + n[0]].level + 1;
+                    if (level > limit)
+                    {
+                        level = limit;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int cy = 0; cy < mChunksY; ++cy)
+    {
+        for (int cx = 0; cx < mChunksX; ++cx)
+        {
+            Chunk& chunk = mChunks[cy * mChunksX + cx];
+            const int sides[4][3] = { { cx - 1, cy, LEFT }, { cx + 1, cy, RIGHT }, { cx, cy - 1, BOTTOM }, { cx, cy + 1, TOP } };
+            chunk.stitchMask = 0;
+            for (const auto& side : sides)
+            {
+                if (side[0] >= 0 && side[0] < mChunksX && side[1] >= 0 && side[1] < mChunksY &&
+                    mChunks[side[1] * mChunksX + side[0]].level > chunk.level)
+                {
+                    chunk.stitchMask |= side[2];
+                }
+            }
+        }
+    }
+}
+
+int TerrainLod::chunksX() const
+{
+    return mChunksX;
+}
+
+int TerrainLod::chunksY() const
+{
+    return mChunksY;
+}
+
+int TerrainLod::chunkAt(unsigned int quadX, unsigned int quadY) const
+{
+    return (quadY / ChunkQuads) * mChunksX + quadX / ChunkQuads;
+}
+
+int TerrainLod::maxLevel(int chunk) const
+{
+    return mShapes[mChunks[chunk].shape].maxLevel;
+}
+
+int TerrainLod::level(int chunk) const
+{
+    return mChunks[chunk].level;
+}
+
+int TerrainLod::stitchMask(int chunk) const
+{
+    return mChunks[chunk].stitchMask;
+}
+
+GLuint TerrainLod::baseVertex(int chunk) const
+{
+    return mChunks[chunk].baseVertex;
+}
+
+GLuint TerrainLod::vertexCount() const
+{
+    return mVertexCount;
+}
+
+std::vector<GLuint> TerrainLod::gridVertices() const
+{
+    std::vector<GLuint> vertices;
+    vertices.reserve(mVertexCount);
+    for (const Chunk& chunk : mChunks)
+    {
+        const Shape& shape = mShapes[chunk.shape];
+        for (unsigned int j = 0; j <= shape.height; ++j)
+        {
+            for (unsigned int i = 0; i <= shape.width; ++i)
+            {
+                vertices.push_back(chunk.gridVertex + j * mWidth + i);
+            }
+        }
+    }
+    return vertices;
+}
+
+const TerrainLod::Pattern& TerrainLod::pattern(int chunk) const
+{
+    const Chunk& c = mChunks[chunk];
+    return mPatterns[patternIndex(c.shape, c.level, c.stitchMask)];
+}
+
+const TerrainLod::Pattern& TerrainLod::pattern(int chunk, int level, int stitchMask) const
+{
+    return mPatterns[patternIndex(mChunks[chunk].shape, level, stitchMask)];
+}
+
+float TerrainLod::error(int chunk, int level) const
+{
+    return mChunks[chunk].errors[level];
+}
+
+const std::vector<GLushort>& TerrainLod::indices() const
+{
+    return mIndices;
+}
+
+bool TerrainLod::empty() const
+{
+    return mChunks.empty();
+}
+
+double TerrainLod::fullResolutionAcmr(unsigned int cacheSize) const
+{
+    // every chunk is its own draw call, starting with an empty cache
+    std::vector<std::size_t> shapeMisses;
+    for (int shape = 0; shape < (int) mShapes.size(); ++shape)
+    {
+        const Pattern& pattern = mPatterns[patternIndex(shape, 0, 0)];
+        shapeMisses.push_back(vertexCacheMisses(&mIndices[pattern.firstIndex], pattern.indexCount, cacheSize));
+    }
+    std::size_t misses = 0;
+    std::size_t triangles = 0;
+    for (const Chunk& chunk : mChunks)
+    {
+        misses += shapeMisses[chunk.shape];
+        triangles += mPatterns[patternIndex(chunk.shape, 0, 0)].indexCount / 3;
+    }
+    return triangles > 0 ? misses / (double) triangles : 0.0;
+}
@@ -0,0 +1,133 @@
+#ifndef TERRAINLOD_H
+#define TERRAINLOD_H
+
+#include <GL/glut.h>
+#include "glm/vec3.hpp"
+#include <array>
+#include <vector>
+
+/**
+ @brief Geomipmapping for a regular vertex grid with the height in y.
+        The grid is split into chunks of ChunkQuads x ChunkQuads quads. At
+        level l a chunk is drawn with every 2^l-th vertex in both directions.
+        Neighbouring chunks differ by at most one level; the side of the finer
+        chunk that borders a coarser one drops its odd vertices, so that both
+        share the same edges and no cracks appear.
+        The index patterns for every chunk shape, level and combination of
+        stitched sides are built once. The vertices of each chunk are stored
+        together, chunk after chunk (see gridVertices), so the pattern
+        indices are 16 bit and relative to the first vertex of a chunk, and
+        all chunks share one vertex buffer. The quads of a pattern are
+        emitted in strips of StripQuads columns, so that the vertices shared
+        by consecutive rows are still in the post-transform vertex cache.
+ */
+class TerrainLod
+{
+public:
+    static const unsigned int ChunkQuads = 32;
+    static const int MaxLevel = 5; // 2^MaxLevel == ChunkQuads
+    // two rows of a strip, 2 * (StripQuads + 1) vertices, fit into a 16 entry cache
+    static const unsigned int StripQuads = 7;
+
+    // sides of a chunk that border a coarser neighbour
+    enum Side
+    {
+        LEFT = 1,   // i == 0
+        RIGHT = 2,  // i == width
+        BOTTOM = 4, // j == 0
+        TOP = 8     // j == height
+    };
+
+    // a part of indices() that draws one chunk
+    struct Pattern
+    {
+        GLuint firstIndex;
+        GLsizei indexCount;
+        GLuint maxVertex; // highest relative index used
+    };
+
+    struct Stats
+    {
+        std::array<int, MaxLevel + 1> chunksPerLevel;
+        int drawnChunks;
+        size_t triangles;
+    };
+
+    /* @brief compute the errors of all chunks and the index patterns for a
+     * grid of width x height vertices, stored row by row (index j * width + i).
+     * stripQuads >= ChunkQuads emits the quads row by row.
+     */
+    void build(const std::vector<glm::vec3>& positions, unsigned int width, unsigned int height,
+               unsigned int stripQuads = StripQuads);
+
+    /* @brief choose the level of every chunk: the coarsest one whose error,
+     * projected to the screen, stays below threshold pixels. pixelsPerUnit is
+     * the size in pixels of one unit at distance one, i.e.
+     * viewportHeight / 2 * projection[1][1].
+     */
+    void select(const glm::vec3& camera, float pixelsPerUnit, float threshold);
+
+    int chunksX() const;
+    int chunksY() const;
+    int chunkAt(unsigned int quadX, unsigned int quadY) const;
+    int level(int chunk) const;
+    // the coarsest level the size of the chunk allows
+    int maxLevel(int chunk) const;
+    // the sides of the chunk that are stitched to a coarser neighbour
+    int stitchMask(int chunk) const;
+    // the vertex that the pattern indices of the chunk are relative to
+    GLuint baseVertex(int chunk) const;
+    // the size of the vertex buffer, border vertices are stored once per chunk
+    GLuint vertexCount() const;
+    // for every vertex of the buffer, the grid vertex it is a copy of
+    std::vector<GLuint> gridVertices() const;
+    const Pattern& pattern(int chunk) const;
+    // the pattern of a chunk drawn at another level or with other stitched sides
+    const Pattern& pattern(int chunk, int level, int stitchMask) const;
+    // the largest height difference to the full resolution grid at a level
+    float error(int chunk, int level) const;
+
+    const std::vector<GLushort>& indices() const;
+    bool empty() const;
+
+    /* @brief the average cache miss ratio of drawing all chunks at full
+     * resolution with a FIFO vertex cache of cacheSize entries
+     */
+    double fullResolutionAcmr(unsigned int cacheSize) const;
+
+private:
+    struct Shape
+    {
+        unsigned int width;
+        unsigned int height;
+        int maxLevel;
+    };
+
+    struct Chunk
+    {
+        GLuint baseVertex;
+        GLuint gridVertex; // the first vertex of the chunk in the grid
+        int shape;
+        glm::vec3 min;
+        glm::vec3 max;
+        std::array<float, MaxLevel + 1> errors;
+        int level;
+        int stitchMask;
+    };
+
+    void buildPattern(const Shape& shape, int level, int mask);
+    float chunkError(const std::vector<glm::vec3>& positions, const Chunk& chunk, const Shape& shape, int level) const;
+    int patternIndex(int shape, int level, int mask) const;
+
+    unsigned int mWidth = 0;
+    unsigned int mStripQuads = StripQuads;
+    GLuint mVertexCount = 0;
+    int mChunksX = 0;
+    int mChunksY = 0;
+    std::vector<Shape> mShapes;
+    std::vector<Chunk> mChunks;
+    std::vector<Pattern> mPatterns;
+    std::vector<GLushort> mIndices;
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "TerrainNormals.h"
+#include "utils/CpuFeatures.h"
+#include "utils/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+const unsigned int TerrainNormals::MinBandRows;
+
+namespace
+{
+    struct NormalGrid
+    {
+        const float* heights;
+        unsigned int width;
+        unsigned int height;
+        float spacingX;
+        float spacingZ;
+        glm::vec3* normals;
+        glm::vec4* colors;
+    };
+
+    const float SlopeBlendOffset = 0.1f;
+
+    /* the unnormalised normal is (hl - hr) * spanZ, spanX * spanZ,
+     * (hd - hu) * spanX, the cross product of the differences between the
+     * neighbours along z and along x. Dividing by the length exactly like the
+     * kernels keeps all of them bit-identical.
+     */
+    inline void storeNormal(const NormalGrid& grid, size_t index, float x, float y, float z)
+    {
+        const float length = std::sqrt(x * x + y * y + z * z);
+        const glm::vec3 normal(x / length, y / length, z / length);
+        grid.normals[index] = normal;
+        if (grid.colors != nullptr)
+        {
+            const float blend = std::min(std::max(normal.y - SlopeBlendOffset, 0.0f), 1.0f);
+            grid.colors[index].x = blend;
+            grid.colors[index].y = blend;
+            grid.colors[index].z = blend;
+        }
+    }
+
+    // one vertex, with the neighbours clamped to the grid
+    inline void vertexNormal(const NormalGrid& grid, unsigned int i, unsigned int j)
+    {
+        const unsigned int left = i > 0 ? i - 1 : i;
+        const unsigned int right = i + 1 < grid.width ? i + 1 : i;
+        const unsigned int down = j > 0 ? j - 1 : j;
+        const unsigned int up = j + 1 < grid.height ? j + 1 : j;
+        const float spanX = (right - left) * grid.spacingX;
+        const float spanZ = (up - down) * grid.spacingZ;
+
+        const float* row = grid.heights + (size_t) j * grid.width;
+        const float hl = row[left];
+        const float hr = row[right];
+        const float hd = grid.heights[(size_t) down * grid.width + i];
+        const float hu = grid.heights[(size_t) up * grid.width + i];
+        storeNormal(grid, (size_t) j * grid.width + i, (hl - hr) * spanZ, spanX * spanZ, (hd - hu) * spanX);
+    }
+
+#if defined(AVX2_KERNEL)
+    const unsigned int AvxLanes = 8;
+
+    /* inner vertices first to last - 1 of an inner row j, where all four
+     * neighbours exist; processes the largest multiple of 8 of them and
+     * returns the first vertex that was not.
+     */
+    AVX2_KERNEL unsigned int innerRowAvx2(const NormalGrid& grid, unsigned int j, unsigned int first, unsigned int last)
+    {
+        const float* row = grid.heights + (size_t) j * grid.width;
+        const float* rowDown = row - grid.width;
+        const float* rowUp = row + grid.width;
+        const __m256 spanX = _mm256_set1_ps(2 * grid.spacingX);
+        const __m256 spanZ = _mm256_set1_ps(2 * grid.spacingZ);
+        const __m256 y = _mm256_mul_ps(spanX, spanZ);
+        const __m256 offset = _mm256_set1_ps(SlopeBlendOffset);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        alignas(32) float nx[AvxLanes];
+        alignas(32) float ny[AvxLanes];
+        alignas(32) float nz[AvxLanes];
+        alignas(32) float blend[AvxLanes];
+
+        unsigned int i = first;
+        for (; i + AvxLanes <= last; i += AvxLanes)
+        {
+            const __m256 x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(row + i - 1), _mm256_loadu_ps(row + i + 1)), spanZ);
+            const __m256 z = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(rowDown + i), _mm256_loadu_ps(rowUp + i)), spanX);
+            const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+            const __m256 normalY = _mm256_div_ps(y, length);
+            _mm256_store_ps(nx, _mm256_div_ps(x, length));
+            _mm256_store_ps(ny, normalY);
+            _mm256_store_ps(nz, _mm256_div_ps(z, length));
+            _mm256_store_ps(blend, _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(normalY, offset), zero), one));
+
+            glm::vec3* normals = grid.normals + (size_t) j * grid.width + i;
+            for (unsigned int lane = 0; lane < AvxLanes; ++lane)
+            {
+                normals[lane] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+            }
+            if (grid.colors != nullptr)
+            {
+                glm::vec4* colors = grid.colors + (size_t) j * grid.width + i;
+                for (unsigned int lane = 0; lane < AvxLanes; ++lane)
+                {
+                    colors[lane].x = blend[lane];
+                    colors[lane].y = blend[lane];
+                    colors[lane].z = blend[lane];
+                }
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+    const unsigned int SseLanes = 4;
+
+    // as above, 4 vertices at a time
+    unsigned int innerRowSse2(const NormalGrid& grid, unsigned int j, unsigned int first, unsigned int last)
+    {
+        const float* row = grid.heights + (size_t) j * grid.width;
+        const float* rowDown = row - grid.width;
+        const float* rowUp = row + grid.width;
+        const __m128 spanX = _mm_set1_ps(2 * grid.spacingX);
+        const __m128 spanZ = _mm_set1_ps(2 * grid.spacingZ);
+        const __m128 y = _mm_mul_ps(spanX, spanZ);
+        const __m128 offset = _mm_set1_ps(SlopeBlendOffset);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        alignas(16) float nx[SseLanes];
+        alignas(16) float ny[SseLanes];
+        alignas(16) float nz[SseLanes];
+        alignas(16) float blend[SseLanes];
+
+        unsigned int i = first;
+        for (; i + SseLanes <= last; i += SseLanes)
+        {
+            const __m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + i - 1), _mm_loadu_ps(row + i + 1)), spanZ);
+            const __m128 z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(rowDown + i), _mm_loadu_ps(rowUp + i)), spanX);
+            const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+            const __m128 normalY = _mm_div_ps(y, length);
+            _mm_store_ps(nx, _mm_div_ps(x, length));
+            _mm_store_ps(ny, normalY);
+            _mm_store_ps(nz, _mm_div_ps(z, length));
+            _mm_store_ps(blend, _mm_min_ps(_mm_max_ps(_mm_sub_ps(normalY, offset), zero), one));
+
+            glm::vec3* normals = grid.normals + (size_t) j * grid.width + i;
+            for (unsigned int lane = 0; lane < SseLanes; ++lane)
+            {
+                normals[lane] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+            }
+            if (grid.colors != nullptr)
+            {
+                glm::vec4* colors = grid.colors + (size_t) j * grid.width + i;
+                for (unsigned int lane = 0; lane < SseLanes; ++lane)
+                {
+                    colors[lane].x = blend[lane];
+                    colors[lane].y = blend[lane];
+                    colors[lane].z = blend[lane];
+                }
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__)
+    unsigned int innerRowSimd(const NormalGrid& grid, unsigned int j, unsigned int first, unsigned int last)
+    {
+#if defined(__AVX2__)
+        return innerRowAvx2(grid, j, first, last);
+#else
+#if defined(AVX2_KERNEL)
+        if (hasAvx2())
+        {
+            return innerRowAvx2(grid, j, first, last);
+        }
+#endif
+        return innerRowSse2(grid, j, first, last);
+#endif
+    }
+#endif
+
+    // rows firstRow to endRow - 1
+    void normalBand(const NormalGrid& grid, unsigned int firstRow, unsigned int endRow, bool simd)
+    {
+        for (unsigned int j = firstRow; j < endRow; ++j)
+        {
+            unsigned int i = 0;
+#if defined(__SSE2__)
+            if (simd && j > 0 && j + 1 < grid.height && grid.width > 2)
+            {
+                vertexNormal(grid, 0, j);
+                i = innerRowSimd(grid, j, 1, grid.width - 1);
+            }
+#else
+            (void) simd;
+#endif
+            for (; i < grid.width; ++i)
+            {
+                vertexNormal(grid, i, j);
+            }
+        }
+    }
+}
+
+void TerrainNormals::generate(const float* heights, unsigned int width, unsigned int height, float spacingX, float spacingZ,
+                glm::vec3* normals, glm::vec4* colors, unsigned int threads)
+{
+    const NormalGrid grid = { heights, width, height, spacingX, spacingZ, normals, colors };
+    const unsigned int bands = threadCount(height, threads);
+    const unsigned int rowsPerBand = (height + bands - 1) / bands;
+    parallelFor(bands, [&](unsigned int band)
+    {
+        normalBand(grid, std::min(band * rowsPerBand, height), std::min((band + 1) * rowsPerBand, height), true);
+    });
+}
+
+void TerrainNormals::generateScalar(const float* heights, unsigned int width, unsigned int height, float spacingX, float spacingZ,
+                glm::vec3* normals, glm::vec4* colors)
+{
+    const NormalGrid grid = { heights, width, height, spacingX, spacingZ, normals, colors };
+    normalBand(grid, 0, height, false);
+}
+
+const char* TerrainNormals::kernelName()
+{
+#if defined(__SSE2__)
+    return hasAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+unsigned int TerrainNormals::threadCount(unsigned int height, unsigned int threads)
+{
+    return std::max(1u, std::min(threadsFor(threads), height / MinBandRows));
+}
@@ -0,0 +1,42 @@
+#ifndef TERRAINNORMALS_H
+#define TERRAINNORMALS_H
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+/**
+ @brief Vertex normals of a regular height grid with the height in y.
+        Each normal is gathered from the four neighbouring heights of its
+        vertex (central differences, one-sided at the borders), so every
+        vertex is written exactly once: rows are split into bands that are
+        computed on separate threads, and within a row the kernel runs
+        8 (AVX2, if the CPU has it) or 4 (SSE2) vertices at a time.
+        The results do not depend on the kernel or the number of threads.
+ */
+class TerrainNormals
+{
+public:
+    /* @brief the normals of a grid of width x height heights, stored row by
+     * row (index j * width + i), with spacingX between the columns i and
+     * spacingZ between the rows j. If colors is not null, the slope blend
+     * weight clamp(normal.y - 0.1, 0, 1) is written to their x, y and z.
+     * threads == 0 uses one thread per core.
+     */
+    static void generate(const float* heights, unsigned int width, unsigned int height, float spacingX, float spacingZ,
+                    glm::vec3* normals, glm::vec4* colors, unsigned int threads = 0);
+
+    // the same on one thread without SIMD, the reference for the kernels
+    static void generateScalar(const float* heights, unsigned int width, unsigned int height, float spacingX, float spacingZ,
+                    glm::vec3* normals, glm::vec4* colors);
+
+    // name of the vectorised kernel used by generate
+    static const char* kernelName();
+
+    // the number of threads generate uses for a grid with that many rows
+    static unsigned int threadCount(unsigned int height, unsigned int threads);
+
+    // bands are at least that many rows, smaller grids are not worth a thread
+    static const unsigned int MinBandRows = 64;
+};
+
+#endif
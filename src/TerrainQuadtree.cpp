@@ -0,0 +1,107 @@
+#include "TerrainQuadtree.h"
+
+#include <algorithm>
+
+void TerrainQuadtree::build(const std::vector<glm::vec3>& positions, unsigned int width, unsigned int height, unsigned int leafQuads)
+{
+    mNodes.clear();
+    mLeafQuads = std::max(leafQuads, 1u);
+    if (width < 2 || height < 2)
+    {
+        return;
+    }
+    buildNode(positions, width, 0, 0, width - 1, height - 1);
+}
+
+int TerrainQuadtree::buildNode(const std::vector<glm::vec3>& positions, unsigned int width,
+                               unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1)
+{
+    const int index = mNodes.size();
+    mNodes.push_back(Node());
+    Node node;
+    node.quadX = x0;
+    node.quadY = y0;
+    std::fill(node.children, node.children + 4, -1);
+
+    if (x1 - x0 <= mLeafQuads && y1 - y0 <= mLeafQuads)
+    {
+        // leaf: the bounds of its vertices
+        node.min = node.max = positions[y0 * width + x0];
+        for (unsigned int j = y0; j <= y1; ++j)
+        {
+            for (unsigned int i = x0; i <= x1; ++i)
+            {
+                node.min = glm::min(node.min, positions[j * width + i]);
+                node.max = glm::max(node.max, positions[j * width + i]);
+            }
+        }
+    }
+    else
+    {
+        // split the longer sides in half, at a multiple of the leaf size
+        const unsigned int midX = x1 - x0 > mLeafQuads ? x0 + ((x1 - x0) / 2 + mLeafQuads - 1) / mLeafQuads * mLeafQuads : x1;
+        const unsigned int midY = y1 - y0 > mLeafQuads ? y0 + ((y1 - y0) / 2 + mLeafQuads - 1) / mLeafQuads * mLeafQuads : y1;
+        const unsigned int bounds[4][4] = {
+            { x0, y0, midX, midY },
+            { midX, y0, x1, midY },
+            { x0, midY, midX, y1 },
+            { midX, midY, x1, y1 } };
+        int count = 0;
+        for (int child = 0; child < 4; ++child)
+        {
+            const unsigned int* b = bounds[child];
+            if (b[0] == b[2] || b[1] == b[3])
+                continue;
+            const int childIndex = buildNode(positions, width, b[0], b[1], b[2], b[3]);
+            const Node& c = mNodes[childIndex];
+            node.min = count == 0 ? c.min : glm::min(node.min, c.min);
+            node.max = count == 0 ? c.max : glm::max(node.max, c.max);
+            node.children[count++] = childIndex;
+        }
+    }
+
+    mNodes[index] = node;
+    return index;
+}
+
+void TerrainQuadtree::collectLeaves(const Frustum& frustum, std::vector<int>& leaves) const
+{
+    leaves.clear();
+    if (!mNodes.empty())
+    {
+        collectLeaves(0, frustum, false, leaves);
+    }
+}
+
+void TerrainQuadtree::collectLeaves(int index, const Frustum& frustum, bool inside, std::vector<int>& leaves) const
+{
+    const Node& node = mNodes[index];
+    if (!inside)
+    {
+        const Frustum::Visibility visibility = frustum.classify(node.min, node.max);
+        if (visibility == Frustum::Visibility::OUTSIDE)
+            return;
+        inside = (visibility == Frustum::Visibility::INSIDE);
+    }
+
+    if (node.children[0] < 0)
+    {
+        leaves.push_back(index);
+        return;
+    }
+
+    for (int child = 0; child < 4 && node.children[child] >= 0; ++child)
+    {
+        collectLeaves(node.children[child], frustum, inside, leaves);
+    }
+}
+
+const std::vector<TerrainQuadtree::Node>& TerrainQuadtree::nodes() const
+{
+    return mNodes;
+}
+
+bool TerrainQuadtree::empty() const
+{
+    return mNodes.empty();
+}
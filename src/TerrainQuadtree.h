@@ -0,0 +1,47 @@
+#ifndef TERRAINQUADTREE_H
+#define TERRAINQUADTREE_H
+
+#include "Frustum.h"
+
+#include "glm/vec3.hpp"
+#include <vector>
+
+/**
+ @brief A quadtree over the quads of a regular vertex grid. Each node bounds
+        its part of the grid with an axis aligned box from the minimum and
+        maximum vertex positions. The grid is drawn leaf by leaf from index
+        buffers of its own, see TerrainLod.
+ */
+class TerrainQuadtree
+{
+public:
+    struct Node
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        unsigned int quadX; // first quad covered by the node
+        unsigned int quadY;
+        int children[4]; // -1 for leaves
+    };
+
+    /* @brief build the tree for a grid of width x height vertices, stored row
+     * by row in positions. Leaves cover at most leafQuads x leafQuads quads.
+     */
+    void build(const std::vector<glm::vec3>& positions, unsigned int width, unsigned int height, unsigned int leafQuads);
+
+    // the leaves that intersect the frustum, as indices into nodes()
+    void collectLeaves(const Frustum& frustum, std::vector<int>& leaves) const;
+
+    const std::vector<Node>& nodes() const;
+    bool empty() const;
+
+private:
+    int buildNode(const std::vector<glm::vec3>& positions, unsigned int width,
+                  unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+    void collectLeaves(int node, const Frustum& frustum, bool inside, std::vector<int>& leaves) const;
+
+    std::vector<Node> mNodes;
+    unsigned int mLeafQuads = 32;
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include "TerrainShader.h"
+#include "TerrainLod.h"
+#include "utils/ShaderProgram.h"
+
+#include <algorithm>
+
+#include <iostream>
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+const unsigned int TerrainShader::PatchQuads;
+const unsigned int TerrainShader::TextureCount;
+
+const char* const TerrainShader::VertexSource = R"glsl(
+#version 120
+
+attribute vec2 patchPosition;
+uniform vec2 chunkOrigin;
+uniform vec2 gridSize;
+uniform float blockScale;
+uniform float heightScale;
+uniform sampler2D heightmap;
+
+varying vec2 texCoord;
+varying vec3 normal;
+varying float height;
+
+float heightAt(vec2 grid)
+{
+    return texture2DLod(heightmap, (grid + 0.5) / gridSize, 0.0).r;
+}
+
+void main()
+{
+    vec2 last = gridSize - 1.0;
+    vec2 grid = min(chunkOrigin + patchPosition, last);
+    height = heightAt(grid);
+
+    // central differences, one-sided at the borders, as in TerrainNormals
+    vec2 low = max(grid - 1.0, vec2(0.0));
+    vec2 high = min(grid + 1.0, last);
+    vec2 span = (high - low) * blockScale;
+    float dx = (heightAt(vec2(low.x, grid.y)) - heightAt(vec2(high.x, grid.y))) * heightScale;
+    float dz = (heightAt(vec2(grid.x, low.y)) - heightAt(vec2(grid.x, high.y))) * heightScale;
+    normal = vec3(dx * span.y, span.x * span.y, dz * span.x);
+
+    texCoord = grid / last;
+    vec2 xz = (grid - last * 0.5) * blockScale;
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(xz.x, height * heightScale, xz.y, 1.0);
+}
+)glsl";
+
+const char* const TerrainShader::FragmentSource = R"glsl(
+#version 120
+
+uniform sampler2D texture0;
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+uniform float textureRepeat;
+
+varying vec2 texCoord;
+varying vec3 normal;
+varying float height;
+
+void main()
+{
+    vec2 uv = texCoord * textureRepeat;
+    // stage 1: texture1 on slopes, stage 2: texture2 above 3/4 of the height
+    float level = clamp(normalize(normal).y - 0.1, 0.0, 1.0);
+    float top = clamp((height - 0.75) / 0.25, 0.0, 1.0);
+    vec3 color = mix(texture2D(texture1, uv).rgb, texture2D(texture0, uv).rgb, level);
+    color = mix(color, texture2D(texture2, uv).rgb, top);
+    gl_FragColor = vec4(color, 1.0);
+}
+)glsl";
+
+TerrainShader::~TerrainShader()
+{
+    release();
+}
+
+bool TerrainShader::init()
+{
+    release();
+
+    GLint vertexTextures = 0;
+    glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextures);
+    if (vertexTextures < 1)
+    {
+        std::cerr << "No texture units in the vertex shader, the terrain shader is not available" << std::endl;
+        return false;
+    }
+
+    // the shader does not read gl_Vertex, and compatibility contexts may draw nothing without an array at location 0
+    mProgram = linkShaderProgram(VertexSource, FragmentSource, "Terrain", { { 0, "patchPosition" } });
+    if (mProgram == 0)
+    {
+        return false;
+    }
+    mPatchPosition = glGetAttribLocation(mProgram, "patchPosition");
+    if (mPatchPosition < 0)
+    {
+        std::cerr << "No patchPosition attribute, the terrain shader is not available" << std::endl;
+        release();
+        return false;
+    }
+    mChunkOrigin = glGetUniformLocation(mProgram, "chunkOrigin");
+
+    // the patch, row by row, and its triangles in cache sized strips as in TerrainLod
+    std::vector<GLfloat> vertices;
+    for (unsigned int j = 0; j <= PatchQuads; ++j)
+    {
+        for (unsigned int i = 0; i <= PatchQuads; ++i)
+        {
+            vertices.push_back((GLfloat) i);
+            vertices.push_back((GLfloat) j);
+        }
+    }
+    std::vector<GLushort> indices;
+    const GLushort stride = PatchQuads + 1;
+    for (unsigned int i0 = 0; i0 < PatchQuads; i0 += TerrainLod::StripQuads)
+    {
+        for (unsigned int j = 0; j < PatchQuads; ++j)
+        {
+            for (unsigned int i = i0; i < std::min(i0 + TerrainLod::StripQuads, PatchQuads); ++i)
+            {
+                const GLushort v = j * stride + i;
+                const GLushort quad[6] = { v, (GLushort) (v + stride + 1), (GLushort) (v + 1), v, (GLushort) (v + stride), (GLushort) (v + stride + 1) };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+    mPatchIndexCount = indices.size();
+
+    glGenBuffersARB(1, &mPatchVertices);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, mPatchVertices);
+    glBufferDataARB(GL_ARRAY_BUFFER_ARB, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW_ARB);
+    glGenBuffersARB(1, &mPatchIndices);
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, mPatchIndices);
+    glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(GLushort) * indices.size(), indices.data(), GL_STATIC_DRAW_ARB);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+    return true;
+}
+
+bool TerrainShader::isReady() const
+{
+    return mProgram != 0 && mHeightmap != 0;
+}
+
+void TerrainShader::release()
+{
+    if (mProgram != 0)
+    {
+        glDeleteProgram(mProgram);
+        mProgram = 0;
+    }
+    if (mHeightmap != 0)
+    {
+        glDeleteTextures(1, &mHeightmap);
+        mHeightmap = 0;
+    }
+    if (mPatchVertices != 0)
+    {
+        glDeleteBuffersARB(1, &mPatchVertices);
+        mPatchVertices = 0;
+    }
+    if (mPatchIndices != 0)
+    {
+        glDeleteBuffersARB(1, &mPatchIndices);
+        mPatchIndices = 0;
+    }
+}
+
+bool TerrainShader::setHeightmap(const std::vector<GLushort>& heights, unsigned int width, unsigned int height)
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (width > (unsigned int) maxSize || height > (unsigned int) maxSize)
+    {
+        std::cerr << "The heightmap is larger than the largest texture (" << maxSize << ")" << std::endl;
+        return false;
+    }
+
+    if (mHeightmap == 0)
+    {
+        glGenTextures(1, &mHeightmap);
+    }
+    glBindTexture(GL_TEXTURE_2D, mHeightmap);
+    // one height per vertex, no filtering between them
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE16, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_SHORT, heights.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mWidth = width;
+    mHeight = height;
+    return true;
+}
+
+void TerrainShader::begin(float blockScale, float heightScale, const GLuint* textures)
+{
+    glUseProgram(mProgram);
+    glUniform2f(glGetUniformLocation(mProgram, "gridSize"), (GLfloat) mWidth, (GLfloat) mHeight);
+    glUniform1f(glGetUniformLocation(mProgram, "blockScale"), blockScale);
+    glUniform1f(glGetUniformLocation(mProgram, "heightScale"), heightScale);
+    glUniform1f(glGetUniformLocation(mProgram, "textureRepeat"), 32.0f);
+
+    // units 0 to 2 are the stages, the heightmap goes after them
+    const char* names[TextureCount] = { "texture0", "texture1", "texture2" };
+    for (unsigned int unit = 0; unit < TextureCount; ++unit)
+    {
+        glActiveTextureARB(GL_TEXTURE0_ARB + unit);
+        glBindTexture(GL_TEXTURE_2D, textures[unit]);
+        glUniform1i(glGetUniformLocation(mProgram, names[unit]), unit);
+    }
+    glActiveTextureARB(GL_TEXTURE0_ARB + TextureCount);
+    glBindTexture(GL_TEXTURE_2D, mHeightmap);
+    glUniform1i(glGetUniformLocation(mProgram, "heightmap"), TextureCount);
+    glActiveTextureARB(GL_TEXTURE0_ARB);
+
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, mPatchVertices);
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, mPatchIndices);
+    glEnableVertexAttribArray(mPatchPosition);
+    glVertexAttribPointer(mPatchPosition, 2, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0));
+}
+
+void TerrainShader::drawChunk(unsigned int quadX, unsigned int quadY)
+{
+    glUniform2f(mChunkOrigin, (GLfloat) quadX, (GLfloat) quadY);
+    glDrawRangeElements(GL_TRIANGLES, 0, (PatchQuads + 1) * (PatchQuads + 1) - 1, mPatchIndexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(0));
+}
+
+void TerrainShader::end()
+{
+    glDisableVertexAttribArray(mPatchPosition);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+    for (unsigned int unit = 0; unit <= TextureCount; ++unit)
+    {
+        glActiveTextureARB(GL_TEXTURE0_ARB + unit);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTextureARB(GL_TEXTURE0_ARB);
+    glUseProgram(0);
+}
+
+GLsizei TerrainShader::patchTriangles() const
+{
+    return mPatchIndexCount / 3;
+}
@@ -0,0 +1,65 @@
+#ifndef TERRAINSHADER_H
+#define TERRAINSHADER_H
+
+#include <GL/glut.h>
+#include <vector>
+
+/**
+ @brief The GLSL 1.20 render path of Terrain. The heights are uploaded once
+        as a 16 bit texture. Every chunk is drawn from the same patch of
+        PatchQuads x PatchQuads quads; the vertex shader moves the patch to
+        the chunk, fetches the height and computes the normal from the
+        neighbouring heights. The fragment shader blends the three terrain
+        textures by slope and height in one pass, as the fixed function
+        stages of Terrain::render do. Patches are clamped to the border of
+        the grid, so chunks at the far sides draw some degenerate triangles.
+        Vertex texture fetch is required; Mesa's llvmpipe provides it.
+ */
+class TerrainShader
+{
+public:
+    static const unsigned int PatchQuads = 32;
+    static const unsigned int TextureCount = 3;
+
+    TerrainShader() = default;
+    ~TerrainShader();
+    TerrainShader(const TerrainShader&) = delete;
+    TerrainShader& operator=(const TerrainShader&) = delete;
+
+    /* @brief compile the program and upload the patch. Needs a current GL
+     * context; fails without GLSL or vertex texture fetch.
+     */
+    bool init();
+    bool isReady() const;
+    void release();
+
+    /* @brief upload the heights, 0 to 65535 for the range of the terrain,
+     * row by row.
+     */
+    bool setHeightmap(const std::vector<GLushort>& heights, unsigned int width, unsigned int height);
+
+    // bind the program, the heightmap and the textures of the three stages
+    void begin(float blockScale, float heightScale, const GLuint* textures);
+    // draw the chunk that starts at that quad of the grid
+    void drawChunk(unsigned int quadX, unsigned int quadY);
+    void end();
+
+    // triangles per drawChunk call
+    GLsizei patchTriangles() const;
+
+    static const char* const VertexSource;
+    static const char* const FragmentSource;
+
+private:
+    GLuint mProgram = 0;
+    GLuint mHeightmap = 0;
+    GLuint mPatchVertices = 0;
+    GLuint mPatchIndices = 0;
+    GLsizei mPatchIndexCount = 0;
+    GLint mPatchPosition = -1;
+    GLint mChunkOrigin = -1;
+    unsigned int mWidth = 0;
+    unsigned int mHeight = 0;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "TerrainVertex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+namespace
+{
+    GLbyte quantiseSigned(float value)
+    {
+        return (GLbyte) std::lround(std::min(std::max(value, -1.0f), 1.0f) * 127.0f);
+    }
+
+    GLubyte quantiseUnsigned(float value)
+    {
+        return (GLubyte) std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+    }
+}
+
+TerrainVertex TerrainVertex::pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec4& color)
+{
+    TerrainVertex vertex;
+    vertex.position[0] = position.x;
+    vertex.position[1] = position.y;
+    vertex.position[2] = position.z;
+    vertex.normal[0] = quantiseSigned(normal.x);
+    vertex.normal[1] = quantiseSigned(normal.y);
+    vertex.normal[2] = quantiseSigned(normal.z);
+    vertex.normal[3] = 0;
+    vertex.color[0] = quantiseUnsigned(color.x);
+    vertex.color[1] = quantiseUnsigned(color.y);
+    vertex.color[2] = quantiseUnsigned(color.z);
+    vertex.color[3] = quantiseUnsigned(color.w);
+    return vertex;
+}
+
+glm::vec3 TerrainVertex::unpackNormal() const
+{
+    return glm::vec3(normal[0] / 127.0f, normal[1] / 127.0f, normal[2] / 127.0f);
+}
+
+glm::vec4 TerrainVertex::unpackColor() const
+{
+    return glm::vec4(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f, color[3] / 255.0f);
+}
+
+void TerrainVertex::setPointers(GLuint baseVertex)
+{
+    const std::size_t base = baseVertex * sizeof(TerrainVertex);
+    for (const Attribute& attribute : TerrainVertexLayout)
+    {
+        const GLvoid* pointer = BUFFER_OFFSET(base + attribute.offset);
+        switch (attribute.array)
+        {
+        case GL_VERTEX_ARRAY:
+            glVertexPointer(attribute.size, attribute.type, sizeof(TerrainVertex), pointer);
+            break;
+        case GL_NORMAL_ARRAY:
+            glNormalPointer(attribute.type, sizeof(TerrainVertex), pointer);
+            break;
+        case GL_COLOR_ARRAY:
+            glColorPointer(attribute.size, attribute.type, sizeof(TerrainVertex), pointer);
+            break;
+        }
+    }
+}
+
+void TerrainVertex::enableArrays()
+{
+    for (const Attribute& attribute : TerrainVertexLayout)
+    {
+        glEnableClientState(attribute.array);
+    }
+}
+
+void TerrainVertex::disableArrays()
+{
+    for (const Attribute& attribute : TerrainVertexLayout)
+    {
+        glDisableClientState(attribute.array);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef TERRAINVERTEX_H
+#define TERRAINVERTEX_H
+
+#include <GL/glut.h>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include <cstddef>
+
+/**
+ @brief One vertex of Terrain as it is uploaded, interleaved in a single
+        buffer: 20 bytes instead of the 64 of separate float arrays. The
+        normal is quantised to bytes and the blend weights to unsigned
+        bytes; texture coordinates are not stored, Terrain generates them
+        from the position. The position stays in floats, the fixed function
+        pipeline transforms normals with the modelview matrix, so a scale
+        that expands quantised positions would distort the lighting.
+ */
+struct TerrainVertex
+{
+    GLfloat position[3];
+    GLbyte normal[4];  // unit normal * 127, the 4th byte is padding
+    GLubyte color[4];  // blend weights * 255
+
+    // one vertex array of the layout
+    struct Attribute
+    {
+        GLenum array; // GL_VERTEX_ARRAY, GL_NORMAL_ARRAY or GL_COLOR_ARRAY
+        GLint size;
+        GLenum type;
+        std::size_t offset;
+    };
+
+    static TerrainVertex pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec4& color);
+    glm::vec3 unpackNormal() const;
+    glm::vec4 unpackColor() const;
+
+    /* @brief point the arrays of TerrainVertexLayout at the bound array
+     * buffer, starting at baseVertex.
+     */
+    static void setPointers(GLuint baseVertex);
+    static void enableArrays();
+    static void disableArrays();
+};
+
+// the layout of TerrainVertex, from which setPointers sets the arrays
+constexpr TerrainVertex::Attribute TerrainVertexLayout[] =
+{
+    { GL_VERTEX_ARRAY, 3, GL_FLOAT, offsetof(TerrainVertex, position) },
+    { GL_NORMAL_ARRAY, 3, GL_BYTE, offsetof(TerrainVertex, normal) },
+    { GL_COLOR_ARRAY, 4, GL_UNSIGNED_BYTE, offsetof(TerrainVertex, color) }
+};
+
+static_assert(sizeof(TerrainVertex) == 20, "TerrainVertex is not packed");
+
+#endif
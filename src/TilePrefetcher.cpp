@@ -0,0 +1,154 @@
+#include "TilePrefetcher.h"
+#include "Constants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+double TilePrefetcher::Stats::hitRate() const
+{
+    return hits + misses > 0 ? hits / (double) (hits + misses) : 0.0;
+}
+
+TilePrefetcher::TilePrefetcher(TiledHeightfield& tiles, float lookAhead, float stepsPerSecond, float radius) :
+                mTiles(tiles),
+                mLookAhead(lookAhead),
+                mStepsPerSecond(stepsPerSecond),
+                mRadius(radius),
+                mPending(tiles.tilesX() * tiles.tilesY(), 0),
+                mRunning(true)
+{
+    mWorker = std::thread(&TilePrefetcher::run, this);
+}
+
+TilePrefetcher::~TilePrefetcher()
+{
+    mRunning = false;
+    mWorker.join();
+
+    Prepared prepared;
+    while (mPrepared.pop(prepared))
+    {
+        if (prepared.mapping != nullptr)
+        {
+            mTiles.discardTile(prepared.mapping);
+        }
+    }
+}
+
+void TilePrefetcher::run()
+{
+    while (mRunning)
+    {
+        int tile;
+        if (!mRequests.pop(tile))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        Prepared prepared;
+        prepared.tile = tile;
+        prepared.mapping = mTiles.prepareTile(tile);
+        while (!mPrepared.push(prepared))
+        {
+            if (!mRunning)
+            {
+                if (prepared.mapping != nullptr)
+                {
+                    mTiles.discardTile(prepared.mapping);
+                }
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TilePrefetcher::update(const glm::vec3& position, double velocity, float yaw)
+{
+    adoptPrepared();
+
+    // Tank moves velocity units per step along its yaw
+    const float angle = yaw / 180.0f * pi;
+    glm::vec2 direction(std::cos(angle), std::sin(angle));
+    if (velocity < 0.0)
+    {
+        direction = -direction;
+    }
+    predict(glm::vec2(position.x, position.y), direction, std::fabs(velocity) * mStepsPerSecond * mLookAhead);
+
+    for (int tile : mPredicted)
+    {
+        if (mTiles.isResident(tile) || mPending[tile])
+            continue;
+        if (!mRequests.push(tile))
+            break;
+        mPending[tile] = 1;
+        mRequested++;
+    }
+}
+
+void TilePrefetcher::adoptPrepared()
+{
+    Prepared prepared;
+    while (mPrepared.pop(prepared))
+    {
+        if (prepared.mapping != nullptr)
+        {
+            mTiles.adoptTile(prepared.tile, prepared.mapping);
+        }
+        mPending[prepared.tile] = 0;
+    }
+}
+
+void TilePrefetcher::predict(glm::vec2 position, glm::vec2 direction, float distance)
+{
+    mPredicted.clear();
+    const float spacing = mTiles.spacing();
+    const int tileSize = mTiles.tileSize();
+    // half of the cache, the tiles in use need the rest
+    const std::size_t maxTiles = std::max<std::size_t>(1, mTiles.budget() / mTiles.tileBytes() / 2);
+    auto tileX = [&](float x)
+    {
+        return std::min(std::max((int) std::floor(x / spacing), 0), mTiles.sizeX() - 1) / tileSize;
+    };
+    auto tileY = [&](float y)
+    {
+        return std::min(std::max((int) std::floor(y / spacing), 0), mTiles.sizeY() - 1) / tileSize;
+    };
+
+    // points along the path, close enough that their neighbourhoods overlap
+    const float step = std::max(std::min(tileSize * spacing, mRadius), spacing);
+    const int points = (int) std::ceil(distance / step);
+    for (int k = 0; k <= points && mPredicted.size() < maxTiles; ++k)
+    {
+        const glm::vec2 p = position + direction * std::min(k * step, distance);
+        for (int tx = tileX(p.x - mRadius); tx <= tileX(p.x + mRadius); ++tx)
+        {
+            for (int ty = tileY(p.y - mRadius); ty <= tileY(p.y + mRadius); ++ty)
+            {
+                const int tile = tx * mTiles.tilesY() + ty;
+                if (mPredicted.size() < maxTiles && std::find(mPredicted.begin(), mPredicted.end(), tile) == mPredicted.end())
+                {
+                    mPredicted.push_back(tile);
+                }
+            }
+        }
+    }
+}
+
+const std::vector<int>& TilePrefetcher::predicted() const
+{
+    return mPredicted;
+}
+
+TilePrefetcher::Stats TilePrefetcher::stats() const
+{
+    Stats stats;
+    stats.requested = mRequested;
+    stats.hits = mTiles.prefetchHits();
+    stats.misses = mTiles.tileLoads();
+    stats.stallUs = mTiles.stallUs();
+    return stats;
+}
@@ -0,0 +1,81 @@
+#ifndef TILEPREFETCHER_H
+#define TILEPREFETCHER_H
+
+#include "TiledHeightfield.h"
+#include "utils/SpscQueue.h"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ @brief Loads the tiles of a TiledHeightfield before they are read.
+        Every step, update() extrapolates the vehicle along its heading for
+        lookAhead seconds and requests the tiles around that path. A worker
+        thread maps and reads the requested tiles; update() puts the ones it
+        finished into the cache of the heightfield. Requests and results go
+        through lock-free queues, the heightfield itself is only touched by
+        the thread that calls update().
+        The prefetcher has to be destroyed before the heightfield is closed.
+ */
+class TilePrefetcher
+{
+public:
+    struct Stats
+    {
+        std::size_t requested;  // tiles sent to the worker
+        std::size_t hits;       // reads of tiles that were prefetched
+        std::size_t misses;     // tiles the reading thread had to load itself
+        unsigned long stallUs;  // time spent on those
+
+        // share of tile loads that the prefetcher took off the reading thread
+        double hitRate() const;
+    };
+
+    /* @brief velocities passed to update are distances per step, as in Tank;
+     * stepsPerSecond converts lookAhead into steps. Tiles within radius
+     * (world units) of the path are requested.
+     */
+    TilePrefetcher(TiledHeightfield& tiles, float lookAhead = 2.0f, float stepsPerSecond = 60.0f, float radius = 100.0f);
+    ~TilePrefetcher();
+    TilePrefetcher(const TilePrefetcher&) = delete;
+    TilePrefetcher& operator=(const TilePrefetcher&) = delete;
+
+    // call once per step, e.g. with Tank::position(), velocity() and yaw()
+    void update(const glm::vec3& position, double velocity, float yaw);
+
+    // the tiles requested by the last update, in order of distance along the path
+    const std::vector<int>& predicted() const;
+    Stats stats() const;
+
+private:
+    struct Prepared
+    {
+        int tile;
+        void* mapping;
+    };
+
+    void run();
+    void adoptPrepared();
+    void predict(glm::vec2 position, glm::vec2 direction, float distance);
+
+    TiledHeightfield& mTiles;
+    float mLookAhead;
+    float mStepsPerSecond;
+    float mRadius;
+
+    // per tile, whether it was requested and not adopted yet
+    std::vector<char> mPending;
+    std::vector<int> mPredicted;
+    // read by stats() on other threads
+    std::atomic<std::size_t> mRequested { 0 };
+
+    SpscQueue<int, 256> mRequests;
+    SpscQueue<Prepared, 256> mPrepared;
+    std::atomic<bool> mRunning;
+    std::thread mWorker;
+};
+
+#endif
@@ -0,0 +1,424 @@
+#include "TiledHeightfield.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const std::uint32_t TiledHeightfield::Magic;
+const std::uint32_t TiledHeightfield::Version;
+const int TiledHeightfield::DefaultTileSize;
+const int TiledHeightfield::MaxTileSize;
+
+namespace
+{
+    // tiles start on a page boundary so that they can be mapped on their own
+    const std::uint64_t TileAlignment = 4096;
+
+    std::uint64_t alignUp(std::uint64_t value)
+    {
+        return (value + TileAlignment - 1) / TileAlignment * TileAlignment;
+    }
+}
+
+TiledHeightfield::~TiledHeightfield()
+{
+    close();
+}
+
+bool TiledHeightfield::write(const std::string& filename, const HeightSource& source, int tileSize)
+{
+    if (tileSize <= 0 || tileSize > MaxTileSize || source.sizeX() <= 0 || source.sizeY() <= 0)
+    {
+        std::cerr << "Invalid tiled heightfield size for " << filename << std::endl;
+        return false;
+    }
+
+    std::ofstream ofs(filename, std::ofstream::binary | std::ofstream::trunc);
+    if (ofs.fail())
+    {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.sizeX = source.sizeX();
+    header.sizeY = source.sizeY();
+    header.tileSize = tileSize;
+    header.spacing = source.spacing();
+
+    const int tilesX = (source.sizeX() + tileSize - 1) / tileSize;
+    const int tilesY = (source.sizeY() + tileSize - 1) / tileSize;
+    const std::uint64_t tileBytes = (std::uint64_t) tileSize * tileSize * sizeof(float);
+    std::vector<std::uint64_t> offsets((std::size_t) tilesX * tilesY);
+    std::uint64_t offset = alignUp(sizeof(Header) + offsets.size() * sizeof(std::uint64_t));
+    for (std::uint64_t& o : offsets)
+    {
+        o = offset;
+        offset = alignUp(offset + tileBytes);
+    }
+
+    ofs.write((const char*) &header, sizeof(Header));
+    ofs.write((const char*) offsets.data(), offsets.size() * sizeof(std::uint64_t));
+
+    std::vector<float> samples((std::size_t) tileSize * tileSize);
+    for (int tx = 0; tx < tilesX; ++tx)
+    {
+        for (int ty = 0; ty < tilesY; ++ty)
+        {
+            // the padding beyond the border repeats the last sample
+            for (int i = 0; i < tileSize; ++i)
+            {
+                for (int j = 0; j < tileSize; ++j)
+                {
+                    const int x = std::min(tx * tileSize + i, source.sizeX() - 1);
+                    const int y = std::min(ty * tileSize + j, source.sizeY() - 1);
+                    samples[(std::size_t) i * tileSize + j] = source.height(x, y);
+                }
+            }
+            ofs.seekp(offsets[(std::size_t) tx * tilesY + ty]);
+            ofs.write((const char*) samples.data(), tileBytes);
+        }
+    }
+
+    if (ofs.fail())
+    {
+        std::cerr << "An error occurred while writing the tiled heightfield: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TiledHeightfield::open(const std::string& filename, std::size_t budgetBytes)
+{
+    close();
+
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    Header header;
+    if (fstat(file, &status) != 0 || pread(file, &header, sizeof(Header), 0) != (ssize_t) sizeof(Header))
+    {
+        std::cerr << "Failed to read the header of " << filename << std::endl;
+        ::close(file);
+        return false;
+    }
+    if (header.magic != Magic || header.version != Version)
+    {
+        std::cerr << filename << " is not a tiled heightfield" << std::endl;
+        ::close(file);
+        return false;
+    }
+    if (header.tileSize == 0 || header.tileSize > (std::uint32_t) MaxTileSize ||
+        header.sizeX == 0 || header.sizeY == 0 || header.sizeX > INT_MAX || header.sizeY > INT_MAX ||
+        !(header.spacing > 0.0f) || !std::isfinite(header.spacing))
+    {
+        std::cerr << "Invalid header in " << filename << std::endl;
+        ::close(file);
+        return false;
+    }
+
+    // the directory and every tile must fit into the file, before anything is allocated for them
+    const int tilesX = (header.sizeX + header.tileSize - 1) / header.tileSize;
+    const int tilesY = (header.sizeY + header.tileSize - 1) / header.tileSize;
+    const std::uint64_t tiles = (std::uint64_t) tilesX * tilesY;
+    const std::uint64_t tileBytes = (std::uint64_t) header.tileSize * header.tileSize * sizeof(float);
+    const std::uint64_t directoryBytes = tiles * sizeof(std::uint64_t);
+    const std::uint64_t fileBytes = status.st_size;
+    if (directoryBytes > fileBytes || tiles > (fileBytes - directoryBytes) / tileBytes)
+    {
+        std::cerr << filename << " is truncated: " << tiles << " tiles of " << tileBytes << " bytes do not fit into "
+                  << fileBytes << " bytes" << std::endl;
+        ::close(file);
+        return false;
+    }
+
+    std::vector<std::uint64_t> offsets(tiles);
+    if (pread(file, offsets.data(), directoryBytes, sizeof(Header)) != (ssize_t) directoryBytes)
+    {
+        std::cerr << "Failed to read the tile directory of " << filename << std::endl;
+        ::close(file);
+        return false;
+    }
+
+    for (std::uint64_t offset : offsets)
+    {
+        if (offset % TileAlignment != 0 || offset > fileBytes || tileBytes > fileBytes - offset)
+        {
+            std::cerr << "Invalid tile offset " << offset << " in " << filename << std::endl;
+            ::close(file);
+            return false;
+        }
+    }
+
+    mFile = file;
+    mHeader = header;
+    mTilesX = tilesX;
+    mTilesY = tilesY;
+    mOffsets.swap(offsets);
+    mMaxResident = std::max<std::size_t>(1, budgetBytes / tileBytes);
+    mLookup.assign(mOffsets.size(), mResident.end());
+    mTileLoads = 0;
+    mStallUs = 0;
+    mPrefetchHits = 0;
+    return true;
+}
+
+void TiledHeightfield::close()
+{
+    for (const Resident& resident : mResident)
+    {
+        unmap(resident);
+    }
+    mResident.clear();
+    mLookup.clear();
+    mOffsets.clear();
+    mLastTile = -1;
+    mLastSamples = nullptr;
+    if (mFile >= 0)
+    {
+        ::close(mFile);
+        mFile = -1;
+    }
+    mHeader = Header();
+    mTilesX = 0;
+    mTilesY = 0;
+}
+
+bool TiledHeightfield::isOpen() const
+{
+    return mFile >= 0;
+}
+
+int TiledHeightfield::sizeX() const
+{
+    return mHeader.sizeX;
+}
+
+int TiledHeightfield::sizeY() const
+{
+    return mHeader.sizeY;
+}
+
+float TiledHeightfield::spacing() const
+{
+    return mHeader.spacing;
+}
+
+float TiledHeightfield::height(int x, int y) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return sample(x, y);
+}
+
+void TiledHeightfield::cellHeights(int x, int y, float& h00, float& h01, float& h10, float& h11) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    h00 = sample(x, y);
+    h01 = sample(x, y + 1);
+    h10 = sample(x + 1, y);
+    h11 = sample(x + 1, y + 1);
+}
+
+float TiledHeightfield::sample(int x, int y) const
+{
+    x = std::min(std::max(x, 0), sizeX() - 1);
+    y = std::min(std::max(y, 0), sizeY() - 1);
+    const int tileSize = mHeader.tileSize;
+    const float* samples = tile((x / tileSize) * mTilesY + y / tileSize);
+    return samples[(std::size_t) (x % tileSize) * tileSize + y % tileSize];
+}
+
+const float* TiledHeightfield::tile(int index) const
+{
+    // neighbouring queries mostly hit the same tile
+    if (index == mLastTile)
+    {
+        return mLastSamples;
+    }
+
+    ResidentList::iterator it = mLookup[index];
+    if (it != mResident.end())
+    {
+        mResident.splice(mResident.begin(), mResident, it);
+        if (it->adopted)
+        {
+            it->adopted = false;
+            mPrefetchHits++;
+        }
+    }
+    else
+    {
+        const unsigned long start = Utils::clockTimeUs();
+        Resident& resident = insert(index);
+        resident.mapping = prepareTile(index);
+        if (resident.mapping == nullptr)
+        {
+            // fall back to a copy; a tile that can't be read stays flat
+            std::cerr << "Failed to map tile " << index << ", reading it instead" << std::endl;
+            resident.copy.assign((std::size_t) mHeader.tileSize * mHeader.tileSize, 0.0f);
+            if (pread(mFile, resident.copy.data(), resident.mappingSize, mOffsets[index]) != (ssize_t) resident.mappingSize)
+            {
+                std::cerr << "Failed to read tile " << index << std::endl;
+            }
+            resident.samples = resident.copy.data();
+        }
+        else
+        {
+            resident.samples = (const float*) resident.mapping;
+        }
+        mTileLoads++;
+        mStallUs += Utils::clockTimeUs() - start;
+    }
+
+    mLastTile = index;
+    mLastSamples = mResident.front().samples;
+    return mLastSamples;
+}
+
+TiledHeightfield::Resident& TiledHeightfield::insert(int index) const
+{
+    if (mResident.size() >= mMaxResident)
+    {
+        const Resident& oldest = mResident.back();
+        mLookup[oldest.tile] = mResident.end();
+        if (oldest.tile == mLastTile)
+        {
+            mLastTile = -1;
+        }
+        unmap(oldest);
+        mResident.pop_back();
+    }
+
+    mResident.push_front(Resident());
+    Resident& resident = mResident.front();
+    resident.tile = index;
+    resident.samples = nullptr;
+    resident.mapping = nullptr;
+    resident.mappingSize = tileBytes();
+    resident.adopted = false;
+    mLookup[index] = mResident.begin();
+    return resident;
+}
+
+void* TiledHeightfield::prepareTile(int tile) const
+{
+    void* mapping = mmap(nullptr, tileBytes(), PROT_READ, MAP_SHARED, mFile, mOffsets[tile]);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    // mmap only reserves the range, fault the pages in now
+    madvise(mapping, tileBytes(), MADV_WILLNEED);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    volatile char sink = 0;
+    for (std::size_t offset = 0; offset < tileBytes(); offset += pageSize)
+    {
+        sink += ((const char*) mapping)[offset];
+    }
+    (void) sink;
+    return mapping;
+}
+
+void TiledHeightfield::adoptTile(int tile, void* mapping)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mLookup[tile] != mResident.end())
+    {
+        discardTile(mapping);
+        return;
+    }
+
+    Resident& resident = insert(tile);
+    resident.mapping = mapping;
+    resident.samples = (const float*) mapping;
+    resident.adopted = true;
+}
+
+void TiledHeightfield::discardTile(void* mapping) const
+{
+    munmap(mapping, tileBytes());
+}
+
+bool TiledHeightfield::isResident(int tile) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLookup[tile] != mResident.end();
+}
+
+void TiledHeightfield::unmap(const Resident& resident) const
+{
+    if (resident.mapping != nullptr)
+    {
+        munmap(resident.mapping, resident.mappingSize);
+    }
+}
+
+int TiledHeightfield::tileSize() const
+{
+    return mHeader.tileSize;
+}
+
+int TiledHeightfield::tilesX() const
+{
+    return mTilesX;
+}
+
+int TiledHeightfield::tilesY() const
+{
+    return mTilesY;
+}
+
+std::size_t TiledHeightfield::tileBytes() const
+{
+    return (std::size_t) mHeader.tileSize * mHeader.tileSize * sizeof(float);
+}
+
+std::size_t TiledHeightfield::budget() const
+{
+    return mMaxResident * tileBytes();
+}
+
+std::size_t TiledHeightfield::residentTiles() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mResident.size();
+}
+
+std::size_t TiledHeightfield::residentBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mResident.size() * tileBytes();
+}
+
+std::size_t TiledHeightfield::tileLoads() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTileLoads;
+}
+
+unsigned long TiledHeightfield::stallUs() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStallUs;
+}
+
+std::size_t TiledHeightfield::prefetchHits() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPrefetchHits;
+}
@@ -0,0 +1,139 @@
+#ifndef TILEDHEIGHTFIELD_H
+#define TILEDHEIGHTFIELD_H
+
+#include "HeightSource.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ @brief A heightfield on disk that is paged in tile by tile.
+        The file holds a Header, a directory with the byte offset of every
+        tile and the tiles themselves: tileSize x tileSize floats, row-major
+        like Heightfield, each starting on a page boundary. Tiles at the far
+        borders are padded to the full size. Tile (tx, ty) has the index
+        tx * tilesY() + ty.
+        Tiles are mapped with mmap when a height in them is read and unmapped
+        again, least recently used first, when the mapped tiles would exceed
+        the memory budget. Resident memory therefore depends on the budget,
+        not on the size of the map.
+        Heights, adoptTile and the statistics may be used from several
+        threads, e.g. the simulation and the clipmap; a lock guards the cache,
+        and a thread that misses a tile holds it while the tile is mapped.
+        open and close must not run concurrently with anything else.
+ */
+class TiledHeightfield : public HeightSource
+{
+public:
+    static const std::uint32_t Magic = 0x31464854; // "THF1"
+    static const std::uint32_t Version = 1;
+    static const int DefaultTileSize = 256;
+    // larger tiles in a file are taken for corruption
+    static const int MaxTileSize = 4096;
+
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t sizeX;
+        std::uint32_t sizeY;
+        std::uint32_t tileSize;
+        float spacing;
+    };
+
+    TiledHeightfield() = default;
+    ~TiledHeightfield();
+    TiledHeightfield(const TiledHeightfield&) = delete;
+    TiledHeightfield& operator=(const TiledHeightfield&) = delete;
+
+    /* @brief write all heights of source to filename. Only one tile of
+     * samples is held in memory at a time.
+     */
+    static bool write(const std::string& filename, const HeightSource& source, int tileSize = DefaultTileSize);
+
+    /* @brief open a file written by write(); at least one tile stays mapped
+     * even if budgetBytes is smaller than a tile.
+     */
+    bool open(const std::string& filename, std::size_t budgetBytes);
+    void close();
+    bool isOpen() const;
+
+    int sizeX() const override;
+    int sizeY() const override;
+    float spacing() const override;
+    float height(int x, int y) const override;
+    /* @brief the heights at (x, y), (x, y + 1), (x + 1, y) and (x + 1, y + 1),
+     * clamped to the field, with one lock for all four
+     */
+    void cellHeights(int x, int y, float& h00, float& h01, float& h10, float& h11) const;
+
+    int tileSize() const;
+    int tilesX() const;
+    int tilesY() const;
+    std::size_t tileBytes() const;
+
+    /* @brief map a tile and read its pages, without touching the cache.
+     * Safe to call from another thread while the file is open; the result is
+     * handed to adoptTile or discardTile on the thread that reads heights.
+     * Returns nullptr on failure.
+     */
+    void* prepareTile(int tile) const;
+    // put a prepared tile into the cache, unless it is already resident
+    void adoptTile(int tile, void* mapping);
+    void discardTile(void* mapping) const;
+    bool isResident(int tile) const;
+
+    std::size_t budget() const;
+    std::size_t residentTiles() const;
+    std::size_t residentBytes() const;
+    // tiles mapped by height() since open, i.e. cache misses
+    std::size_t tileLoads() const;
+    // time height() spent waiting for those tiles
+    unsigned long stallUs() const;
+    // first reads of adopted tiles
+    std::size_t prefetchHits() const;
+
+private:
+    struct Resident
+    {
+        int tile;
+        const float* samples;
+        void* mapping;
+        std::size_t mappingSize;
+        std::vector<float> copy; // only if mapping failed
+        bool adopted;            // not read since adoptTile
+    };
+    typedef std::list<Resident> ResidentList;
+
+    // the height at x, y clamped to the field; with mMutex held
+    float sample(int x, int y) const;
+    // the samples of a tile, mapped if necessary; with mMutex held
+    const float* tile(int index) const;
+    // make room for one more tile and put it in front
+    Resident& insert(int index) const;
+    void unmap(const Resident& resident) const;
+
+    int mFile = -1;
+    Header mHeader = Header();
+    int mTilesX = 0;
+    int mTilesY = 0;
+    std::vector<std::uint64_t> mOffsets;
+    std::size_t mMaxResident = 0;
+
+    // guards everything below
+    mutable std::mutex mMutex;
+    // most recently used first
+    mutable ResidentList mResident;
+    // per tile, the entry in mResident or mResident.end()
+    mutable std::vector<ResidentList::iterator> mLookup;
+    mutable int mLastTile = -1;
+    mutable const float* mLastSamples = nullptr;
+    mutable std::size_t mTileLoads = 0;
+    mutable unsigned long mStallUs = 0;
+    mutable std::size_t mPrefetchHits = 0;
+};
+
+#endif
@@ -6,6 +6,11 @@ unsigned long Utils::clockTimeMs()
     return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
+unsigned long Utils::clockTimeUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 glm::quat Utils::quatFromEuler(float roll, float pitch, float yaw)
 {
     glm::quat forward(0, glm::vec3(1.0f, 0.0f, 0.0f));
@@ -28,6 +28,7 @@ public:
     ~Utils() = default;
 
     static unsigned long clockTimeMs();
+    static unsigned long clockTimeUs();
 
     // rotation order is yaw (around z-axis), roll (around x-axis), pitch (around y-axis)
     static glm::quat quatFromEuler(float roll, float pitch, float yaw);
@@ -0,0 +1,198 @@
+#include "VehicleInstances.h"
+#include "utils/ShaderProgram.h"
+
+#include "glm/gtx/quaternion.hpp" // for glm::toMat4
+#include "glm/gtc/type_ptr.hpp"
+#include <glm/gtx/transform.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+const char* const VehicleInstances::VertexSource = R"glsl(
+#version 120
+
+// four attribute slots, one column each, advancing once per instance
+attribute mat4 instanceTransform;
+
+void main()
+{
+    vec4 position = instanceTransform * gl_Vertex;
+    vec3 normal = normalize(gl_NormalMatrix * (mat3(instanceTransform) * gl_Normal));
+
+    // the directional light 0 with the default material, as in the fixed function path
+    vec3 light = normalize(gl_LightSource[0].position.xyz);
+    float diffuse = max(dot(normal, light), 0.0);
+    gl_FrontColor = gl_FrontLightModelProduct.sceneColor + gl_FrontLightProduct[0].ambient
+                    + gl_FrontLightProduct[0].diffuse * diffuse;
+    gl_Position = gl_ModelViewProjectionMatrix * position;
+}
+)glsl";
+
+const char* const VehicleInstances::FragmentSource = R"glsl(
+#version 120
+
+void main()
+{
+    gl_FragColor = gl_Color;
+}
+)glsl";
+
+namespace
+{
+    bool hasExtension(const char* name)
+    {
+        const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+        const std::size_t length = std::strlen(name);
+        for (const char* found = extensions; found != NULL && (found = std::strstr(found, name)) != NULL; found += length)
+        {
+            // whole names only
+            if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+VehicleInstances::~VehicleInstances()
+{
+    release();
+}
+
+bool VehicleInstances::setInstancingEnabled(bool enabled)
+{
+    release();
+    if (!enabled)
+    {
+        return true;
+    }
+
+    if (!hasExtension("GL_ARB_draw_instanced") || !hasExtension("GL_ARB_instanced_arrays"))
+    {
+        std::cerr << "No instanced arrays, vehicles are drawn one by one" << std::endl;
+        return false;
+    }
+
+    mProgram = linkShaderProgram(VertexSource, FragmentSource, "Vehicle instancing");
+    if (mProgram == 0)
+    {
+        return false;
+    }
+    // the four columns of the matrix take the location and the three after it
+    mInstanceTransform = glGetAttribLocation(mProgram, "instanceTransform");
+    if (mInstanceTransform < 0)
+    {
+        std::cerr << "No instanceTransform attribute, vehicles are drawn one by one" << std::endl;
+        release();
+        return false;
+    }
+    glGenBuffersARB(1, &mInstanceBuffer);
+    return true;
+}
+
+bool VehicleInstances::isInstancingEnabled() const
+{
+    return mProgram != 0;
+}
+
+void VehicleInstances::release()
+{
+    if (mProgram != 0)
+    {
+        glDeleteProgram(mProgram);
+        mProgram = 0;
+    }
+    if (mInstanceBuffer != 0)
+    {
+        glDeleteBuffersARB(1, &mInstanceBuffer);
+        mInstanceBuffer = 0;
+    }
+    mInstanceTransform = -1;
+    mInstanceCapacity = 0;
+}
+
+void VehicleInstances::begin(const glm::vec3& viewer, float radius, const glm::mat4& model)
+{
+    // keeps its capacity, no allocations once the number of vehicles is stable
+    mTransforms.clear();
+    mViewer = viewer;
+    mRadius = radius;
+    mModel = model;
+    mStats = Stats();
+}
+
+void VehicleInstances::add(const glm::vec3& position, const glm::quat& orientation)
+{
+    mStats.vehicles++;
+    const glm::vec3 distance = position - mViewer;
+    if (glm::dot(distance, distance) > mRadius * mRadius)
+    {
+        return;
+    }
+    mTransforms.push_back(glm::translate(glm::mat4(), position) * glm::toMat4(orientation) * mModel);
+}
+
+void VehicleInstances::draw(const VehicleMesh& mesh)
+{
+    mStats.drawn = mTransforms.size();
+    const GLsizei indexCount = (GLsizei) mesh.indices().size();
+    if (mTransforms.empty() || indexCount == 0)
+    {
+        return;
+    }
+
+    mesh.bind();
+    if (mProgram != 0)
+    {
+        // orphan the buffer of the last frame, so that it is not waited for
+        const std::size_t bytes = sizeof(glm::mat4) * mTransforms.size();
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, mInstanceBuffer);
+        mInstanceCapacity = std::max(mInstanceCapacity, bytes);
+        glBufferDataARB(GL_ARRAY_BUFFER_ARB, mInstanceCapacity, NULL, GL_STREAM_DRAW_ARB);
+        glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, 0, bytes, mTransforms.data());
+        for (GLint column = 0; column < 4; ++column)
+        {
+            const GLuint location = mInstanceTransform + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), BUFFER_OFFSET(sizeof(glm::vec4) * column));
+            glVertexAttribDivisorARB(location, 1);
+        }
+
+        glUseProgram(mProgram);
+        glDrawElementsInstancedARB(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, BUFFER_OFFSET(0), (GLsizei) mTransforms.size());
+        mStats.drawCalls++;
+        glUseProgram(0);
+
+        for (GLint column = 0; column < 4; ++column)
+        {
+            const GLuint location = mInstanceTransform + column;
+            glVertexAttribDivisorARB(location, 0);
+            glDisableVertexAttribArray(location);
+        }
+    }
+    else
+    {
+        for (const glm::mat4& transform : mTransforms)
+        {
+            glPushMatrix();
+            glMultMatrixf(glm::value_ptr(transform));
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, BUFFER_OFFSET(0));
+            glPopMatrix();
+            mStats.drawCalls++;
+        }
+    }
+    mesh.unbind();
+}
+
+const std::vector<glm::mat4>& VehicleInstances::transforms() const
+{
+    return mTransforms;
+}
+
+const VehicleInstances::Stats& VehicleInstances::stats() const
+{
+    return mStats;
+}
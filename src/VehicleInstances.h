@@ -0,0 +1,78 @@
+#ifndef VEHICLEINSTANCES_H
+#define VEHICLEINSTANCES_H
+
+#include "VehicleMesh.h"
+
+#include <GL/glut.h>
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include <vector>
+
+/**
+ @brief Draws many vehicles with the same VehicleMesh. Every frame the
+        vehicles are added with their pose; those farther from the viewer
+        than the draw radius are culled, the others become one model
+        transform each. With instancing (GL_ARB_draw_instanced and
+        GL_ARB_instanced_arrays) the transforms are streamed into a buffer
+        and all vehicles are drawn by one call, with a GLSL 1.20 shader that
+        lights them like the fixed function light 0. Without it, or after
+        setInstancingEnabled(false), every vehicle is drawn by a call of its
+        own with its transform on the matrix stack. The whole mesh is drawn
+        as it is, the wheels neither spin nor steer.
+ */
+class VehicleInstances
+{
+public:
+    struct Stats
+    {
+        // added since begin(), and left after culling
+        std::size_t vehicles = 0;
+        std::size_t drawn = 0;
+        unsigned int drawCalls = 0;
+    };
+
+    VehicleInstances() = default;
+    ~VehicleInstances();
+    VehicleInstances(const VehicleInstances&) = delete;
+    VehicleInstances& operator=(const VehicleInstances&) = delete;
+
+    /* @brief compile the instancing shader, or release it to use the fallback.
+     * Needs a current GL context; returns false if the context cannot
+     * instance, in which case the fallback stays in use.
+     */
+    bool setInstancingEnabled(bool enabled);
+    bool isInstancingEnabled() const;
+    void release();
+
+    /* @brief start a frame: vehicles farther than radius from viewer are
+     * culled. model is applied before the pose of every vehicle, see
+     * Tank::modelTransform.
+     */
+    void begin(const glm::vec3& viewer, float radius, const glm::mat4& model);
+    void add(const glm::vec3& position, const glm::quat& orientation);
+    // draw all vehicles added since begin
+    void draw(const VehicleMesh& mesh);
+
+    // the transforms of the vehicles that were not culled
+    const std::vector<glm::mat4>& transforms() const;
+    const Stats& stats() const;
+
+    static const char* const VertexSource;
+    static const char* const FragmentSource;
+
+private:
+    std::vector<glm::mat4> mTransforms;
+    glm::vec3 mViewer;
+    float mRadius = 0.0f;
+    glm::mat4 mModel;
+    Stats mStats;
+
+    GLuint mProgram = 0;
+    GLuint mInstanceBuffer = 0;
+    GLint mInstanceTransform = -1;
+    // bytes allocated for mInstanceBuffer
+    std::size_t mInstanceCapacity = 0;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "VehicleMesh.h"
+
+#include "glm/gtc/type_ptr.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#define BUFFER_OFFSET(i) ((char*)NULL + (i))
+
+VehicleMesh::VehicleMesh(const std::map<std::string, VertexObject>& parts)
+{
+    // vertices with the same position and normal are shared within the mesh
+    std::map<std::array<float, 6>, GLuint> shared;
+    for (const auto& entry : parts)
+    {
+        Part part;
+        part.name = entry.first;
+        part.firstIndex = (GLsizei) mIndices.size();
+
+        glm::vec3 minimum(0.0f);
+        glm::vec3 maximum(0.0f);
+        bool isEmpty = true;
+        for (const VertexObject::Face& face : entry.second.faces())
+        {
+            const std::vector<glm::vec3>& positions = face.vertices;
+            const std::vector<glm::vec3>& normals = face.normals;
+            std::array<GLuint, 3> triangle;
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                Vertex vertex;
+                vertex.position = positions[i];
+                vertex.normal = i < normals.size() ? normals[i] : glm::vec3(0.0f, 0.0f, 1.0f);
+                const std::array<float, 6> key = { { vertex.position.x, vertex.position.y, vertex.position.z,
+                                                     vertex.normal.x, vertex.normal.y, vertex.normal.z } };
+                auto found = shared.find(key);
+                if (found == shared.end())
+                {
+                    found = shared.insert(std::make_pair(key, (GLuint) mVertices.size())).first;
+                    mVertices.push_back(vertex);
+                }
+
+                minimum = isEmpty ? vertex.position : glm::min(minimum, vertex.position);
+                maximum = isEmpty ? vertex.position : glm::max(maximum, vertex.position);
+                isEmpty = false;
+
+                // a fan around the first vertex
+                if (i < 2)
+                {
+                    triangle[i] = found->second;
+                    continue;
+                }
+                triangle[2] = found->second;
+                mIndices.insert(mIndices.end(), triangle.begin(), triangle.end());
+                triangle[1] = triangle[2];
+            }
+        }
+
+        part.indexCount = (GLsizei) mIndices.size() - part.firstIndex;
+        const glm::vec3 extent = maximum - minimum;
+        part.pivot = (minimum + maximum) * 0.5f;
+        const int axle = extent.x <= extent.y && extent.x <= extent.z ? 0 : (extent.y <= extent.z ? 1 : 2);
+        part.axle = glm::vec3(0.0f);
+        part.axle[axle] = 1.0f;
+        part.radius = std::max(std::max(extent.x, extent.y), extent.z) * 0.5f;
+        mParts.push_back(part);
+    }
+}
+
+VehicleMesh::~VehicleMesh()
+{
+    if (mVertexBuffer != 0)
+    {
+        glDeleteBuffersARB(1, &mVertexBuffer);
+        glDeleteBuffersARB(1, &mIndexBuffer);
+    }
+}
+
+const std::vector<VehicleMesh::Vertex>& VehicleMesh::vertices() const
+{
+    return mVertices;
+}
+
+const std::vector<GLuint>& VehicleMesh::indices() const
+{
+    return mIndices;
+}
+
+const std::vector<VehicleMesh::Part>& VehicleMesh::parts() const
+{
+    return mParts;
+}
+
+int VehicleMesh::partIndex(const std::string& name) const
+{
+    for (std::size_t i = 0; i < mParts.size(); ++i)
+    {
+        if (mParts[i].name == name)
+        {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+void VehicleMesh::bind() const
+{
+    if (mVertexBuffer == 0)
+    {
+        upload();
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, mVertexBuffer);
+    glVertexPointer(3, GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, position)));
+    glNormalPointer(GL_FLOAT, sizeof(Vertex), BUFFER_OFFSET(offsetof(Vertex, normal)));
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, mIndexBuffer);
+}
+
+void VehicleMesh::drawPart(std::size_t part, const glm::mat4& transform) const
+{
+    glPushMatrix();
+    glMultMatrixf(glm::value_ptr(transform));
+    drawPart(part);
+    glPopMatrix();
+}
+
+void VehicleMesh::drawPart(std::size_t part) const
+{
+    const Part& range = mParts[part];
+    if (range.indexCount > 0)
+    {
+        glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+                       BUFFER_OFFSET(range.firstIndex * sizeof(GLuint)));
+    }
+}
+
+void VehicleMesh::unbind() const
+{
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+bool VehicleMesh::isUploaded() const
+{
+    return mVertexBuffer != 0;
+}
+
+void VehicleMesh::upload() const
+{
+    glGenBuffersARB(1, &mVertexBuffer);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, mVertexBuffer);
+    glBufferDataARB(GL_ARRAY_BUFFER_ARB, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_STATIC_DRAW_ARB);
+
+    glGenBuffersARB(1, &mIndexBuffer);
+    glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, mIndexBuffer);
+    glBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, sizeof(GLuint) * mIndices.size(), mIndices.data(), GL_STATIC_DRAW_ARB);
+}
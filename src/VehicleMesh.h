@@ -0,0 +1,83 @@
+#ifndef VEHICLEMESH_H
+#define VEHICLEMESH_H
+
+#include "VertexObject.h"
+
+#include <GL/glut.h>
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ @brief GPU copy of a vehicle model: the faces of all parts triangulated
+        once into one indexed vertex buffer, with every part a range of the
+        index buffer. A part is drawn with a transform of its own, so that
+        wheels spin and steer by a matrix instead of new geometry. The
+        buffers are uploaded by the first bind() and the mesh is immutable
+        after that, so it can be shared by all vehicles with the same model.
+        Building it makes no GL calls; bind(), drawPart() and unbind() must
+        be called on the thread with the GL context.
+ */
+class VehicleMesh
+{
+public:
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    struct Part
+    {
+        std::string name;
+        // range in indices()
+        GLsizei firstIndex;
+        GLsizei indexCount;
+        // centre of the bounding box, the point it spins and steers around
+        glm::vec3 pivot;
+        // unit axis along the thinnest extent of the bounding box, for a wheel its axle
+        glm::vec3 axle;
+        // half of the largest extent of the bounding box, for a wheel its radius
+        float radius;
+    };
+
+    /* @brief triangulate the parts of a model as read by ObjFileReader.
+     * Polygons are split into fans and equal vertices are shared.
+     */
+    explicit VehicleMesh(const std::map<std::string, VertexObject>& parts);
+    ~VehicleMesh();
+    VehicleMesh(const VehicleMesh&) = delete;
+    VehicleMesh& operator=(const VehicleMesh&) = delete;
+
+    const std::vector<Vertex>& vertices() const;
+    // three per triangle
+    const std::vector<GLuint>& indices() const;
+    const std::vector<Part>& parts() const;
+    // the index of the part of that name in parts(), or -1
+    int partIndex(const std::string& name) const;
+
+    // set up the vertex arrays, uploading the buffers the first time
+    void bind() const;
+    // draw a part with transform applied on top of the current modelview matrix
+    void drawPart(std::size_t part, const glm::mat4& transform) const;
+    void drawPart(std::size_t part) const;
+    void unbind() const;
+
+    bool isUploaded() const;
+
+private:
+    void upload() const;
+
+    std::vector<Vertex> mVertices;
+    std::vector<GLuint> mIndices;
+    std::vector<Part> mParts;
+
+    // created by the first bind()
+    mutable GLuint mVertexBuffer = 0;
+    mutable GLuint mIndexBuffer = 0;
+};
+
+#endif
@@ -0,0 +1,387 @@
+#include "VehicleSystem.h"
+#include "Constants.h"
+
+#include "glm/mat3x3.hpp"
+#include <algorithm>
+#include <cmath>
+
+#include "utils/CpuFeatures.h"
+
+const float VehicleSystem::Gravity = 0.1f;
+const float VehicleSystem::Alignment = 0.2f;
+
+namespace
+{
+    // as in Simulation::step
+    const float GroundEpsilon = 1e-8f;
+
+    // the arrays of VehicleSystem the kernels work on
+    struct Streams
+    {
+        float* x;
+        float* y;
+        float* z;
+        float* headingX;
+        float* headingY;
+        const float* speed;
+        const float* turnCos;
+        const float* turnSin;
+        float* upX;
+        float* upY;
+        float* upZ;
+        float* onGround;
+        const float* altitude;
+        const float* normalX;
+        const float* normalY;
+        const float* normalZ;
+    };
+
+    /* The reference kernels for one vehicle. The SIMD kernels evaluate the
+     * same expressions in the same order, which keeps them bit-identical.
+     */
+    inline void integrate(const Streams& s, size_t i)
+    {
+        const float rx = s.headingX[i] * s.turnCos[i] - s.headingY[i] * s.turnSin[i];
+        const float ry = s.headingX[i] * s.turnSin[i] + s.headingY[i] * s.turnCos[i];
+        // renormalised, or the rounding of the rotation changes its length and the speed
+        const float length = std::sqrt(rx * rx + ry * ry);
+        const float hx = rx / length;
+        const float hy = ry / length;
+        s.headingX[i] = hx;
+        s.headingY[i] = hy;
+        s.x[i] = s.x[i] + hx * s.speed[i];
+        s.y[i] = s.y[i] + hy * s.speed[i];
+        s.z[i] = s.z[i] - VehicleSystem::Gravity;
+    }
+
+    inline void settle(const Streams& s, size_t i)
+    {
+        const float altitude = s.altitude[i];
+        const float z = altitude > s.z[i] ? altitude : s.z[i];
+        s.z[i] = z;
+        const bool onGround = z - altitude < GroundEpsilon;
+        s.onGround[i] = onGround ? 1.0f : 0.0f;
+        if (onGround)
+        {
+            const float ux = s.upX[i] + (s.normalX[i] - s.upX[i]) * VehicleSystem::Alignment;
+            const float uy = s.upY[i] + (s.normalY[i] - s.upY[i]) * VehicleSystem::Alignment;
+            const float uz = s.upZ[i] + (s.normalZ[i] - s.upZ[i]) * VehicleSystem::Alignment;
+            const float length = std::sqrt(ux * ux + uy * uy + uz * uz);
+            s.upX[i] = ux / length;
+            s.upY[i] = uy / length;
+            s.upZ[i] = uz / length;
+        }
+    }
+
+#if defined(AVX2_KERNEL)
+    const size_t AvxLanes = 8;
+
+    // process the largest multiple of 8 vehicles, return how many that were
+    AVX2_KERNEL size_t integrateAvx2(const Streams& s, size_t count)
+    {
+        const __m256 gravity = _mm256_set1_ps(VehicleSystem::Gravity);
+        size_t i = 0;
+        for (; i + AvxLanes <= count; i += AvxLanes)
+        {
+            const __m256 headingX = _mm256_load_ps(s.headingX + i);
+            const __m256 headingY = _mm256_load_ps(s.headingY + i);
+            const __m256 turnCos = _mm256_load_ps(s.turnCos + i);
+            const __m256 turnSin = _mm256_load_ps(s.turnSin + i);
+            const __m256 speed = _mm256_load_ps(s.speed + i);
+            const __m256 rx = _mm256_sub_ps(_mm256_mul_ps(headingX, turnCos), _mm256_mul_ps(headingY, turnSin));
+            const __m256 ry = _mm256_add_ps(_mm256_mul_ps(headingX, turnSin), _mm256_mul_ps(headingY, turnCos));
+            const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry)));
+            const __m256 hx = _mm256_div_ps(rx, length);
+            const __m256 hy = _mm256_div_ps(ry, length);
+            _mm256_store_ps(s.headingX + i, hx);
+            _mm256_store_ps(s.headingY + i, hy);
+            _mm256_store_ps(s.x + i, _mm256_add_ps(_mm256_load_ps(s.x + i), _mm256_mul_ps(hx, speed)));
+            _mm256_store_ps(s.y + i, _mm256_add_ps(_mm256_load_ps(s.y + i), _mm256_mul_ps(hy, speed)));
+            _mm256_store_ps(s.z + i, _mm256_sub_ps(_mm256_load_ps(s.z + i), gravity));
+        }
+        return i;
+    }
+
+    AVX2_KERNEL size_t settleAvx2(const Streams& s, size_t count)
+    {
+        const __m256 epsilon = _mm256_set1_ps(GroundEpsilon);
+        const __m256 alignment = _mm256_set1_ps(VehicleSystem::Alignment);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + AvxLanes <= count; i += AvxLanes)
+        {
+            const __m256 altitude = _mm256_load_ps(s.altitude + i);
+            const __m256 z = _mm256_max_ps(altitude, _mm256_load_ps(s.z + i));
+            _mm256_store_ps(s.z + i, z);
+            const __m256 onGround = _mm256_cmp_ps(_mm256_sub_ps(z, altitude), epsilon, _CMP_LT_OQ);
+            _mm256_store_ps(s.onGround + i, _mm256_and_ps(onGround, one));
+
+            const __m256 upX = _mm256_load_ps(s.upX + i);
+            const __m256 upY = _mm256_load_ps(s.upY + i);
+            const __m256 upZ = _mm256_load_ps(s.upZ + i);
+            const __m256 ux = _mm256_add_ps(upX, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(s.normalX + i), upX), alignment));
+            const __m256 uy = _mm256_add_ps(upY, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(s.normalY + i), upY), alignment));
+            const __m256 uz = _mm256_add_ps(upZ, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(s.normalZ + i), upZ), alignment));
+            const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ux, ux), _mm256_mul_ps(uy, uy)), _mm256_mul_ps(uz, uz)));
+            // vehicles in the air keep their up vector
+            _mm256_store_ps(s.upX + i, _mm256_blendv_ps(upX, _mm256_div_ps(ux, length), onGround));
+            _mm256_store_ps(s.upY + i, _mm256_blendv_ps(upY, _mm256_div_ps(uy, length), onGround));
+            _mm256_store_ps(s.upZ + i, _mm256_blendv_ps(upZ, _mm256_div_ps(uz, length), onGround));
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+    const size_t SseLanes = 4;
+
+    inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // process the largest multiple of 4 vehicles, return how many that were
+    size_t integrateSse2(const Streams& s, size_t count)
+    {
+        const __m128 gravity = _mm_set1_ps(VehicleSystem::Gravity);
+        size_t i = 0;
+        for (; i + SseLanes <= count; i += SseLanes)
+        {
+            const __m128 headingX = _mm_load_ps(s.headingX + i);
+            const __m128 headingY = _mm_load_ps(s.headingY + i);
+            const __m128 turnCos = _mm_load_ps(s.turnCos + i);
+            const __m128 turnSin = _mm_load_ps(s.turnSin + i);
+            const __m128 speed = _mm_load_ps(s.speed + i);
+            const __m128 rx = _mm_sub_ps(_mm_mul_ps(headingX, turnCos), _mm_mul_ps(headingY, turnSin));
+            const __m128 ry = _mm_add_ps(_mm_mul_ps(headingX, turnSin), _mm_mul_ps(headingY, turnCos));
+            const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)));
+            const __m128 hx = _mm_div_ps(rx, length);
+            const __m128 hy = _mm_div_ps(ry, length);
+            _mm_store_ps(s.headingX + i, hx);
+            _mm_store_ps(s.headingY + i, hy);
+            _mm_store_ps(s.x + i, _mm_add_ps(_mm_load_ps(s.x + i), _mm_mul_ps(hx, speed)));
+            _mm_store_ps(s.y + i, _mm_add_ps(_mm_load_ps(s.y + i), _mm_mul_ps(hy, speed)));
+            _mm_store_ps(s.z + i, _mm_sub_ps(_mm_load_ps(s.z + i), gravity));
+        }
+        return i;
+    }
+
+    size_t settleSse2(const Streams& s, size_t count)
+    {
+        const __m128 epsilon = _mm_set1_ps(GroundEpsilon);
+        const __m128 alignment = _mm_set1_ps(VehicleSystem::Alignment);
+        const __m128 one = _mm_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + SseLanes <= count; i += SseLanes)
+        {
+            const __m128 altitude = _mm_load_ps(s.altitude + i);
+            const __m128 z = _mm_max_ps(altitude, _mm_load_ps(s.z + i));
+            _mm_store_ps(s.z + i, z);
+            const __m128 onGround = _mm_cmplt_ps(_mm_sub_ps(z, altitude), epsilon);
+            _mm_store_ps(s.onGround + i, _mm_and_ps(onGround, one));
+
+            const __m128 upX = _mm_load_ps(s.upX + i);
+            const __m128 upY = _mm_load_ps(s.upY + i);
+            const __m128 upZ = _mm_load_ps(s.upZ + i);
+            const __m128 ux = _mm_add_ps(upX, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(s.normalX + i), upX), alignment));
+            const __m128 uy = _mm_add_ps(upY, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(s.normalY + i), upY), alignment));
+            const __m128 uz = _mm_add_ps(upZ, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(s.normalZ + i), upZ), alignment));
+            const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(uy, uy)), _mm_mul_ps(uz, uz)));
+            // vehicles in the air keep their up vector
+            _mm_store_ps(s.upX + i, select(onGround, _mm_div_ps(ux, length), upX));
+            _mm_store_ps(s.upY + i, select(onGround, _mm_div_ps(uy, length), upY));
+            _mm_store_ps(s.upZ + i, select(onGround, _mm_div_ps(uz, length), upZ));
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__)
+    size_t integrateSimd(const Streams& s, size_t count)
+    {
+#if defined(__AVX2__)
+        return integrateAvx2(s, count);
+#else
+#if defined(AVX2_KERNEL)
+        if (hasAvx2())
+        {
+            return integrateAvx2(s, count);
+        }
+#endif
+        return integrateSse2(s, count);
+#endif
+    }
+
+    size_t settleSimd(const Streams& s, size_t count)
+    {
+#if defined(__AVX2__)
+        return settleAvx2(s, count);
+#else
+#if defined(AVX2_KERNEL)
+        if (hasAvx2())
+        {
+            return settleAvx2(s, count);
+        }
+#endif
+        return settleSse2(s, count);
+#endif
+    }
+#endif
+}
+
+std::size_t VehicleSystem::add(const glm::vec3& position, float heading, float speed, float turnRate)
+{
+    const float radians = heading / 180.0f * pi;
+    mX.push_back(position.x);
+    mY.push_back(position.y);
+    mZ.push_back(position.z);
+    mHeadingX.push_back(std::cos(radians));
+    mHeadingY.push_back(std::sin(radians));
+    mSpeed.push_back(0.0f);
+    mTurnCos.push_back(1.0f);
+    mTurnSin.push_back(0.0f);
+    mUpX.push_back(0.0f);
+    mUpY.push_back(0.0f);
+    mUpZ.push_back(1.0f);
+    mOnGround.push_back(0.0f);
+    // the scratch arrays grow with the vehicles, so that step never moves them
+    mQueryPositions.emplace_back();
+    mQueryNormals.emplace_back();
+    mAltitude.push_back(0.0f);
+    mNormalX.push_back(0.0f);
+    mNormalY.push_back(0.0f);
+    mNormalZ.push_back(0.0f);
+    setControls(mX.size() - 1, speed, turnRate);
+    return mX.size() - 1;
+}
+
+void VehicleSystem::setControls(std::size_t index, float speed, float turnRate)
+{
+    const float radians = turnRate / 180.0f * pi;
+    mSpeed[index] = speed;
+    mTurnCos[index] = std::cos(radians);
+    mTurnSin[index] = std::sin(radians);
+}
+
+void VehicleSystem::clear()
+{
+    for (Floats* stream : { &mX, &mY, &mZ, &mHeadingX, &mHeadingY, &mSpeed, &mTurnCos, &mTurnSin, &mUpX, &mUpY, &mUpZ, &mOnGround,
+                    &mAltitude, &mNormalX, &mNormalY, &mNormalZ })
+    {
+        stream->clear();
+    }
+    mQueryPositions.clear();
+    mQueryNormals.clear();
+}
+
+std::size_t VehicleSystem::size() const
+{
+    return mX.size();
+}
+
+void VehicleSystem::queryGround(const Landscape& landscape)
+{
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        mQueryPositions[i] = glm::vec2(mX[i], mY[i]);
+    }
+    landscape.getLocalEnvironments(Span<const glm::vec2>(mQueryPositions.data(), count),
+                    Span<float>(mAltitude.data(), count), Span<glm::vec3>(mQueryNormals.data(), count));
+    for (size_t i = 0; i < count; ++i)
+    {
+        mNormalX[i] = mQueryNormals[i].x;
+        mNormalY[i] = mQueryNormals[i].y;
+        mNormalZ[i] = mQueryNormals[i].z;
+    }
+}
+
+void VehicleSystem::step(const Landscape& landscape)
+{
+    const size_t count = size();
+    const Streams streams = { mX.data(), mY.data(), mZ.data(), mHeadingX.data(), mHeadingY.data(),
+                    mSpeed.data(), mTurnCos.data(), mTurnSin.data(), mUpX.data(), mUpY.data(), mUpZ.data(),
+                    mOnGround.data(), mAltitude.data(), mNormalX.data(), mNormalY.data(), mNormalZ.data() };
+
+    size_t done = 0;
+#if defined(__SSE2__)
+    done = integrateSimd(streams, count);
+#endif
+    for (size_t i = done; i < count; ++i)
+    {
+        integrate(streams, i);
+    }
+
+    queryGround(landscape);
+
+    done = 0;
+#if defined(__SSE2__)
+    done = settleSimd(streams, count);
+#endif
+    for (size_t i = done; i < count; ++i)
+    {
+        settle(streams, i);
+    }
+}
+
+void VehicleSystem::stepScalar(const Landscape& landscape)
+{
+    const size_t count = size();
+    const Streams streams = { mX.data(), mY.data(), mZ.data(), mHeadingX.data(), mHeadingY.data(),
+                    mSpeed.data(), mTurnCos.data(), mTurnSin.data(), mUpX.data(), mUpY.data(), mUpZ.data(),
+                    mOnGround.data(), mAltitude.data(), mNormalX.data(), mNormalY.data(), mNormalZ.data() };
+    for (size_t i = 0; i < count; ++i)
+    {
+        integrate(streams, i);
+    }
+
+    queryGround(landscape);
+    for (size_t i = 0; i < count; ++i)
+    {
+        settle(streams, i);
+    }
+}
+
+glm::vec3 VehicleSystem::position(std::size_t index) const
+{
+    return glm::vec3(mX[index], mY[index], mZ[index]);
+}
+
+glm::vec2 VehicleSystem::heading(std::size_t index) const
+{
+    return glm::vec2(mHeadingX[index], mHeadingY[index]);
+}
+
+glm::vec3 VehicleSystem::up(std::size_t index) const
+{
+    return glm::vec3(mUpX[index], mUpY[index], mUpZ[index]);
+}
+
+float VehicleSystem::speed(std::size_t index) const
+{
+    return mSpeed[index];
+}
+
+bool VehicleSystem::isOnGround(std::size_t index) const
+{
+    return mOnGround[index] != 0.0f;
+}
+
+glm::quat VehicleSystem::orientation(std::size_t index) const
+{
+    // the heading projected onto the plane perpendicular to up
+    const glm::vec3 up = this->up(index);
+    const glm::vec3 heading(mHeadingX[index], mHeadingY[index], 0.0f);
+    const glm::vec3 forward = glm::normalize(heading - up * glm::dot(heading, up));
+    const glm::vec3 side = glm::cross(up, forward);
+    return glm::quat_cast(glm::mat3(forward, side, up));
+}
+
+const char* VehicleSystem::kernelName()
+{
+#if defined(__SSE2__)
+    return hasAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,86 @@
+#ifndef VEHICLESYSTEM_H
+#define VEHICLESYSTEM_H
+
+#include "Landscape.h"
+#include "utils/AlignedAllocator.h"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ @brief Many simple vehicles, e.g. AI traffic, stored as structure of arrays:
+        one array per coordinate of the position, heading, speed, turn rate,
+        up vector and ground contact. Every vehicle drives at its speed and
+        turns by its turn rate each tick, falls by Gravity and is put onto the
+        landscape below it, where its up vector leans towards the surface
+        normal like Tank::rotateToMatchSurfaceNormal. step() advances 8 (AVX2,
+        if the CPU has it) or 4 (SSE2) vehicles at a time and queries the
+        ground of all of them with one Landscape::getLocalEnvironments
+        call; the results are bit-identical to stepScalar.
+ */
+class VehicleSystem
+{
+public:
+    // distance per tick, as in Tank::move
+    static const float Gravity;
+    // share of the difference to the surface normal the up vector turns per tick
+    static const float Alignment;
+
+    /* @brief add a vehicle at position, heading in degrees around z, driving
+     * speed per tick and turning by turnRate degrees per tick. Returns its
+     * index.
+     */
+    std::size_t add(const glm::vec3& position, float heading, float speed, float turnRate);
+    void setControls(std::size_t index, float speed, float turnRate);
+    void clear();
+    std::size_t size() const;
+
+    void step(const Landscape& landscape);
+    // the same without SIMD, the reference for the kernels
+    void stepScalar(const Landscape& landscape);
+
+    glm::vec3 position(std::size_t index) const;
+    // unit direction of travel in the xy plane
+    glm::vec2 heading(std::size_t index) const;
+    glm::vec3 up(std::size_t index) const;
+    float speed(std::size_t index) const;
+    bool isOnGround(std::size_t index) const;
+    // rotation from model to world space: x along the heading, z up
+    glm::quat orientation(std::size_t index) const;
+
+    // name of the vectorised kernel used by step
+    static const char* kernelName();
+
+private:
+    typedef std::vector<float, AlignedAllocator<float>> Floats;
+
+    void queryGround(const Landscape& landscape);
+
+    Floats mX;
+    Floats mY;
+    Floats mZ;
+    Floats mHeadingX;
+    Floats mHeadingY;
+    Floats mSpeed;
+    // cosine and sine of the turn rate
+    Floats mTurnCos;
+    Floats mTurnSin;
+    Floats mUpX;
+    Floats mUpY;
+    Floats mUpZ;
+    // 1 on the ground, 0 in the air
+    Floats mOnGround;
+
+    // the terrain query takes and returns pairs and triples
+    std::vector<glm::vec2> mQueryPositions;
+    std::vector<glm::vec3> mQueryNormals;
+    Floats mAltitude;
+    Floats mNormalX;
+    Floats mNormalY;
+    Floats mNormalZ;
+};
+
+#endif
@@ -45,3 +45,7 @@ std::vector<VertexObject::Face> VertexObject::getFaces()
     return mFaces;
 }
 
+const std::vector<VertexObject::Face>& VertexObject::faces() const
+{
+    return mFaces;
+}
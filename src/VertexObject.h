@@ -35,6 +35,7 @@ public:
     void setName(std::string name);
     void addFace(int vertexNum, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals);
     std::vector<Face> getFaces();
+    const std::vector<Face>& faces() const;
 
 protected:
     std::vector<Face> mFaces;
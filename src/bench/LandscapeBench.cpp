@@ -0,0 +1,84 @@
+/*
+ * Throughput of the terrain queries: one getLocalEnvironment call per agent,
+ * with and without the plane table, compared to one getLocalEnvironments
+ * call for all agents of a tick.
+ *
+ * usage: LandscapeBench [agents] [ticks]
+ */
+#include "../Landscape.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t agents = argc > 1 ? std::atoi(argv[1]) : 512;
+    const int ticks = argc > 2 ? std::atoi(argv[2]) : 5000;
+
+    Landscape landscape;
+    landscape.generate(Landscape::Type::RANDOM);
+
+    std::mt19937 generator;
+    std::uniform_real_distribution<float> dis(0.0f, 1000.0f);
+    std::vector<glm::vec2> positions(agents);
+    for (auto& position : positions)
+    {
+        position = glm::vec2(dis(generator), dis(generator));
+    }
+    std::vector<float> altitudes(agents);
+    std::vector<glm::vec3> normals(agents);
+
+    // one query per agent
+    double checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        for (size_t i = 0; i < agents; ++i)
+        {
+            landscape.getLocalEnvironment(positions[i].x, positions[i].y, altitudes[i], normals[i]);
+        }
+        checksum += altitudes[tick % agents];
+    }
+    const double single = secondsSince(start);
+
+    // one query per agent, from precomputed planes
+    landscape.setUsePlaneTable(true);
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        for (size_t i = 0; i < agents; ++i)
+        {
+            landscape.getLocalEnvironment(positions[i].x, positions[i].y, altitudes[i], normals[i]);
+        }
+        checksum += altitudes[tick % agents];
+    }
+    const double planes = secondsSince(start);
+
+    // one batch per tick
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        landscape.getLocalEnvironments(positions, altitudes, normals);
+        checksum += altitudes[tick % agents];
+    }
+    const double batch = secondsSince(start);
+
+    const double queries = static_cast<double>(agents) * ticks;
+    std::cout << "agents: " << agents << ", ticks: " << ticks << ", kernel: " << Landscape::batchKernelName() << std::endl;
+    std::cout << "getLocalEnvironment:  " << single / queries * 1e9 << " ns/query" << std::endl;
+    std::cout << "getLocalEnvironment with plane table: " << planes / queries * 1e9 << " ns/query" << std::endl;
+    std::cout << "getLocalEnvironments: " << batch / queries * 1e9 << " ns/query" << std::endl;
+    std::cout << "speedup: " << single / batch << "x (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Frame time of Landscape::draw on the heightmap landscape: the immediate
+ * mode path, a glBegin/glEnd per triangle, compared to the per-tile vertex
+ * buffers of LandscapeTiles and to the clipmap, around the centre of the
+ * map for the draw radius of MainWindow (100) and larger ones. The first
+ * frame of each mode uploads its buffers and is not timed. Needs a window
+ * for its GL context.
+ *
+ * usage: src/LandscapeDrawBench [frames] [radius...]   (run from the directory with images/)
+ */
+#include "../Landscape.h"
+
+#include <GL/glut.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 50;
+    std::vector<float> radii;
+    for (int i = 2; i < argc; ++i)
+    {
+        radii.push_back((float) std::atof(argv[i]));
+    }
+    if (radii.empty())
+    {
+        radii = { 100.0f, 300.0f, 1000.0f };
+    }
+
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(600, 400);
+    glutCreateWindow(argv[0]);
+
+    Landscape landscape;
+    landscape.generate(Landscape::Type::FILE);
+    // the heightmap is 1081 x 1081 support points, 2 units apart
+    const glm::vec2 centre(1080.0f, 1080.0f);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glFrustum(-1.0, 1.0, -1.0, 1.0, 1.5, 5000.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glTranslatef(-centre.x, -centre.y, -1500.0f);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_DEPTH_TEST);
+
+    const Landscape::RenderMode modes[] = { Landscape::RenderMode::IMMEDIATE, Landscape::RenderMode::TILES, Landscape::RenderMode::CLIPMAP };
+    const char* names[] = { "immediate", "tiles", "clipmap" };
+    for (float radius : radii)
+    {
+        for (int mode = 0; mode < 3; ++mode)
+        {
+            landscape.setRenderMode(modes[mode]);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            landscape.draw(centre, radius);
+            glFinish();
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                landscape.draw(centre, radius);
+                glFinish();
+            }
+            std::cout << "radius " << radius << ", " << names[mode] << ": "
+                      << secondsSince(start) / frames * 1000.0 << "ms per frame" << std::endl;
+        }
+    }
+    return 0;
+}
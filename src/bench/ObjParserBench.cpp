@@ -0,0 +1,252 @@
+/*
+ * Time and heap allocations of loading an OBJ file: the line by line reader
+ * ObjFileReader used before, with getline, Utils::split and std::stof,
+ * compared to ObjParser on the mapped file, once with new arrays and once
+ * reusing them, and to ObjFileReader, which converts the parsed arrays to
+ * VertexObjects. Reads Vehicle.obj and a synthetic grid of the given size,
+ * then times the grid on 1, 2, 4 ... threads up to one per core; a size of
+ * 870 makes a file of about 100 MB.
+ *
+ * usage: src/ObjParserBench [grid size] [runs]   (run from src/, next to Vehicle.obj)
+ */
+#include "../ObjFileReader.h"
+#include "../ObjParser.h"
+#include "../Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::size_t allocations = 0;
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // the reader as it was, for comparison; the positions are all it keeps
+    bool legacyLoad(const std::string& filename, float scaleFactor, std::vector<glm::vec3>& positions)
+    {
+        std::vector<glm::vec3> temp_vertices;
+        std::vector<glm::vec2> temp_uvs;
+        std::vector<glm::vec3> temp_normals;
+        std::map<std::string, VertexObject> objects;
+        VertexObject obj;
+        bool objIsValid = false;
+
+        std::ifstream infile(filename);
+        if (infile.good() == false)
+        {
+            return false;
+        }
+        std::string line;
+        while (std::getline(infile, line))
+        {
+            std::vector<std::string> words = Utils::split(line, ' ');
+            if (words.empty())
+                continue;
+            const std::string& lineHeader = words[0];
+            if (lineHeader == "o")
+            {
+                if (objIsValid)
+                {
+                    objects[obj.getName()] = obj;
+                    obj = VertexObject();
+                }
+                objIsValid = true;
+            }
+            else if (lineHeader == "g")
+            {
+                obj.setName(words[1]);
+            }
+            else if (lineHeader == "v")
+            {
+                glm::vec3 vertex(std::stof(words[1]), std::stof(words[2]), std::stof(words[3]));
+                temp_vertices.push_back(vertex * scaleFactor);
+            }
+            else if (lineHeader == "vt")
+            {
+                temp_uvs.push_back(glm::vec2(std::stof(words[1]), std::stof(words[2])));
+            }
+            else if (lineHeader == "vn")
+            {
+                temp_normals.push_back(glm::vec3(std::stof(words[1]), std::stof(words[2]), std::stof(words[3])));
+            }
+            else if (lineHeader == "f")
+            {
+                std::vector<glm::vec3> vertices;
+                std::vector<glm::vec3> normals;
+                for (std::size_t i = 1; i < words.size(); ++i)
+                {
+                    std::vector<std::string> indices = Utils::split(words[i], '/');
+                    if (indices.size() > 2)
+                    {
+                        vertices.push_back(temp_vertices[std::stoi(indices[0]) - 1]);
+                        normals.push_back(temp_normals[std::stoi(indices[2]) - 1]);
+                    }
+                }
+                obj.addFace(vertices.size(), vertices, normals);
+            }
+        }
+        if (objIsValid)
+        {
+            objects[obj.getName()] = obj;
+        }
+        positions.swap(temp_vertices);
+        return true;
+    }
+
+    // size x size vertices with normals and texture coordinates, quads between them, in 4 objects
+    void writeGrid(const std::string& filename, int size)
+    {
+        std::FILE* file = std::fopen(filename.c_str(), "w");
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                const float x = i * 0.731f - 120.5f;
+                const float y = j * 0.593f + 3.25f;
+                std::fprintf(file, "v %.6f %.6f %.6f\n", x, y, (i * 7 + j * 13) % 100 * 0.0137f);
+                std::fprintf(file, "vt %.6f %.6f\n", i / (float) size, j / (float) size);
+                std::fprintf(file, "vn %.4f %.4f %.4f\n", 0.0f, 0.0f, 1.0f);
+            }
+        }
+        for (int j = 0; j + 1 < size; ++j)
+        {
+            if (j % ((size + 3) / 4) == 0)
+            {
+                std::fprintf(file, "o Part_%d\ng Part_%d\n", j, j);
+            }
+            for (int i = 0; i + 1 < size; ++i)
+            {
+                const int a = j * size + i + 1;
+                const int b = a + 1;
+                const int c = a + size + 1;
+                const int d = a + size;
+                std::fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            }
+        }
+        std::fclose(file);
+    }
+
+    void bench(const std::string& filename, int runs)
+    {
+        std::vector<glm::vec3> legacyPositions;
+        std::size_t before = allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            legacyLoad(filename, 0.005f, legacyPositions);
+        }
+        const double legacySeconds = secondsSince(start) / runs;
+        const std::size_t legacyAllocations = (allocations - before) / runs;
+
+        ObjParser parser;
+        before = allocations;
+        start = std::chrono::steady_clock::now();
+        parser.parseFile(filename, 0.005f);
+        const double firstSeconds = secondsSince(start);
+        const std::size_t firstAllocations = allocations - before;
+
+        before = allocations;
+        start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            parser.parseFile(filename, 0.005f);
+        }
+        const double reuseSeconds = secondsSince(start) / runs;
+        const std::size_t reuseAllocations = (allocations - before) / runs;
+
+        before = allocations;
+        start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            ObjFileReader reader;
+            reader.loadFile(filename, 0.005f);
+        }
+        const double readerSeconds = secondsSince(start) / runs;
+        const std::size_t readerAllocations = (allocations - before) / runs;
+
+        const bool same = legacyPositions == parser.positions();
+        const std::size_t lines = parser.lineCount();
+        std::cout << filename << ": " << lines << " lines, " << parser.faces().size() << " faces, positions "
+                  << (same ? "identical" : "DIFFERENT") << std::endl;
+        std::cout << "\tgetline/split/stof: " << legacySeconds * 1000.0 << "ms, "
+                  << legacyAllocations / (double) lines << " allocations per line" << std::endl;
+        std::cout << "\tObjParser:          " << firstSeconds * 1000.0 << "ms, " << firstAllocations << " allocations" << std::endl;
+        std::cout << "\tObjParser, reused:  " << reuseSeconds * 1000.0 << "ms, " << reuseAllocations << " allocations" << std::endl;
+        std::cout << "\tObjFileReader:      " << readerSeconds * 1000.0 << "ms, "
+                  << readerAllocations / (double) lines << " allocations per line" << std::endl;
+    }
+
+    void benchThreads(const std::string& filename, int runs)
+    {
+        const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int threads = 1; ; threads = std::min(threads * 2, cores))
+        {
+            ObjParser parser;
+            parser.parseFile(filename, 0.005f, threads);
+            auto start = std::chrono::steady_clock::now();
+            for (int run = 0; run < runs; ++run)
+            {
+                parser.parseFile(filename, 0.005f, threads);
+            }
+            const double parserSeconds = secondsSince(start) / runs;
+
+            start = std::chrono::steady_clock::now();
+            for (int run = 0; run < runs; ++run)
+            {
+                ObjFileReader reader;
+                reader.loadFile(filename, 0.005f, threads);
+            }
+            const double readerSeconds = secondsSince(start) / runs;
+
+            std::cout << "\t" << threads << (threads == 1 ? " thread:  " : " threads: ") << "ObjParser "
+                      << parserSeconds * 1000.0 << "ms, ObjFileReader " << readerSeconds * 1000.0 << "ms" << std::endl;
+            if (threads == cores)
+            {
+                break;
+            }
+        }
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+    if (void* memory = std::malloc(size != 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+int main(int argc, char** argv)
+{
+    const int size = argc > 1 ? std::atoi(argv[1]) : 500;
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    bench("./Vehicle.obj", runs * 100);
+
+    const std::string grid = "ObjParserBench.obj";
+    writeGrid(grid, size);
+    bench(grid, runs);
+    benchThreads(grid, runs);
+    std::remove(grid.c_str());
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Time of the vertex normals of a heightmap, as computed while
+ * Terrain::loadHeightmap runs: the scalar kernel on one thread compared to
+ * generate() on 1, 2, 4, ... threads up to the number of cores.
+ *
+ * usage: TerrainNormalsBench [size] [runs]
+ */
+#include "../TerrainNormals.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned int size = argc > 1 ? std::atoi(argv[1]) : 4096;
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::vector<float> heights((size_t) size * size);
+    for (unsigned int j = 0; j < size; ++j)
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            heights[(size_t) j * size + i] = 250.0f * (std::sin(i * 0.01f) * std::cos(j * 0.013f) + 1.0f);
+        }
+    }
+    std::vector<glm::vec3> normals(heights.size());
+    std::vector<glm::vec4> colors(heights.size(), glm::vec4(1.0f));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run)
+    {
+        TerrainNormals::generateScalar(heights.data(), size, size, 2.0f, 2.0f, normals.data(), colors.data());
+    }
+    const double scalar = secondsSince(start) / runs;
+    std::cout << "size: " << size << " x " << size << ", kernel: " << TerrainNormals::kernelName() << std::endl;
+    std::cout << "scalar, 1 thread: " << scalar * 1e3 << " ms" << std::endl;
+
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, cores))
+    {
+        start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            TerrainNormals::generate(heights.data(), size, size, 2.0f, 2.0f, normals.data(), colors.data(), threads);
+        }
+        const double time = secondsSince(start) / runs;
+        std::cout << TerrainNormals::kernelName() << ", " << TerrainNormals::threadCount(size, threads) << " threads: "
+                  << time * 1e3 << " ms, speedup " << scalar / time << "x" << std::endl;
+        if (threads == cores)
+        {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Draw calls and CPU time per frame of the AI vehicles: all of them in one
+ * instanced call compared to a call per vehicle, for 1k and 10k vehicles or
+ * the numbers given. A quarter of the vehicles are farther away than the
+ * draw radius and culled. Needs a window for its GL context.
+ *
+ * usage: src/VehicleInstancesBench [frames] [vehicles...]   (run from src/, next to Vehicle.obj)
+ */
+#include "../AssetCache.h"
+#include "../Tank.h"
+#include "../VehicleInstances.h"
+
+#include <GL/glut.h>
+#include "glm/gtc/quaternion.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    std::vector<std::size_t> counts;
+    for (int i = 2; i < argc; ++i)
+    {
+        counts.push_back(std::atoi(argv[i]));
+    }
+    if (counts.empty())
+    {
+        counts = { 1000, 10000 };
+    }
+
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(600, 400);
+    glutCreateWindow(argv[0]);
+
+    AssetCache::VehicleMeshHandle mesh = AssetCache::instance().loadVehicleMesh("./Vehicle.obj", 0.005);
+    if (!mesh)
+    {
+        std::cerr << "Vehicle.obj not found" << std::endl;
+        return 1;
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glFrustum(-1.0, 1.0, -1.0, 1.0, 1.5, 1010.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glTranslatef(0.0f, 0.0f, -150.0f);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_DEPTH_TEST);
+
+    const float radius = 100.0f;
+    VehicleInstances instances;
+    for (std::size_t count : counts)
+    {
+        // a square grid, three quarters of it inside the circle of the radius
+        std::vector<glm::vec3> positions(count);
+        std::vector<glm::quat> orientations(count);
+        const std::size_t columns = (std::size_t) std::ceil(std::sqrt((double) count));
+        const float spacing = radius * std::sqrt(3.1415926536f / 0.75f) / columns;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            positions[i] = glm::vec3(((i % columns) - columns * 0.5f) * spacing, ((i / columns) - columns * 0.5f) * spacing, 0.0f);
+            orientations[i] = glm::angleAxis(i * 0.1f, glm::vec3(0.0f, 0.0f, 1.0f));
+        }
+
+        for (bool instanced : { true, false })
+        {
+            if (!instances.setInstancingEnabled(instanced))
+            {
+                continue;
+            }
+            double cpuSeconds = 0.0;
+            const auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                const auto cpuStart = std::chrono::steady_clock::now();
+                instances.begin(glm::vec3(0.0f), radius, Tank::modelTransform());
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    instances.add(positions[i], orientations[i]);
+                }
+                instances.draw(*mesh);
+                cpuSeconds += secondsSince(cpuStart);
+                glFinish();
+            }
+            const double seconds = secondsSince(start);
+            const VehicleInstances::Stats& stats = instances.stats();
+            std::cout << count << " vehicles, " << (instanced ? "instanced" : "one by one") << ": "
+                      << stats.drawn << " drawn in " << stats.drawCalls << " draw calls, "
+                      << cpuSeconds / frames * 1000.0 << "ms CPU, "
+                      << seconds / frames * 1000.0 << "ms with the GPU per frame" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Time of one simulation tick of many AI vehicles in a VehicleSystem: the
+ * scalar reference compared to the SIMD kernels, and the share of a 60 Hz
+ * tick that leaves on one core.
+ *
+ * usage: VehicleSystemBench [vehicles] [ticks]
+ */
+#include "../VehicleSystem.h"
+#include "../Simulation.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void spawn(VehicleSystem& vehicles, size_t count)
+    {
+        std::mt19937 generator;
+        std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+        std::uniform_real_distribution<float> heading(0.0f, 360.0f);
+        std::uniform_real_distribution<float> speed(0.02f, 0.2f);
+        std::uniform_real_distribution<float> turnRate(-1.0f, 1.0f);
+        vehicles.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            vehicles.add(glm::vec3(position(generator), position(generator), 10.0f), heading(generator), speed(generator), turnRate(generator));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int ticks = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    Landscape landscape;
+    landscape.generate(Landscape::Type::RANDOM);
+    VehicleSystem vehicles;
+
+    spawn(vehicles, count);
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        vehicles.stepScalar(landscape);
+    }
+    const double scalar = secondsSince(start) / ticks;
+    const glm::vec3 scalarPosition = vehicles.position(count - 1);
+
+    spawn(vehicles, count);
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        vehicles.step(landscape);
+    }
+    const double simd = secondsSince(start) / ticks;
+    const glm::vec3 simdPosition = vehicles.position(count - 1);
+
+    const double budget = 1.0 / Simulation::TicksPerSecond;
+    std::cout << count << " vehicles, " << ticks << " ticks, kernel: " << VehicleSystem::kernelName() << std::endl;
+    std::cout << "scalar: " << scalar * 1e3 << " ms/tick, " << scalar / budget * 100.0 << "% of a "
+              << Simulation::TicksPerSecond << " Hz tick" << std::endl;
+    std::cout << VehicleSystem::kernelName() << ": " << simd * 1e3 << " ms/tick, " << simd / budget * 100.0 << "% of a "
+              << Simulation::TicksPerSecond << " Hz tick, speedup " << scalar / simd << "x" << std::endl;
+    std::cout << "identical results: " << (scalarPosition == simdPosition ? "yes" : "no") << std::endl;
+    return scalarPosition == simdPosition ? 0 : 1;
+}
@@ -2,7 +2,9 @@
 
 #include <GL/glut.h>
 #include <glu.h>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 MainWindow* windowPtr;
 
@@ -41,6 +43,18 @@ int main(int argc, char** argv)
 
 	MainWindow window;
 	windowPtr = &window;
+	// usage: TerrainRacer [--traffic vehicles] [heightfield written by TiledHeightfield::write]
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--traffic" && i + 1 < argc)
+		{
+			window.addTraffic(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (!window.openTiledLandscape(argv[i]))
+		{
+			return 1;
+		}
+	}
 	glutDisplayFunc(doRendering);
 	glutReshapeFunc(doReshape);
 	glutKeyboardFunc(handleKeyboard);
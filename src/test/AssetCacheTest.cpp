@@ -0,0 +1,106 @@
+#include "../AssetCache.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    class AssetCacheTest : public ::testing::Test
+    {
+    protected:
+        AssetCacheTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~AssetCacheTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(AssetCacheTest, SharesMeshes)
+    {
+        AssetCache cache;
+        AssetCache::MeshHandle first = cache.loadMesh("../Vehicle.obj");
+        ASSERT_TRUE(first != nullptr);
+        EXPECT_EQ(first->size(), 5u);
+        EXPECT_EQ(cache.loadMesh("../Vehicle.obj"), first);
+        EXPECT_EQ(cache.loadCount(), 1u);
+
+        // the same contents under another name
+        {
+            std::ifstream in("../Vehicle.obj", std::ios::binary);
+            std::ofstream out("AssetCacheTest.obj", std::ios::binary);
+            out << in.rdbuf();
+        }
+        EXPECT_EQ(cache.loadMesh("AssetCacheTest.obj"), first);
+        EXPECT_EQ(cache.loadCount(), 1u);
+        std::remove("AssetCacheTest.obj");
+
+        // another scale is another mesh
+        AssetCache::MeshHandle scaled = cache.loadMesh("../Vehicle.obj", 0.5f);
+        EXPECT_NE(scaled, first);
+        EXPECT_EQ(cache.loadCount(), 2u);
+        EXPECT_EQ(cache.meshCount(), 2u);
+
+        // a mesh is freed with its last handle and loaded again when needed
+        scaled.reset();
+        EXPECT_EQ(cache.meshCount(), 1u);
+        cache.loadMesh("../Vehicle.obj", 0.5f);
+        EXPECT_EQ(cache.loadCount(), 3u);
+    }
+
+    void copyFile(const char* from, const char* to, const char* append = "")
+    {
+        std::ifstream in(from, std::ios::binary);
+        std::ofstream out(to, std::ios::binary);
+        out << in.rdbuf() << append;
+    }
+
+    TEST(AssetCacheTest, ComparesContents)
+    {
+        AssetCache cache;
+        copyFile("../Vehicle.obj", "AssetCacheTest.obj");
+        AssetCache::MeshHandle first = cache.loadMesh("AssetCacheTest.obj");
+        ASSERT_TRUE(first != nullptr);
+
+        // the file the mesh was parsed from changes, so a file with its old contents is no longer known to match
+        copyFile("../Vehicle.obj", "AssetCacheTest.obj", "# changed\n");
+        copyFile("../Vehicle.obj", "AssetCacheTest.copy.obj");
+        AssetCache::MeshHandle copy = cache.loadMesh("AssetCacheTest.copy.obj");
+        ASSERT_TRUE(copy != nullptr);
+        EXPECT_NE(copy, first);
+        EXPECT_EQ(cache.loadCount(), 2u);
+
+        // the copy is now the file of that hash
+        copyFile("../Vehicle.obj", "AssetCacheTest.other.obj");
+        EXPECT_EQ(cache.loadMesh("AssetCacheTest.other.obj"), copy);
+        EXPECT_EQ(cache.loadCount(), 2u);
+        std::remove("AssetCacheTest.obj");
+        std::remove("AssetCacheTest.copy.obj");
+        std::remove("AssetCacheTest.other.obj");
+    }
+
+    TEST(AssetCacheTest, MissingFile)
+    {
+        AssetCache cache;
+        EXPECT_TRUE(cache.loadMesh("AssetCacheTest.missing.obj") == nullptr);
+        EXPECT_TRUE(cache.loadMesh("AssetCacheTest.missing.obj") == nullptr);
+        EXPECT_EQ(cache.loadCount(), 0u);
+        EXPECT_EQ(cache.meshCount(), 0u);
+    }
+}
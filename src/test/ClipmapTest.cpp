@@ -0,0 +1,193 @@
+#include "../Clipmap.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+namespace
+{
+    class ClipmapTest : public ::testing::Test
+    {
+    protected:
+        ClipmapTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~ClipmapTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    // heights computed on demand, so the map can be arbitrarily large
+    class WaveSource : public HeightSource
+    {
+    public:
+        explicit WaveSource(int size) :
+                        mSize(size)
+        {
+        }
+
+        int sizeX() const override
+        {
+            return mSize;
+        }
+
+        int sizeY() const override
+        {
+            return mSize;
+        }
+
+        float spacing() const override
+        {
+            return 10.0f;
+        }
+
+        float height(int x, int y) const override
+        {
+            return std::sin(x * 0.05f) * 20.0f + std::cos(y * 0.03f) * 10.0f;
+        }
+
+    private:
+        int mSize;
+    };
+
+    TEST(ClipmapTest, HeightsMatchSource)
+    {
+        WaveSource source(100000);
+        Clipmap clipmap(4);
+        clipmap.reset(&source);
+        clipmap.update(glm::vec2(5000.0f, 7000.0f));
+
+        const int last = Clipmap::GridSize - 1;
+        for (int l = 0; l < clipmap.levels(); ++l)
+        {
+            const int step = 1 << l;
+            EXPECT_EQ(0, clipmap.originX(l) % 2);
+            EXPECT_EQ(0, clipmap.originY(l) % 2);
+            for (int i = 0; i <= last; ++i)
+            {
+                for (int j = 0; j <= last; ++j)
+                {
+                    const int x = clipmap.originX(l) + i;
+                    const int y = clipmap.originY(l) + j;
+                    float expected = source.height(x * step, y * step);
+                    const bool coarser = l + 1 < clipmap.levels();
+                    // odd border samples are interpolated along the border
+                    if (coarser && (i == 0 || i == last) && (j & 1))
+                        expected = (source.height(x * step, (y - 1) * step) + source.height(x * step, (y + 1) * step)) / 2.0f;
+                    else if (coarser && (j == 0 || j == last) && (i & 1))
+                        expected = (source.height((x - 1) * step, y * step) + source.height((x + 1) * step, y * step)) / 2.0f;
+
+                    const Clipmap::Vertex& v = clipmap.vertex(l, i, j);
+                    EXPECT_FLOAT_EQ(x * step * 10.0f, v.position.x);
+                    EXPECT_FLOAT_EQ(y * step * 10.0f, v.position.y);
+                    EXPECT_FLOAT_EQ(expected, v.position.z);
+                    EXPECT_NEAR(1.0f, std::sqrt(v.normal.x * v.normal.x + v.normal.y * v.normal.y + v.normal.z * v.normal.z), 1e-5f);
+                    EXPECT_GT(v.normal.z, 0.0f);
+                }
+            }
+        }
+    }
+
+    TEST(ClipmapTest, NestedLevelsShareBorder)
+    {
+        WaveSource source(100000);
+        Clipmap clipmap(4);
+        clipmap.reset(&source);
+        clipmap.update(glm::vec2(3210.0f, 4567.0f));
+
+        // the border of a level lies on the edges around the hole of the next one
+        for (int l = 0; l + 1 < clipmap.levels(); ++l)
+        {
+            const int holeX = clipmap.originX(l) / 2 - clipmap.originX(l + 1);
+            const int holeY = clipmap.originY(l) / 2 - clipmap.originY(l + 1);
+            EXPECT_GE(holeX, 1);
+            EXPECT_GE(holeY, 1);
+            EXPECT_LE(holeX + Clipmap::HoleCells, Clipmap::GridSize - 2);
+            EXPECT_LE(holeY + Clipmap::HoleCells, Clipmap::GridSize - 2);
+            for (int k = 0; k < Clipmap::GridSize; ++k)
+            {
+                const glm::vec3 fine = clipmap.vertex(l, 0, k).position;
+                const glm::vec3 a = clipmap.vertex(l + 1, holeX, holeY + k / 2).position;
+                const glm::vec3 b = clipmap.vertex(l + 1, holeX, holeY + (k + 1) / 2).position;
+                EXPECT_FLOAT_EQ((a.z + b.z) / 2.0f, fine.z);
+            }
+        }
+    }
+
+    TEST(ClipmapTest, IncrementalUpdate)
+    {
+        WaveSource source(100000);
+        Clipmap moving(5);
+        moving.reset(&source);
+        glm::vec2 position(20000.0f, 20000.0f);
+        moving.update(position);
+        EXPECT_EQ(5u * Clipmap::GridSize * Clipmap::GridSize, moving.updatedSamples());
+
+        for (int frame = 0; frame < 200; ++frame)
+        {
+            position += glm::vec2(7.0f, -3.0f);
+            moving.update(position);
+            // at most two rows and two columns per level
+            EXPECT_LE(moving.updatedSamples(), 5u * 4 * Clipmap::GridSize);
+        }
+        moving.update(position);
+        EXPECT_EQ(0u, moving.updatedSamples());
+
+        Clipmap fresh(5);
+        fresh.reset(&source);
+        fresh.update(position);
+        for (int l = 0; l < moving.levels(); ++l)
+        {
+            EXPECT_EQ(fresh.originX(l), moving.originX(l));
+            EXPECT_EQ(fresh.originY(l), moving.originY(l));
+            EXPECT_EQ(fresh.indices(l), moving.indices(l));
+            for (int i = 0; i < Clipmap::GridSize; ++i)
+            {
+                for (int j = 0; j < Clipmap::GridSize; ++j)
+                {
+                    const Clipmap::Vertex& a = fresh.vertex(l, i, j);
+                    const Clipmap::Vertex& b = moving.vertex(l, i, j);
+                    EXPECT_EQ(a.position.z, b.position.z);
+                    EXPECT_EQ(a.normal.x, b.normal.x);
+                    EXPECT_EQ(a.normal.y, b.normal.y);
+                }
+            }
+        }
+    }
+
+    TEST(ClipmapTest, ConstantCost)
+    {
+        const size_t cells = (Clipmap::GridSize - 1) * (Clipmap::GridSize - 1);
+        const size_t ring = cells - Clipmap::HoleCells * Clipmap::HoleCells;
+        size_t samples[2];
+        int run = 0;
+        for (int size : { 1000, 1000000 })
+        {
+            WaveSource source(size);
+            Clipmap clipmap(6);
+            clipmap.reset(&source);
+            clipmap.update(glm::vec2(2000.0f, 2000.0f));
+            EXPECT_EQ(cells * 2, clipmap.indices(0).size() / 3);
+            EXPECT_EQ((cells + 5 * ring) * 2, clipmap.triangles());
+
+            clipmap.update(glm::vec2(2100.0f, 2000.0f));
+            samples[run++] = clipmap.updatedSamples();
+            EXPECT_EQ((cells + 5 * ring) * 2, clipmap.triangles());
+        }
+        EXPECT_EQ(samples[0], samples[1]);
+    }
+}
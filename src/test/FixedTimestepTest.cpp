@@ -0,0 +1,70 @@
+#include "../FixedTimestep.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+    class FixedTimestepTest : public ::testing::Test
+    {
+    protected:
+        FixedTimestepTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~FixedTimestepTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(FixedTimestepTest, TicksFollowTheClock)
+    {
+        FixedTimestep timestep(1000, 5);
+        EXPECT_EQ(timestep.update(50000), 0u);
+        EXPECT_EQ(timestep.alpha(), 0.0f);
+
+        // frames shorter than a tick accumulate
+        EXPECT_EQ(timestep.update(50400), 0u);
+        EXPECT_FLOAT_EQ(timestep.alpha(), 0.4f);
+        EXPECT_EQ(timestep.update(51100), 1u);
+        EXPECT_FLOAT_EQ(timestep.alpha(), 0.1f);
+
+        // longer ones run several ticks and keep the remainder
+        EXPECT_EQ(timestep.update(53350), 2u);
+        EXPECT_FLOAT_EQ(timestep.alpha(), 0.35f);
+
+        // however long the frames, the ticks add up to the elapsed time
+        unsigned int ticks = 0;
+        for (unsigned long i = 1; i <= 6; ++i)
+        {
+            ticks += timestep.update(53350 + i * 1700);
+        }
+        EXPECT_EQ(ticks, 10u);
+        EXPECT_FLOAT_EQ(timestep.alpha(), 0.55f);
+        EXPECT_EQ(timestep.droppedTicks(), 0u);
+    }
+
+    TEST(FixedTimestepTest, DropsBacklog)
+    {
+        FixedTimestep timestep(1000, 5);
+        timestep.update(0);
+
+        // a stall of 20 ticks runs 5 of them, the others are dropped
+        EXPECT_EQ(timestep.update(20500), 5u);
+        EXPECT_EQ(timestep.droppedTicks(), 15u);
+        EXPECT_FLOAT_EQ(timestep.alpha(), 0.5f);
+        EXPECT_EQ(timestep.update(21500), 1u);
+    }
+}
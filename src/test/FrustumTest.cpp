@@ -0,0 +1,53 @@
+#include "../Frustum.h"
+#include "gtest/gtest.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace
+{
+    class FrustumTest : public ::testing::Test
+    {
+    protected:
+        FrustumTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~FrustumTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(FrustumTest, Classify)
+    {
+        // looking from the origin along +x, z is up
+        const glm::mat4 projection = glm::frustum(-1.0f, 1.0f, -1.0f, 1.0f, 1.5f, 1010.0f);
+        const glm::mat4 modelview = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1));
+        const Frustum frustum(projection * modelview);
+
+        EXPECT_TRUE(frustum.contains(glm::vec3(100, 0, 0)));
+        EXPECT_TRUE(frustum.contains(glm::vec3(100, 50, -50)));
+        EXPECT_FALSE(frustum.contains(glm::vec3(-100, 0, 0)));
+        EXPECT_FALSE(frustum.contains(glm::vec3(1, 0, 0)));     // before the near plane
+        EXPECT_FALSE(frustum.contains(glm::vec3(2000, 0, 0)));  // behind the far plane
+        EXPECT_FALSE(frustum.contains(glm::vec3(100, 100, 0)));
+
+        EXPECT_EQ(frustum.classify(glm::vec3(90, -10, -10), glm::vec3(110, 10, 10)), Frustum::Visibility::INSIDE);
+        EXPECT_EQ(frustum.classify(glm::vec3(90, -200, -10), glm::vec3(110, 0, 10)), Frustum::Visibility::INTERSECTING);
+        EXPECT_EQ(frustum.classify(glm::vec3(-110, -10, -10), glm::vec3(-90, 10, 10)), Frustum::Visibility::OUTSIDE);
+        EXPECT_EQ(frustum.classify(glm::vec3(90, 200, -10), glm::vec3(110, 300, 10)), Frustum::Visibility::OUTSIDE);
+    }
+}
@@ -0,0 +1,99 @@
+#include "../Heightfield.h"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    class HeightfieldTest : public ::testing::Test
+    {
+    protected:
+        HeightfieldTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~HeightfieldTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(HeightfieldTest, Layout)
+    {
+        Heightfield<float> field(3, 5, 1.5f);
+        EXPECT_EQ(field.sizeX(), 3);
+        EXPECT_EQ(field.sizeY(), 5);
+        EXPECT_FALSE(field.empty());
+
+        // rows are padded to a full cache line
+        EXPECT_EQ(field.stride(), Heightfield<float>::Alignment / sizeof(float));
+        EXPECT_EQ(field.byteSize(), 3 * Heightfield<float>::Alignment);
+        for (int x = 0; x < field.sizeX(); ++x)
+        {
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(field.row(x)) % Heightfield<float>::Alignment, 0u);
+            for (int y = 0; y < field.sizeY(); ++y)
+            {
+                EXPECT_EQ(field(x, y), 1.5f);
+            }
+        }
+
+        field(2, 4) = 7.0f;
+        EXPECT_EQ(field.data()[2 * field.stride() + 4], 7.0f);
+        EXPECT_EQ(field.row(2)[4], 7.0f);
+
+        field.clear();
+        EXPECT_TRUE(field.empty());
+        EXPECT_EQ(field.sizeX(), 0);
+    }
+
+    TEST(HeightfieldTest, SampleType)
+    {
+        Heightfield<unsigned char> field(2, 65);
+        EXPECT_EQ(field.stride(), 128u);
+        field(1, 64) = 200;
+        EXPECT_EQ(field(1, 64), 200);
+        EXPECT_EQ(field(0, 64), 0);
+    }
+
+    TEST(HeightfieldTest, Attach)
+    {
+        std::vector<float> samples(4 * 16, 2.0f);
+        Heightfield<float> field;
+        field.attach(samples.data(), 4, 3, 16);
+        EXPECT_TRUE(field.isAttached());
+        EXPECT_EQ(field.sizeX(), 4);
+        EXPECT_EQ(field.sizeY(), 3);
+        EXPECT_EQ(field.byteSize(), 4 * 16 * sizeof(float));
+        EXPECT_EQ(field.row(1), samples.data() + 16);
+
+        field(3, 2) = 5.0f;
+        EXPECT_EQ(samples[3 * 16 + 2], 5.0f);
+
+        // copies of an attached field share its memory, copies of an owning one don't
+        Heightfield<float> copy(field);
+        EXPECT_EQ(copy.data(), samples.data());
+        Heightfield<float> owning(2, 2, 1.0f);
+        copy = owning;
+        EXPECT_FALSE(copy.isAttached());
+        EXPECT_NE(copy.data(), owning.data());
+        EXPECT_EQ(copy(1, 1), 1.0f);
+
+        field.resize(2, 2);
+        EXPECT_FALSE(field.isAttached());
+        EXPECT_EQ(samples[3 * 16 + 2], 5.0f);
+    }
+}
@@ -0,0 +1,143 @@
+#include "LandscapeMock.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    class LandscapeBakeTest : public ::testing::Test
+    {
+    protected:
+        LandscapeBakeTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~LandscapeBakeTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    const char* const BakeFile = "LandscapeBakeTest.bake";
+
+    TEST(LandscapeBakeTest, RoundTrip)
+    {
+        LandscapeMock generated;
+        generated.generate(Landscape::Type::RANDOM);
+        ASSERT_TRUE(generated.bake(BakeFile));
+        // baking builds a plane table for the file only
+        EXPECT_FALSE(generated.usesPlaneTable());
+
+        LandscapeMock baked;
+        ASSERT_TRUE(baked.loadBaked(BakeFile));
+        EXPECT_TRUE(baked.isBaked());
+        EXPECT_TRUE(baked.usesPlaneTable());
+        ASSERT_EQ(baked.supportPoints().sizeX(), generated.supportPoints().sizeX());
+        ASSERT_EQ(baked.supportPoints().sizeY(), generated.supportPoints().sizeY());
+        EXPECT_TRUE(baked.supportPoints().isAttached());
+        for (int x = 0; x < generated.supportPoints().sizeX(); ++x)
+        {
+            for (int y = 0; y < generated.supportPoints().sizeY(); ++y)
+            {
+                ASSERT_EQ(baked.supportPoints()(x, y), generated.supportPoints()(x, y));
+            }
+        }
+
+        generated.setUsePlaneTable(true);
+        for (float x = 3.0f; x < 1000.0f; x += 37.3f)
+        {
+            for (float y = 1.0f; y < 1000.0f; y += 41.9f)
+            {
+                float expectedAltitude, altitude;
+                glm::vec3 expectedNormal, normal;
+                generated.getLocalEnvironment(x, y, expectedAltitude, expectedNormal);
+                baked.getLocalEnvironment(x, y, altitude, normal);
+                ASSERT_EQ(altitude, expectedAltitude);
+                ASSERT_EQ(normal.x, expectedNormal.x);
+                ASSERT_EQ(normal.y, expectedNormal.y);
+                ASSERT_EQ(normal.z, expectedNormal.z);
+            }
+        }
+
+        // the tiles come from the file, exactly as they would have been built
+        EXPECT_EQ(generated.tiles().tileData(0, 0), nullptr);
+        for (int tileX = 0; tileX < baked.tiles().tilesX(); ++tileX)
+        {
+            for (int tileY = 0; tileY < baked.tiles().tilesY(); ++tileY)
+            {
+                std::vector<LandscapeTiles::Vertex> vertices;
+                std::vector<GLushort> indices;
+                generated.tiles().buildTile(tileX, tileY, vertices, indices);
+                const LandscapeTiles::TileData* data = baked.tiles().tileData(tileX, tileY);
+                ASSERT_NE(data, nullptr);
+                ASSERT_EQ(data->vertexCount, (GLsizei) vertices.size());
+                ASSERT_EQ(data->indexCount, (GLsizei) indices.size());
+                for (size_t i = 0; i < vertices.size(); ++i)
+                {
+                    ASSERT_EQ(data->vertices[i].position, vertices[i].position);
+                    ASSERT_EQ(data->vertices[i].normal, vertices[i].normal);
+                    ASSERT_EQ(data->vertices[i].texCoord, vertices[i].texCoord);
+                }
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    ASSERT_EQ(data->indices[i], indices[i]);
+                }
+            }
+        }
+
+        // generating again drops the file
+        baked.generate(Landscape::Type::FLAT);
+        EXPECT_FALSE(baked.isBaked());
+        EXPECT_FALSE(baked.supportPoints().isAttached());
+        EXPECT_EQ(baked.tiles().tileData(0, 0), nullptr);
+        std::remove(BakeFile);
+    }
+
+    TEST(LandscapeBakeTest, RejectsInvalidFiles)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+        const float height = landscape.getHeight(55.0, 66.0);
+
+        EXPECT_FALSE(landscape.loadBaked("does-not-exist.bake"));
+
+        {
+            std::ofstream ofs(BakeFile, std::ios::binary);
+            ofs << "not a baked landscape, but long enough to hold a header of one";
+        }
+        EXPECT_FALSE(landscape.loadBaked(BakeFile));
+
+        // a truncated file
+        ASSERT_TRUE(landscape.bake(BakeFile));
+        std::vector<char> contents;
+        {
+            std::ifstream ifs(BakeFile, std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+        {
+            std::ofstream ofs(BakeFile, std::ios::binary);
+            ofs.write(contents.data(), contents.size() / 2);
+        }
+        EXPECT_FALSE(landscape.loadBaked(BakeFile));
+
+        // the landscape is still usable
+        EXPECT_FALSE(landscape.isBaked());
+        EXPECT_EQ(landscape.getHeight(55.0, 66.0), height);
+        std::remove(BakeFile);
+    }
+}
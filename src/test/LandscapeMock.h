@@ -8,16 +8,23 @@ class LandscapeMock : public Landscape
 public:
     LandscapeMock() = default;
 
-    std::vector<std::vector<double>> supportPoints()
+    const Heightfield<float>& supportPoints()
     {
         return mSupportPoints;
     }
 
-    std::vector<Triangle> triangles()
+    LandscapeMesh triangles()
     {
-        return mTriangles;
+        return get();
     }
 
+    const LandscapeTiles& tiles()
+    {
+        return mTiles;
+    }
+
+    using Landscape::getLocalEnvironmentsScalar;
+
     int dimX()
     {
         return mDimX;
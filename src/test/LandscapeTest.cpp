@@ -1,6 +1,8 @@
 #include "LandscapeMock.h"
 #include "gtest/gtest.h"
 
+#include <cstring>
+
 namespace
 {
     class LandscapeTest : public ::testing::Test
@@ -38,12 +40,9 @@ namespace
         LandscapeMock landscape;
         landscape.generate(Landscape::Type::FLAT);
 
-        std::vector<std::vector<double>> supportPoints = landscape.supportPoints();
-        EXPECT_EQ(supportPoints.size(), landscape.dimX());
-        for (const auto& row : supportPoints)
-        {
-            EXPECT_EQ(row.size(), landscape.dimY());
-        }
+        const Heightfield<float>& supportPoints = landscape.supportPoints();
+        EXPECT_EQ(supportPoints.sizeX(), landscape.dimX());
+        EXPECT_EQ(supportPoints.sizeY(), landscape.dimY());
         EXPECT_EQ(landscape.triangles().size(), (landscape.dimX() - 1) * (landscape.dimY() - 1) * 2);
         EXPECT_EQ(landscape.get().size(), (landscape.dimX() - 1) * (landscape.dimY() - 1) * 2);
 
@@ -108,4 +107,196 @@ namespace
         EXPECT_EQ(t.getCorner(2).y, 10);
     }
 
+    TEST(LandscapeTest, ImplicitMesh)
+    {
+        const double epsilon = 1e-6;
+
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+        const Heightfield<float>& supportPoints = landscape.supportPoints();
+        const LandscapeMesh mesh = landscape.get();
+        const float scale = 10.0f;
+
+        // the view yields the same triangles that used to be materialised, in the same order
+        size_t index = 0;
+        for (int x = 0; x < landscape.dimX() - 1; ++x)
+        {
+            for (int y = 0; y < landscape.dimY() - 1; ++y)
+            {
+                Triangle upper;
+                upper.setCorner(0, glm::vec3(x * scale, y * scale, supportPoints(x, y)));
+                upper.setCorner(1, glm::vec3((x + 1) * scale, (y + 1) * scale, supportPoints(x + 1, y + 1)));
+                upper.setCorner(2, glm::vec3(x * scale, (y + 1) * scale, supportPoints(x, y + 1)));
+                Triangle lower;
+                lower.setCorner(0, glm::vec3(x * scale, y * scale, supportPoints(x, y)));
+                lower.setCorner(1, glm::vec3((x + 1) * scale, y * scale, supportPoints(x + 1, y)));
+                lower.setCorner(2, glm::vec3((x + 1) * scale, (y + 1) * scale, supportPoints(x + 1, y + 1)));
+
+                EXPECT_EQ(mesh.index(x, y, 0), index);
+                EXPECT_TRUE(mesh[index] == upper);
+                glm::vec3 normal = mesh.normal(index);
+                EXPECT_LE(glm::length(normal - upper.getNormal()), epsilon);
+                ++index;
+
+                EXPECT_TRUE(mesh[index] == lower);
+                normal = mesh.normal(index);
+                EXPECT_LE(glm::length(normal - lower.getNormal()), epsilon);
+                ++index;
+            }
+        }
+        EXPECT_EQ(index, mesh.size());
+
+        size_t count = 0;
+        for (LandscapeMesh::const_iterator it = mesh.begin(); it != mesh.end(); ++it)
+        {
+            EXPECT_TRUE(*it == mesh[it.index()]);
+            ++count;
+        }
+        EXPECT_EQ(count, mesh.size());
+    }
+
+    TEST(LandscapeTest, Locate)
+    {
+        // coordinates go up to 1000, where a float resolves about 1e-4
+        const double epsilon = 1e-3;
+
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+        const LandscapeMesh mesh = landscape.get();
+        const float scale = 10.0f;
+
+        std::mt19937 generator;
+        std::uniform_real_distribution<float> dis(0.0f, (landscape.dimX() - 1) * scale);
+        std::vector<glm::vec2> points;
+        for (int i = 0; i < 1000; ++i)
+        {
+            points.push_back(glm::vec2(dis(generator), dis(generator)));
+        }
+        // corners and edges of cells
+        points.push_back(glm::vec2(10, 10));
+        points.push_back(glm::vec2(15, 10));
+        points.push_back(glm::vec2(10, 15));
+        points.push_back(glm::vec2(15, 15));
+
+        std::vector<Landscape::Location> locations(points.size());
+        landscape.locate(points.data(), points.size(), locations.data());
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const glm::vec2& p = points[i];
+            const Landscape::Location location = landscape.locate(p.x, p.y);
+            EXPECT_EQ(location.triangle, locations[i].triangle);
+
+            // the reference: pick the half by the angle of the point towards the cell origin
+            const int indexX = (int) (p.x / scale);
+            const int indexY = (int) (p.y / scale);
+            const float dx = p.x - indexX * scale;
+            const float dy = p.y - indexY * scale;
+            double rho = dy == 0.0f ? (dx > 0 ? 90.0 : 270.0) : glm::degrees(atan(dx / dy));
+            const int half = rho <= 45.0 ? 0 : 1;
+            EXPECT_EQ(location.triangle, mesh.index(indexX, indexY, half));
+
+            // the weights reproduce the point and interpolate the height
+            const Triangle t = mesh[location.triangle];
+            const glm::vec3 cartesian = t.barycentricToCartesian(glm::vec3(location.weights[0], location.weights[1], location.weights[2]));
+            EXPECT_LE(fabs(cartesian.x - p.x), epsilon);
+            EXPECT_LE(fabs(cartesian.y - p.y), epsilon);
+            EXPECT_LE(fabs(landscape.interpolateHeight(location) - t.interpolateHeight(p.x, p.y)), epsilon);
+        }
+
+        // points outside are clamped to the border
+        Landscape::Location location = landscape.locate(-5.0f, 2000.0f);
+        EXPECT_EQ(location.triangle, mesh.index(0, landscape.dimY() - 2, 0));
+        EXPECT_EQ(location.weights[2], 1.0f);
+    }
+
+    TEST(LandscapeTest, LocalEnvironments)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+
+        std::mt19937 generator;
+        // include points outside of the landscape, they are clamped
+        std::uniform_real_distribution<float> dis(-50.0f, landscape.dimX() * 10.0f + 50.0f);
+        std::vector<glm::vec2> points;
+        for (int i = 0; i < 1003; ++i)
+        {
+            points.push_back(glm::vec2(dis(generator), dis(generator)));
+        }
+        points.push_back(glm::vec2(10, 10));
+        points.push_back(glm::vec2(-0.0f, 15));
+
+        std::vector<float> altitudes(points.size());
+        std::vector<glm::vec3> normals(points.size());
+        landscape.getLocalEnvironments(points, altitudes, normals);
+
+        std::vector<float> scalarAltitudes(points.size());
+        std::vector<glm::vec3> scalarNormals(points.size());
+        landscape.getLocalEnvironmentsScalar(points, scalarAltitudes, scalarNormals);
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            // the vectorised kernel has to match the scalar one bit for bit
+            EXPECT_EQ(memcmp(&altitudes[i], &scalarAltitudes[i], sizeof(float)), 0) << Landscape::batchKernelName() << " point " << i;
+            EXPECT_EQ(memcmp(&normals[i], &scalarNormals[i], sizeof(glm::vec3)), 0) << Landscape::batchKernelName() << " point " << i;
+
+            // and both match the single point query
+            float altitude;
+            glm::vec3 normal;
+            landscape.getLocalEnvironment(points[i].x, points[i].y, altitude, normal);
+            EXPECT_EQ(altitude, altitudes[i]);
+            EXPECT_EQ(normal.x, normals[i].x);
+            EXPECT_EQ(normal.y, normals[i].y);
+            EXPECT_EQ(normal.z, normals[i].z);
+        }
+    }
+
+    TEST(LandscapeTest, PlaneTable)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+
+        std::mt19937 generator;
+        std::uniform_real_distribution<float> dis(-50.0f, landscape.dimX() * 10.0f + 50.0f);
+        std::vector<glm::vec2> points;
+        for (int i = 0; i < 1000; ++i)
+        {
+            points.push_back(glm::vec2(dis(generator), dis(generator)));
+        }
+        points.push_back(glm::vec2(10, 10));
+        points.push_back(glm::vec2(15, 15));
+
+        std::vector<float> altitudes(points.size());
+        std::vector<glm::vec3> normals(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            landscape.getLocalEnvironment(points[i].x, points[i].y, altitudes[i], normals[i]);
+        }
+
+        EXPECT_FALSE(landscape.usesPlaneTable());
+        landscape.setUsePlaneTable(true);
+        EXPECT_TRUE(landscape.usesPlaneTable());
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            float altitude;
+            glm::vec3 normal;
+            landscape.getLocalEnvironment(points[i].x, points[i].y, altitude, normal);
+            EXPECT_NEAR(altitude, altitudes[i], 1e-4);
+            EXPECT_NEAR(landscape.getHeight(points[i].x, points[i].y), altitudes[i], 1e-4);
+            EXPECT_EQ(normal.x, normals[i].x);
+            EXPECT_EQ(normal.y, normals[i].y);
+            EXPECT_EQ(normal.z, normals[i].z);
+            EXPECT_TRUE(landscape.isCurrentTriangle(landscape.findTriangle(points[i].x, points[i].y)));
+        }
+
+        // regenerating the landscape rebuilds the table
+        landscape.generate(Landscape::Type::FLAT);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            float altitude;
+            glm::vec3 normal;
+            landscape.getLocalEnvironment(points[i].x, points[i].y, altitude, normal);
+            EXPECT_EQ(altitude, 0.0f);
+            EXPECT_EQ(normal.z, 1.0f);
+        }
+    }
 }
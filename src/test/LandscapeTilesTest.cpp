@@ -0,0 +1,85 @@
+#include "LandscapeMock.h"
+#include "../LandscapeTiles.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+namespace
+{
+    class LandscapeTilesTest : public ::testing::Test
+    {
+    protected:
+        LandscapeTilesTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~LandscapeTilesTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(LandscapeTilesTest, Geometry)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+        const LandscapeMesh mesh = landscape.get();
+        const float scale = 10.0f;
+
+        // 100 x 100 cells make 2 x 2 tiles, the last ones are 36 cells wide
+        LandscapeTiles tiles;
+        tiles.reset(&landscape.supportPoints(), scale);
+        ASSERT_EQ(tiles.tilesX(), 2);
+        ASSERT_EQ(tiles.tilesY(), 2);
+        EXPECT_EQ(tiles.uploadedTiles(), 0);
+
+        size_t triangles = 0;
+        for (int tileX = 0; tileX < tiles.tilesX(); ++tileX)
+        {
+            for (int tileY = 0; tileY < tiles.tilesY(); ++tileY)
+            {
+                std::vector<LandscapeTiles::Vertex> vertices;
+                std::vector<GLushort> indices;
+                tiles.buildTile(tileX, tileY, vertices, indices);
+
+                const int cellsX = tileX == 0 ? LandscapeTiles::TileCells : 36;
+                const int cellsY = tileY == 0 ? LandscapeTiles::TileCells : 36;
+                EXPECT_EQ(vertices.size(), (size_t) (cellsX + 1) * (cellsY + 1));
+                ASSERT_EQ(indices.size(), (size_t) cellsX * cellsY * 6);
+
+                // the triangles are the ones of the mesh, corner by corner
+                for (size_t i = 0; i < indices.size(); i += 3)
+                {
+                    const int cell = i / 6;
+                    const int half = (i / 3) % 2;
+                    const Triangle t = mesh[mesh.index(tileX * LandscapeTiles::TileCells + cell / cellsY,
+                                    tileY * LandscapeTiles::TileCells + cell % cellsY, half)];
+                    for (int corner = 0; corner < 3; ++corner)
+                    {
+                        const LandscapeTiles::Vertex& v = vertices[indices[i + corner]];
+                        EXPECT_EQ(v.position, t.getCorner(corner));
+                        EXPECT_EQ(v.texCoord.x, v.position.x / scale);
+                        EXPECT_EQ(v.texCoord.y, v.position.y / scale);
+                        EXPECT_NEAR(glm::length(v.normal), 1.0f, 1e-5);
+                        EXPECT_GT(v.normal.z, 0.0f);
+                    }
+                    ++triangles;
+                }
+            }
+        }
+        EXPECT_EQ(triangles, mesh.size());
+    }
+}
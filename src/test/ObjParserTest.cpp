@@ -0,0 +1,265 @@
+#include "../ObjParser.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+
+namespace
+{
+    class ObjParserTest : public ::testing::Test
+    {
+    protected:
+        ObjParserTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~ObjParserTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    // parseFloat on the whole text, bit for bit as std::strtof, which std::stof uses
+    void expectLikeStof(const std::string& text)
+    {
+        const char* cursor = text.data();
+        float value = 0.0f;
+        ASSERT_TRUE(ObjParser::parseFloat(cursor, text.data() + text.size(), value)) << text;
+        EXPECT_EQ(cursor, text.data() + text.size()) << text;
+        const float expected = std::strtof(text.c_str(), nullptr);
+        EXPECT_EQ(std::memcmp(&value, &expected, sizeof(float)), 0) << text << ": " << value << " instead of " << expected;
+    }
+
+    TEST(ObjParserTest, ParsesFloats)
+    {
+        const char* texts[] = { "0", "-0", "+2", "1.5", "-130.042", "80.016", ".5", "5.", "1e10", "2.5E-3",
+                                "0.1", "1.17549435e-38", "1e-45", "3.4028234e38", "123456789.123456789",
+                                "0.000000000000000000000000000001", "12345678901234567890123",
+                                // exactly halfway between two floats
+                                "16777217", "16777219",
+                                "1.000000059604644775390625" };
+        for (const char* text : texts)
+        {
+            expectLikeStof(text);
+        }
+
+        std::mt19937 generator;
+        std::uniform_real_distribution<float> values(-1000.0f, 1000.0f);
+        std::uniform_int_distribution<int> exponents(-40, 38);
+        char text[64];
+        for (int i = 0; i < 20000; ++i)
+        {
+            std::snprintf(text, sizeof(text), "%.6f", values(generator));
+            expectLikeStof(text);
+            std::snprintf(text, sizeof(text), "%.9g", values(generator) * std::pow(10.0f, (float) exponents(generator) / 4));
+            expectLikeStof(text);
+        }
+
+        const char* none[] = { "", "-", ".", "e5", "x1" };
+        for (const char* text : none)
+        {
+            const char* cursor = text;
+            float value = 0.0f;
+            EXPECT_FALSE(ObjParser::parseFloat(cursor, text + std::strlen(text), value)) << text;
+            EXPECT_EQ(cursor, text);
+        }
+        // the exponent is not part of the number without digits
+        const std::string partial = "2e+";
+        const char* cursor = partial.data();
+        float value = 0.0f;
+        EXPECT_TRUE(ObjParser::parseFloat(cursor, partial.data() + partial.size(), value));
+        EXPECT_EQ(value, 2.0f);
+        EXPECT_EQ(cursor, partial.data() + 1);
+    }
+
+    TEST(ObjParserTest, ParsesFile)
+    {
+        const std::string obj =
+            "# a comment\r\n"
+            "v 0 0 0\r\n"
+            "v 2 0 0\n"
+            "v  2 2 0 \n"
+            "v 0 2 0\n"
+            "vt 0.5 1\n"
+            "vn 0 0 1\n"
+            "o first\n"
+            "g Base\n"
+            "f 1//1 2//1 3//1 4//1\n"
+            "s off\n"
+            "o second\n"
+            "g Top\n"
+            "f -4/1/-1 -3/1/-1 -2/1/-1\n"
+            "f 1 2 3";
+
+        ObjParser parser;
+        ASSERT_TRUE(parser.parse(obj.data(), obj.size(), 0.5f));
+        EXPECT_EQ(parser.lineCount(), 15u);
+        ASSERT_EQ(parser.positions().size(), 4u);
+        EXPECT_EQ(parser.positions()[2], glm::vec3(1, 1, 0));
+        EXPECT_EQ(parser.texCoords().size(), 1u);
+        EXPECT_EQ(parser.normals().size(), 1u);
+
+        ASSERT_EQ(parser.faces().size(), 3u);
+        EXPECT_EQ(parser.faces()[0].cornerCount, 4u);
+        EXPECT_EQ(parser.faces()[1].firstCorner, 4u);
+        EXPECT_EQ(parser.corners().size(), 10u);
+        const ObjParser::Corner& relative = parser.corners()[5];
+        EXPECT_EQ(relative.position, 1);
+        EXPECT_EQ(relative.texCoord, 0);
+        EXPECT_EQ(relative.normal, 0);
+        const ObjParser::Corner& bare = parser.corners()[9];
+        EXPECT_EQ(bare.position, 2);
+        EXPECT_EQ(bare.texCoord, -1);
+        EXPECT_EQ(bare.normal, -1);
+
+        ASSERT_EQ(parser.objects().size(), 2u);
+        EXPECT_EQ(parser.objects()[0].name, "Base");
+        EXPECT_EQ(parser.objects()[0].faceCount, 1u);
+        EXPECT_EQ(parser.objects()[1].name, "Top");
+        EXPECT_EQ(parser.objects()[1].firstFace, 1u);
+        EXPECT_EQ(parser.objects()[1].faceCount, 2u);
+
+        const std::string outOfRange = "v 0 0 0\nf 1 2 1\n";
+        EXPECT_FALSE(parser.parse(outOfRange.data(), outOfRange.size()));
+        const std::string zero = "v 0 0 0\nv 1 0 0\nf 0 1 2\n";
+        EXPECT_FALSE(parser.parse(zero.data(), zero.size()));
+        const std::string zeroNormal = "v 0 0 0\nv 1 0 0\nv 1 1 0\nvn 0 0 1\nf 1//0 2//1 3//1\n";
+        EXPECT_FALSE(parser.parse(zeroNormal.data(), zeroNormal.size()));
+        const std::string badNumber = "v 0 zero 0\n";
+        EXPECT_FALSE(parser.parse(badNumber.data(), badNumber.size()));
+    }
+
+    TEST(ObjParserTest, IncompleteLines)
+    {
+        ObjParser parser;
+        const std::string shortVertex = "v 0 0\n";
+        EXPECT_FALSE(parser.parse(shortVertex.data(), shortVertex.size()));
+        const std::string shortNormal = "vn 0 1\n";
+        EXPECT_FALSE(parser.parse(shortNormal.data(), shortNormal.size()));
+        const std::string shortTexCoord = "vt 0.5\n";
+        EXPECT_FALSE(parser.parse(shortTexCoord.data(), shortTexCoord.size()));
+
+        // corners without normals are kept, but not mixed with corners with normals
+        const std::string vertices = "v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0 0\nvn 0 0 1\n";
+        const std::string noNormals = vertices + "f 1 2/1 3\n";
+        ASSERT_TRUE(parser.parse(noNormals.data(), noNormals.size()));
+        ASSERT_EQ(parser.faces().size(), 1u);
+        EXPECT_EQ(parser.faces()[0].cornerCount, 3u);
+        EXPECT_EQ(parser.corners()[1].texCoord, 0);
+        const std::string mixedNormals = vertices + "f 1//1 2 3//1\n";
+        EXPECT_FALSE(parser.parse(mixedNormals.data(), mixedNormals.size()));
+        const std::string lastWithout = vertices + "f 1//1 2//1 3/1\n";
+        EXPECT_FALSE(parser.parse(lastWithout.data(), lastWithout.size()));
+    }
+
+    TEST(ObjParserTest, ParsesVehicle)
+    {
+        ObjParser parser;
+        ASSERT_TRUE(parser.parseFile("../Vehicle.obj", 0.005f));
+        EXPECT_EQ(parser.positions().size(), 154u);
+        EXPECT_EQ(parser.normals().size(), 360u);
+        EXPECT_EQ(parser.faces().size(), 90u);
+        ASSERT_EQ(parser.objects().size(), 5u);
+        EXPECT_EQ(parser.objects()[0].name, "Wheel_BR");
+        // too small to be worth a thread
+        EXPECT_EQ(parser.chunkCount(), 1u);
+
+        // parsing again reuses the arrays
+        const glm::vec3* positions = parser.positions().data();
+        ASSERT_TRUE(parser.parseFile("../Vehicle.obj", 0.005f));
+        EXPECT_EQ(parser.positions().data(), positions);
+        EXPECT_FALSE(parser.parseFile("ObjParserTest.missing.obj"));
+    }
+
+    TEST(ObjParserTest, ParsesInChunks)
+    {
+        // a few MB, so that the chunks fall anywhere in the lines, with
+        // relative indices, 'g' lines on either side of 'o' and faces before the first object
+        std::string obj = "g Leading\nv 0 0 0\nvn 0 0 1\nf 1//1 1//1 1//1\n";
+        char line[128];
+        for (int i = 0; i < 60000; ++i)
+        {
+            if (i % 700 == 0)
+            {
+                std::snprintf(line, sizeof(line), i % 1400 == 0 ? "o\ng Part_%d\n" : "g Before_%d\no\n", i);
+                obj += line;
+            }
+            std::snprintf(line, sizeof(line), "v %d.25 %d.5 -%d\nvt 0.%d 1\nvn 0 %d 1\n", i, i % 97, i % 13, i % 10, i % 3);
+            obj += line;
+            if (i > 2)
+            {
+                std::snprintf(line, sizeof(line), "f %d/%d/%d -2/-2/-2 -3//-1\nf %d %d %d %d\n",
+                              i + 2, i + 1, i + 2, i, i + 1, i - 1, i - 2);
+                obj += line;
+            }
+        }
+        ASSERT_GT(obj.size(), 3 * ObjParser::MinChunkBytes);
+        EXPECT_EQ(ObjParser::chunkCount(obj.size(), 2), 2u);
+        EXPECT_EQ(ObjParser::chunkCount(obj.size(), 64), obj.size() / ObjParser::MinChunkBytes);
+        EXPECT_EQ(ObjParser::chunkCount(ObjParser::MinChunkBytes - 1, 7), 1u);
+
+        ObjParser single;
+        ASSERT_TRUE(single.parse(obj.data(), obj.size(), 2.0f, 1));
+        ASSERT_EQ(single.objects().size(), 86u);
+        // a 'g' names the object before it, as ObjFileReader has always read them
+        EXPECT_EQ(single.objects()[0].name, "Before_700");
+        EXPECT_EQ(single.objects()[0].firstFace, 0u);
+        EXPECT_EQ(single.objects()[1].name, "");
+        EXPECT_EQ(single.objects()[2].name, "Before_2100");
+
+        for (unsigned int threads : { 2u, 3u, 4u, 7u })
+        {
+            ObjParser chunked;
+            ASSERT_TRUE(chunked.parse(obj.data(), obj.size(), 2.0f, threads));
+            EXPECT_EQ(chunked.chunkCount(), ObjParser::chunkCount(obj.size(), threads));
+            EXPECT_EQ(chunked.lineCount(), single.lineCount());
+            EXPECT_TRUE(chunked.positions() == single.positions());
+            EXPECT_TRUE(chunked.texCoords() == single.texCoords());
+            EXPECT_TRUE(chunked.normals() == single.normals());
+            ASSERT_EQ(chunked.corners().size(), single.corners().size());
+            for (std::size_t i = 0; i < single.corners().size(); ++i)
+            {
+                const ObjParser::Corner& expected = single.corners()[i];
+                const ObjParser::Corner& corner = chunked.corners()[i];
+                ASSERT_TRUE(corner.position == expected.position && corner.texCoord == expected.texCoord
+                            && corner.normal == expected.normal) << "corner " << i << " with " << threads << " threads";
+            }
+            ASSERT_EQ(chunked.faces().size(), single.faces().size());
+            for (std::size_t i = 0; i < single.faces().size(); ++i)
+            {
+                ASSERT_EQ(chunked.faces()[i].firstCorner, single.faces()[i].firstCorner);
+                ASSERT_EQ(chunked.faces()[i].cornerCount, single.faces()[i].cornerCount);
+            }
+            ASSERT_EQ(chunked.objects().size(), single.objects().size());
+            for (std::size_t i = 0; i < single.objects().size(); ++i)
+            {
+                EXPECT_EQ(chunked.objects()[i].name, single.objects()[i].name);
+                EXPECT_EQ(chunked.objects()[i].firstFace, single.objects()[i].firstFace);
+                EXPECT_EQ(chunked.objects()[i].faceCount, single.objects()[i].faceCount);
+            }
+        }
+
+        // an error in the last chunk fails the whole parse
+        obj += "f 1 2 999999\n";
+        ObjParser chunked;
+        EXPECT_FALSE(chunked.parse(obj.data(), obj.size(), 1.0f, 4));
+    }
+}
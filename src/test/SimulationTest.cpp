@@ -0,0 +1,147 @@
+#include "../Simulation.h"
+#include "../SimulationThread.h"
+#include "../Utils.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    class SimulationTest : public ::testing::Test
+    {
+    protected:
+        SimulationTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~SimulationTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(SimulationTest, VehiclesLandAndDrive)
+    {
+        Simulation simulation;
+        simulation.landscape().generate(Landscape::Type::FLAT);
+
+        const std::size_t falling = simulation.addVehicle(glm::vec3(10.0f, 10.0f, 5.0f));
+        const std::size_t driving = simulation.addVehicle(glm::vec3(20.0f, 20.0f, 0.0f));
+        EXPECT_EQ(simulation.vehicleCount(), 2u);
+        simulation.vehicle(driving).accelerate(0.5);
+
+        simulation.step();
+        EXPECT_EQ(simulation.tick(), 1u);
+        EXPECT_FALSE(simulation.isOnGround(falling));
+        EXPECT_TRUE(simulation.isOnGround(driving));
+        EXPECT_LT(simulation.vehicle(falling).position().z, 5.0f);
+
+        // gravity pulls the first vehicle down by 0.1 per step until it lands
+        for (int i = 0; i < 60; ++i)
+        {
+            simulation.step();
+        }
+        EXPECT_EQ(simulation.tick(), 61u);
+        EXPECT_TRUE(simulation.isOnGround(falling));
+        EXPECT_EQ(simulation.vehicle(falling).position().z, 0.0f);
+        EXPECT_EQ(simulation.vehicle(falling).position().x, 10.0f);
+
+        // the second one drove along x on the ground
+        const glm::vec3 position = simulation.vehicle(driving).position();
+        EXPECT_NEAR(position.x, 20.0f + 61 * 0.5f, 1e-3f);
+        EXPECT_NEAR(position.y, 20.0f, 1e-3f);
+        EXPECT_EQ(position.z, 0.0f);
+    }
+
+    TEST(SimulationTest, InterpolatesPoses)
+    {
+        Simulation simulation;
+        simulation.landscape().generate(Landscape::Type::FLAT);
+        const std::size_t vehicle = simulation.addVehicle(glm::vec3(10.0f, 10.0f, 0.0f));
+        simulation.vehicle(vehicle).accelerate(1.0);
+        simulation.vehicle(vehicle).setYaw(90.0f);
+
+        simulation.step();
+        EXPECT_NEAR(simulation.pose(vehicle, 0.0f).position.y, 10.0f, 1e-4f);
+        EXPECT_NEAR(simulation.pose(vehicle, 0.25f).position.y, 10.25f, 1e-4f);
+        EXPECT_NEAR(simulation.pose(vehicle, 1.0f).position.y, 11.0f, 1e-4f);
+
+        // a tank pitched on flat ground levels out a little per step
+        simulation.vehicle(vehicle).setPitch(20.0f);
+        simulation.step();
+        const glm::quat before = simulation.pose(vehicle, 0.0f).orientation;
+        const glm::quat after = simulation.pose(vehicle, 1.0f).orientation;
+        const glm::quat halfway = simulation.pose(vehicle, 0.5f).orientation;
+        EXPECT_NEAR(std::fabs(glm::dot(before, Utils::quatFromEuler(0.0f, 20.0f, 90.0f))), 1.0f, 1e-5f);
+        EXPECT_NEAR(std::fabs(glm::dot(after, simulation.vehicle(vehicle).orientation())), 1.0f, 1e-5f);
+        EXPECT_LT(std::fabs(glm::dot(before, after)), 0.9999f);
+        EXPECT_NEAR(std::fabs(glm::dot(halfway, before)), std::fabs(glm::dot(halfway, after)), 1e-5f);
+        EXPECT_EQ(simulation.pose(vehicle, 0.5f).yaw, 90.0f);
+
+        // the yaw, which the camera follows, turns the short way round
+        Simulation::Pose from = simulation.pose(vehicle, 0.0f);
+        Simulation::Pose to = from;
+        from.yaw = 350.0f;
+        to.yaw = 10.0f;
+        EXPECT_NEAR(std::fmod(Simulation::interpolate(from, to, 0.75f).yaw + 360.0f, 360.0f), 5.0f, 1e-4f);
+    }
+
+    TEST(SimulationTest, Thread)
+    {
+        Simulation simulation;
+        simulation.landscape().generate(Landscape::Type::FLAT);
+        const std::size_t vehicle = simulation.addVehicle(glm::vec3(10.0f, 10.0f, 0.0f));
+
+        // the input runs on the simulation thread before every tick
+        std::atomic<int> inputs(0);
+        SimulationThread thread(simulation, [&](Simulation& simulation, SimulationThread::Camera& camera)
+        {
+            if (inputs++ == 0)
+            {
+                simulation.vehicle(vehicle).accelerate(0.5);
+                camera.angle = 90.0f;
+            }
+        }, 1000);
+
+        // the state before the first tick is published right away
+        const SimulationThread::Snapshot& first = thread.latest();
+        EXPECT_EQ(first.tick, 0u);
+        ASSERT_EQ(first.current.size(), 1u);
+        EXPECT_EQ(first.current[vehicle].position.x, 10.0f);
+
+        thread.start();
+        EXPECT_TRUE(thread.isRunning());
+        while (thread.latest().tick < 20)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        thread.stop();
+        EXPECT_FALSE(thread.isRunning());
+
+        // the vehicle drove 0.5 per tick, the input ran once per tick
+        const SimulationThread::Snapshot& snapshot = thread.latest();
+        EXPECT_EQ(snapshot.tick, simulation.tick());
+        EXPECT_EQ((int) snapshot.tick, inputs.load());
+        EXPECT_NEAR(snapshot.current[vehicle].position.x, 10.0f + snapshot.tick * 0.5f, 1e-3f);
+        EXPECT_NEAR(snapshot.previous[vehicle].position.x, snapshot.current[vehicle].position.x - 0.5f, 1e-3f);
+        EXPECT_EQ(snapshot.camera.angle, 90.0f);
+        EXPECT_TRUE(snapshot.isOnGround);
+        EXPECT_FLOAT_EQ(thread.alpha(snapshot, snapshot.tickTimeUs + 500), 0.5f);
+        EXPECT_EQ(thread.alpha(snapshot, snapshot.tickTimeUs + 5000), 1.0f);
+    }
+}
@@ -0,0 +1,82 @@
+#include "../utils/SpscQueue.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+namespace
+{
+    class SpscQueueTest : public ::testing::Test
+    {
+    protected:
+        SpscQueueTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~SpscQueueTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(SpscQueueTest, Bounded)
+    {
+        SpscQueue<int, 4> queue;
+        int value;
+        EXPECT_TRUE(queue.empty());
+        EXPECT_FALSE(queue.pop(value));
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(queue.push(i));
+        }
+        EXPECT_FALSE(queue.push(4));
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(queue.pop(value));
+            EXPECT_EQ(i, value);
+        }
+        EXPECT_TRUE(queue.empty());
+    }
+
+    TEST(SpscQueueTest, TwoThreads)
+    {
+        SpscQueue<int, 16> queue;
+        const int count = 100000;
+        std::thread producer([&]()
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                while (!queue.push(i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        // every value arrives once and in order
+        int expected = 0;
+        while (expected < count)
+        {
+            int value;
+            if (queue.pop(value))
+            {
+                ASSERT_EQ(expected, value);
+                expected++;
+            }
+        }
+        producer.join();
+        EXPECT_TRUE(queue.empty());
+    }
+}
@@ -0,0 +1,205 @@
+#include "../TerrainLod.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace
+{
+    class TerrainLodTest : public ::testing::Test
+    {
+    protected:
+        TerrainLodTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TerrainLodTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    // a grid in the x/z plane with y up, the way Terrain lays out its vertices
+    std::vector<glm::vec3> grid(unsigned int width, unsigned int height, float amplitude)
+    {
+        std::vector<glm::vec3> positions;
+        for (unsigned int j = 0; j < height; ++j)
+        {
+            for (unsigned int i = 0; i < width; ++i)
+            {
+                positions.push_back(glm::vec3(i * 2.0f, std::sin(i * 0.3f) * std::cos(j * 0.2f) * amplitude, j * 2.0f));
+            }
+        }
+        return positions;
+    }
+
+    TEST(TerrainLodTest, Patterns)
+    {
+        // 112 x 96 quads: 4 x 3 chunks, the last column is 16 quads wide
+        const unsigned int width = 113;
+        const unsigned int height = 97;
+        const std::vector<glm::vec3> positions = grid(width, height, 10.0f);
+        TerrainLod lod;
+        lod.build(positions, width, height);
+        ASSERT_EQ(lod.chunksX(), 4);
+        ASSERT_EQ(lod.chunksY(), 3);
+        EXPECT_EQ(lod.maxLevel(0), TerrainLod::MaxLevel);
+        EXPECT_EQ(lod.maxLevel(3), 4);
+
+        const std::vector<GLushort>& indices = lod.indices();
+        const std::vector<GLuint> gridVertices = lod.gridVertices();
+        ASSERT_EQ(gridVertices.size(), (size_t) lod.vertexCount());
+        EXPECT_EQ(lod.vertexCount(), 3u * 33 * (3 * 33 + 17));
+        for (int chunk = 0; chunk < 4; ++chunk)
+        {
+            const float area = (chunk == 3 ? 16 : 32) * 32 * 4.0f;
+            for (int level = 0; level <= lod.maxLevel(chunk); ++level)
+            {
+                for (int mask = 0; mask < 16; ++mask)
+                {
+                    // a side can only border a coarser chunk if it is made of an even number of steps
+                    const unsigned int step = 1u << level;
+                    const unsigned int chunkWidth = chunk == 3 ? 16 : 32;
+                    if (((mask & (TerrainLod::LEFT | TerrainLod::RIGHT)) && 32 % (2 * step) != 0) ||
+                        ((mask & (TerrainLod::BOTTOM | TerrainLod::TOP)) && chunkWidth % (2 * step) != 0))
+                        continue;
+
+                    // the triangles cover the chunk without overlaps: all of them
+                    // keep their orientation and their areas add up to the chunk
+                    const TerrainLod::Pattern& pattern = lod.pattern(chunk, level, mask);
+                    float sum = 0.0f;
+                    for (GLsizei i = 0; i < pattern.indexCount; i += 3)
+                    {
+                        const glm::vec3& a = positions[gridVertices[lod.baseVertex(chunk) + indices[pattern.firstIndex + i]]];
+                        const glm::vec3& b = positions[gridVertices[lod.baseVertex(chunk) + indices[pattern.firstIndex + i + 1]]];
+                        const glm::vec3& c = positions[gridVertices[lod.baseVertex(chunk) + indices[pattern.firstIndex + i + 2]]];
+                        const float signedArea = ((c.x - a.x) * (b.z - a.z) - (b.x - a.x) * (c.z - a.z)) / 2.0f;
+                        EXPECT_GE(signedArea, 0.0f) << "level " << level << " mask " << mask;
+                        sum += signedArea;
+                        EXPECT_LE(indices[pattern.firstIndex + i], pattern.maxVertex);
+                    }
+                    EXPECT_FLOAT_EQ(sum, area) << "level " << level << " mask " << mask;
+                }
+            }
+            const size_t quads = (chunk == 3 ? 16 : 32) * 32;
+            EXPECT_EQ((size_t) lod.pattern(chunk, 0, 0).indexCount, quads * 6);
+            EXPECT_EQ((size_t) lod.pattern(chunk, 2, 0).indexCount, quads / 16 * 6);
+        }
+    }
+
+    TEST(TerrainLodTest, Select)
+    {
+        const unsigned int width = 257;
+        const unsigned int height = 193;
+        const std::vector<glm::vec3> positions = grid(width, height, 10.0f);
+        TerrainLod lod;
+        lod.build(positions, width, height);
+        const std::vector<GLuint> gridVertices = lod.gridVertices();
+
+        for (int chunk = 0; chunk < lod.chunksX() * lod.chunksY(); ++chunk)
+        {
+            EXPECT_EQ(lod.error(chunk, 0), 0.0f);
+            for (int level = 1; level <= TerrainLod::MaxLevel; ++level)
+            {
+                EXPECT_GE(lod.error(chunk, level), lod.error(chunk, level - 1));
+            }
+        }
+
+        // standing on the first chunk and looking over the terrain
+        lod.select(glm::vec3(5, 20, 5), 400.0f, 2.0f);
+        EXPECT_EQ(lod.level(0), 0);
+        const int last = lod.chunksX() * lod.chunksY() - 1;
+        EXPECT_GT(lod.level(last), 0);
+
+        for (int cy = 0; cy < lod.chunksY(); ++cy)
+        {
+            for (int cx = 0; cx < lod.chunksX(); ++cx)
+            {
+                const int chunk = cy * lod.chunksX() + cx;
+                EXPECT_LE(lod.level(chunk), lod.maxLevel(chunk));
+
+                // neighbours differ by one level at most, and share the vertices of their common side
+                const int neighbours[2][3] = { { cx + 1, cy, TerrainLod::RIGHT }, { cx, cy + 1, TerrainLod::TOP } };
+                for (const auto& n : neighbours)
+                {
+                    if (n[0] >= lod.chunksX() || n[1] >= lod.chunksY())
+                        continue;
+                    const int other = n[1] * lod.chunksX() + n[0];
+                    EXPECT_LE(std::abs(lod.level(chunk) - lod.level(other)), 1);
+
+                    const GLuint firstShared = gridVertices[lod.baseVertex(other)];
+                    auto side = [&](int c) -> std::set<GLuint>
+                    {
+                        std::set<GLuint> vertices;
+                        const TerrainLod::Pattern& pattern = lod.pattern(c);
+                        for (GLsizei i = 0; i < pattern.indexCount; ++i)
+                        {
+                            const GLuint v = gridVertices[lod.baseVertex(c) + lod.indices()[pattern.firstIndex + i]];
+                            const bool onSide = n[2] == TerrainLod::RIGHT ?
+                                            v % width == firstShared % width :
+                                            v / width == firstShared / width;
+                            if (onSide)
+                            {
+                                vertices.insert(v);
+                            }
+                        }
+                        return vertices;
+                    };
+                    EXPECT_EQ(side(chunk), side(other)) << "chunks " << chunk << " and " << other;
+                }
+            }
+        }
+    }
+
+    TEST(TerrainLodTest, Flat)
+    {
+        const std::vector<glm::vec3> positions = grid(65, 65, 0.0f);
+        TerrainLod lod;
+        lod.build(positions, 65, 65);
+        // nothing to lose, everything but the chunk below the camera is as coarse as it gets
+        lod.select(glm::vec3(10, 5, 10), 400.0f, 2.0f);
+        EXPECT_EQ(lod.level(0), TerrainLod::MaxLevel);
+        EXPECT_EQ(lod.level(3), TerrainLod::MaxLevel);
+        EXPECT_EQ(lod.pattern(3).indexCount, 6);
+    }
+
+    TEST(TerrainLodTest, CacheStrips)
+    {
+        const std::vector<glm::vec3> positions = grid(129, 129, 10.0f);
+        TerrainLod rows;
+        rows.build(positions, 129, 129, TerrainLod::ChunkQuads);
+        TerrainLod strips;
+        strips.build(positions, 129, 129);
+
+        // the same triangles in another order
+        const TerrainLod::Pattern& a = rows.pattern(0, 0, 0);
+        const TerrainLod::Pattern& b = strips.pattern(0, 0, 0);
+        ASSERT_EQ(a.indexCount, b.indexCount);
+        std::multiset<std::vector<GLushort>> ta, tb;
+        for (GLsizei i = 0; i < a.indexCount; i += 3)
+        {
+            ta.insert(std::vector<GLushort>(rows.indices().begin() + a.firstIndex + i, rows.indices().begin() + a.firstIndex + i + 3));
+            tb.insert(std::vector<GLushort>(strips.indices().begin() + b.firstIndex + i, strips.indices().begin() + b.firstIndex + i + 3));
+        }
+        EXPECT_EQ(ta, tb);
+
+        // row by row, every vertex of a row is evicted before the next row needs it
+        EXPECT_GT(rows.fullResolutionAcmr(16), 1.0);
+        EXPECT_LT(strips.fullResolutionAcmr(16), 0.65);
+        EXPECT_LT(strips.fullResolutionAcmr(32), 0.65);
+    }
+}
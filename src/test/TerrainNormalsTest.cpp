@@ -0,0 +1,114 @@
+#include "../TerrainNormals.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    class TerrainNormalsTest : public ::testing::Test
+    {
+    protected:
+        TerrainNormalsTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TerrainNormalsTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(TerrainNormalsTest, Slope)
+    {
+        // a plane rising by 0.5 per unit along x and falling by 0.25 along z
+        const unsigned int width = 37;
+        const unsigned int height = 29;
+        const float spacingX = 2.0f;
+        const float spacingZ = 3.0f;
+        std::vector<float> heights(width * height);
+        for (unsigned int j = 0; j < height; ++j)
+        {
+            for (unsigned int i = 0; i < width; ++i)
+            {
+                heights[j * width + i] = 0.5f * i * spacingX - 0.25f * j * spacingZ;
+            }
+        }
+        std::vector<glm::vec3> normals(heights.size());
+        std::vector<glm::vec4> colors(heights.size(), glm::vec4(1.0f, 1.0f, 1.0f, 0.5f));
+        TerrainNormals::generate(heights.data(), width, height, spacingX, spacingZ, normals.data(), colors.data());
+
+        const float length = std::sqrt(0.5f * 0.5f + 1.0f + 0.25f * 0.25f);
+        for (size_t i = 0; i < normals.size(); ++i)
+        {
+            // borders included
+            EXPECT_NEAR(normals[i].x, -0.5f / length, 1e-5f) << i;
+            EXPECT_NEAR(normals[i].y, 1.0f / length, 1e-5f) << i;
+            EXPECT_NEAR(normals[i].z, 0.25f / length, 1e-5f) << i;
+            EXPECT_EQ(colors[i].x, normals[i].y - 0.1f);
+            EXPECT_EQ(colors[i].y, colors[i].x);
+            EXPECT_EQ(colors[i].z, colors[i].x);
+            EXPECT_EQ(colors[i].w, 0.5f);
+        }
+
+        // steep slopes get no grass
+        for (float& h : heights)
+        {
+            h *= 100.0f;
+        }
+        TerrainNormals::generate(heights.data(), width, height, spacingX, spacingZ, normals.data(), colors.data());
+        EXPECT_EQ(colors[100].x, 0.0f);
+    }
+
+    TEST(TerrainNormalsTest, KernelsAndThreadsAgree)
+    {
+        // rows that are no multiple of the lanes and enough of them for several bands
+        const unsigned int width = 301;
+        const unsigned int height = 4 * TerrainNormals::MinBandRows + 5;
+        std::mt19937 generator;
+        std::uniform_real_distribution<float> dis(0.0f, 100.0f);
+        std::vector<float> heights(width * height);
+        for (float& h : heights)
+        {
+            h = dis(generator);
+        }
+
+        std::vector<glm::vec3> expectedNormals(heights.size());
+        std::vector<glm::vec4> expectedColors(heights.size(), glm::vec4(0.0f));
+        TerrainNormals::generateScalar(heights.data(), width, height, 1.5f, 2.5f, expectedNormals.data(), expectedColors.data());
+
+        EXPECT_EQ(TerrainNormals::threadCount(height, 3), 3u);
+        EXPECT_EQ(TerrainNormals::threadCount(height, 64), 4u);
+        EXPECT_EQ(TerrainNormals::threadCount(10, 8), 1u);
+        for (unsigned int threads : { 1u, 3u, 4u, 0u })
+        {
+            std::vector<glm::vec3> normals(heights.size());
+            std::vector<glm::vec4> colors(heights.size(), glm::vec4(0.0f));
+            TerrainNormals::generate(heights.data(), width, height, 1.5f, 2.5f, normals.data(), colors.data(), threads);
+            EXPECT_EQ(memcmp(normals.data(), expectedNormals.data(), normals.size() * sizeof(glm::vec3)), 0)
+                << TerrainNormals::kernelName() << ", " << threads << " threads";
+            EXPECT_EQ(memcmp(colors.data(), expectedColors.data(), colors.size() * sizeof(glm::vec4)), 0)
+                << TerrainNormals::kernelName() << ", " << threads << " threads";
+        }
+
+        // without colors
+        std::vector<glm::vec3> normals(heights.size());
+        TerrainNormals::generate(heights.data(), width, height, 1.5f, 2.5f, normals.data(), nullptr, 2);
+        EXPECT_EQ(memcmp(normals.data(), expectedNormals.data(), normals.size() * sizeof(glm::vec3)), 0);
+    }
+}
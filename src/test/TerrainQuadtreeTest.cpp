@@ -0,0 +1,143 @@
+#include "../TerrainQuadtree.h"
+#include "gtest/gtest.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    class TerrainQuadtreeTest : public ::testing::Test
+    {
+    protected:
+        TerrainQuadtreeTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TerrainQuadtreeTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    // a wavy grid in the x/z plane with y up, the way Terrain lays out its vertices
+    std::vector<glm::vec3> grid(unsigned int width, unsigned int height)
+    {
+        std::vector<glm::vec3> positions;
+        for (unsigned int j = 0; j < height; ++j)
+        {
+            for (unsigned int i = 0; i < width; ++i)
+            {
+                positions.push_back(glm::vec3(i * 2.0f, std::sin(i * 0.1f) * std::cos(j * 0.1f) * 20.0f, j * 2.0f));
+            }
+        }
+        return positions;
+    }
+
+    TEST(TerrainQuadtreeTest, Build)
+    {
+        const unsigned int width = 101;
+        const unsigned int height = 70;
+        const unsigned int leafQuads = 16;
+        const std::vector<glm::vec3> positions = grid(width, height);
+        TerrainQuadtree tree;
+        tree.build(positions, width, height, leafQuads);
+
+        // the leaves cover every quad of the grid exactly once and bound its vertices
+        const std::vector<TerrainQuadtree::Node>& nodes = tree.nodes();
+        ASSERT_FALSE(nodes.empty());
+        std::vector<int> covered((width - 1) * (height - 1), 0);
+        for (const TerrainQuadtree::Node& node : nodes)
+        {
+            if (node.children[0] >= 0)
+            {
+                // children lie within their parent
+                for (int child = 0; child < 4 && node.children[child] >= 0; ++child)
+                {
+                    const TerrainQuadtree::Node& c = nodes[node.children[child]];
+                    EXPECT_TRUE(c.min.x >= node.min.x && c.min.y >= node.min.y && c.min.z >= node.min.z);
+                    EXPECT_TRUE(c.max.x <= node.max.x && c.max.y <= node.max.y && c.max.z <= node.max.z);
+                }
+                continue;
+            }
+            const unsigned int endX = std::min(node.quadX + leafQuads, width - 1);
+            const unsigned int endY = std::min(node.quadY + leafQuads, height - 1);
+            for (unsigned int j = node.quadY; j < endY; ++j)
+            {
+                for (unsigned int i = node.quadX; i < endX; ++i)
+                {
+                    covered[j * (width - 1) + i]++;
+                    const glm::vec3& p = positions[j * width + i];
+                    EXPECT_TRUE(p.x >= node.min.x && p.y >= node.min.y && p.z >= node.min.z);
+                    EXPECT_TRUE(p.x <= node.max.x && p.y <= node.max.y && p.z <= node.max.z);
+                }
+            }
+        }
+        for (size_t quad = 0; quad < covered.size(); ++quad)
+        {
+            EXPECT_EQ(covered[quad], 1) << "quad " << quad;
+        }
+    }
+
+    TEST(TerrainQuadtreeTest, CollectLeaves)
+    {
+        const unsigned int width = 129;
+        const unsigned int height = 129;
+        const unsigned int leafQuads = 32;
+        const std::vector<glm::vec3> positions = grid(width, height);
+        TerrainQuadtree tree;
+        tree.build(positions, width, height, leafQuads);
+        const glm::mat4 projection = glm::frustum(-1.0f, 1.0f, -1.0f, 1.0f, 1.5f, 1010.0f);
+        std::vector<int> leaves;
+
+        // from far above, every leaf is visible
+        const Frustum above(projection * glm::lookAt(glm::vec3(128, 800, 128), glm::vec3(128, 0, 128), glm::vec3(0, 0, 1)));
+        tree.collectLeaves(above, leaves);
+        EXPECT_EQ(leaves.size(), 16u);
+
+        // looking away from the terrain, none is
+        const Frustum away(projection * glm::lookAt(glm::vec3(-10, 10, -10), glm::vec3(-20, 10, -20), glm::vec3(0, 1, 0)));
+        tree.collectLeaves(away, leaves);
+        EXPECT_TRUE(leaves.empty());
+
+        // a narrow view from a corner towards the center sees a part; every vertex in view is in a visible leaf
+        const glm::mat4 narrow = glm::frustum(-0.2f, 0.2f, -0.2f, 0.2f, 1.5f, 1010.0f);
+        const Frustum corner(narrow * glm::lookAt(glm::vec3(-5, 30, -5), glm::vec3(20, 0, 20), glm::vec3(0, 1, 0)));
+        tree.collectLeaves(corner, leaves);
+        EXPECT_GT(leaves.size(), 0u);
+        EXPECT_LT(leaves.size(), 16u);
+        std::vector<bool> visible(positions.size(), false);
+        for (int leaf : leaves)
+        {
+            const TerrainQuadtree::Node& node = tree.nodes()[leaf];
+            EXPECT_LT(node.children[0], 0);
+            for (unsigned int j = node.quadY; j <= std::min(node.quadY + leafQuads, height - 1); ++j)
+            {
+                for (unsigned int i = node.quadX; i <= std::min(node.quadX + leafQuads, width - 1); ++i)
+                {
+                    visible[j * width + i] = true;
+                }
+            }
+        }
+        for (size_t v = 0; v < positions.size(); ++v)
+        {
+            if (corner.contains(positions[v]))
+            {
+                EXPECT_TRUE(visible[v]) << "vertex " << v;
+            }
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#include "../TerrainVertex.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+namespace
+{
+    class TerrainVertexTest : public ::testing::Test
+    {
+    protected:
+        TerrainVertexTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TerrainVertexTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(TerrainVertexTest, Layout)
+    {
+        // every array lies inside the vertex and they do not overlap
+        std::size_t end = 0;
+        for (const TerrainVertex::Attribute& attribute : TerrainVertexLayout)
+        {
+            const std::size_t bytes = attribute.type == GL_FLOAT ? sizeof(GLfloat) : 1;
+            EXPECT_GE(attribute.offset, end);
+            EXPECT_EQ(attribute.offset % 4, 0u);
+            end = attribute.offset + attribute.size * bytes;
+            EXPECT_LE(end, sizeof(TerrainVertex));
+        }
+        EXPECT_EQ(TerrainVertexLayout[0].array, (GLenum) GL_VERTEX_ARRAY);
+    }
+
+    TEST(TerrainVertexTest, Quantisation)
+    {
+        const glm::vec3 position(-1024.5f, 371.25f, 12.0f);
+        const glm::vec3 normal = glm::vec3(0.3f, 0.9f, -0.2f) / std::sqrt(0.3f * 0.3f + 0.9f * 0.9f + 0.2f * 0.2f);
+        const glm::vec4 color(0.0f, 0.5f, 1.0f, 0.25f);
+        const TerrainVertex vertex = TerrainVertex::pack(position, normal, color);
+
+        EXPECT_EQ(vertex.position[0], position.x);
+        EXPECT_EQ(vertex.position[1], position.y);
+        EXPECT_EQ(vertex.position[2], position.z);
+
+        // at most half a step off
+        const glm::vec3 n = vertex.unpackNormal();
+        EXPECT_NEAR(n.x, normal.x, 0.51f / 127.0f);
+        EXPECT_NEAR(n.y, normal.y, 0.51f / 127.0f);
+        EXPECT_NEAR(n.z, normal.z, 0.51f / 127.0f);
+
+        const glm::vec4 c = vertex.unpackColor();
+        EXPECT_EQ(c.x, 0.0f);
+        EXPECT_NEAR(c.y, 0.5f, 0.51f / 255.0f);
+        EXPECT_EQ(c.z, 1.0f);
+        EXPECT_NEAR(c.w, 0.25f, 0.51f / 255.0f);
+
+        // out of range values are clamped
+        const TerrainVertex clamped = TerrainVertex::pack(position, glm::vec3(-2.0f, 0.0f, 1.5f), glm::vec4(-1.0f, 2.0f, 0.0f, 1.0f));
+        EXPECT_EQ(clamped.normal[0], -127);
+        EXPECT_EQ(clamped.normal[2], 127);
+        EXPECT_EQ(clamped.color[0], 0);
+        EXPECT_EQ(clamped.color[1], 255);
+    }
+}
@@ -0,0 +1,120 @@
+#include "../TilePrefetcher.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+    class TilePrefetcherTest : public ::testing::Test
+    {
+    protected:
+        TilePrefetcherTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TilePrefetcherTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    class RampSource : public HeightSource
+    {
+    public:
+        int sizeX() const override
+        {
+            return 2048;
+        }
+
+        int sizeY() const override
+        {
+            return 512;
+        }
+
+        float spacing() const override
+        {
+            return 1.0f;
+        }
+
+        float height(int x, int y) const override
+        {
+            return x * 0.01f + y * 0.02f;
+        }
+    };
+
+    const char* TestFile = "TilePrefetcherTest.thf";
+    const std::size_t TileBytes = 64 * 64 * sizeof(float);
+
+    TEST(TilePrefetcherTest, Prediction)
+    {
+        RampSource source;
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 64));
+        TiledHeightfield tiles;
+        ASSERT_TRUE(tiles.open(TestFile, 64 * TileBytes));
+        {
+            TilePrefetcher prefetcher(tiles, 1.0f, 60.0f, 10.0f);
+
+            // standing still: only the tile below the vehicle
+            prefetcher.update(glm::vec3(100.0f, 100.0f, 0.0f), 0.0, 0.0f);
+            ASSERT_EQ(1u, prefetcher.predicted().size());
+            EXPECT_EQ(1 * tiles.tilesY() + 1, prefetcher.predicted()[0]);
+
+            // 60 units ahead along +x, nearest tiles first
+            prefetcher.update(glm::vec3(100.0f, 100.0f, 0.0f), 1.0, 0.0f);
+            ASSERT_EQ(2u, prefetcher.predicted().size());
+            EXPECT_EQ(1 * tiles.tilesY() + 1, prefetcher.predicted()[0]);
+            EXPECT_EQ(2 * tiles.tilesY() + 1, prefetcher.predicted()[1]);
+
+            // yaw 90 drives along +y, a negative velocity backwards
+            prefetcher.update(glm::vec3(100.0f, 100.0f, 0.0f), -1.0, 90.0f);
+            ASSERT_EQ(2u, prefetcher.predicted().size());
+            EXPECT_EQ(1 * tiles.tilesY() + 0, prefetcher.predicted()[1]);
+        }
+        std::remove(TestFile);
+    }
+
+    TEST(TilePrefetcherTest, Drive)
+    {
+        RampSource source;
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 64));
+        TiledHeightfield tiles;
+        ASSERT_TRUE(tiles.open(TestFile, 16 * TileBytes));
+        {
+            TilePrefetcher prefetcher(tiles, 1.0f, 60.0f, 4.0f);
+            glm::vec3 position(10.0f, 200.0f, 0.0f);
+            const double velocity = 3.0;
+            for (int step = 0; step < 600; ++step)
+            {
+                prefetcher.update(position, velocity, 0.0f);
+                EXPECT_EQ(source.height((int) position.x, (int) position.y), tiles.height((int) position.x, (int) position.y));
+                EXPECT_LE(tiles.residentBytes(), tiles.budget());
+                position.x += velocity;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            // only the first tile is loaded on this thread
+            const TilePrefetcher::Stats stats = prefetcher.stats();
+            EXPECT_GT(stats.requested, 0u);
+            EXPECT_GT(stats.hits, 20u);
+            EXPECT_LE(stats.misses, 2u);
+            EXPECT_GT(stats.hitRate(), 0.9);
+        }
+        std::remove(TestFile);
+    }
+}
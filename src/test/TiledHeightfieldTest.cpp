@@ -0,0 +1,284 @@
+#include "LandscapeMock.h"
+#include "../TiledHeightfield.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    class TiledHeightfieldTest : public ::testing::Test
+    {
+    protected:
+        TiledHeightfieldTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TiledHeightfieldTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    class WaveSource : public HeightSource
+    {
+    public:
+        int sizeX() const override
+        {
+            return 300;
+        }
+
+        int sizeY() const override
+        {
+            return 200;
+        }
+
+        float spacing() const override
+        {
+            return 2.5f;
+        }
+
+        float height(int x, int y) const override
+        {
+            return std::sin(x * 0.1f) * 20.0f + y * 0.5f;
+        }
+    };
+
+    const char* TestFile = "TiledHeightfieldTest.thf";
+
+    TEST(TiledHeightfieldTest, RoundTrip)
+    {
+        WaveSource source;
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 64));
+
+        TiledHeightfield tiled;
+        ASSERT_TRUE(tiled.open(TestFile, 1 << 20));
+        EXPECT_EQ(300, tiled.sizeX());
+        EXPECT_EQ(200, tiled.sizeY());
+        EXPECT_EQ(2.5f, tiled.spacing());
+        EXPECT_EQ(5, tiled.tilesX());
+        EXPECT_EQ(4, tiled.tilesY());
+        for (int x = 0; x < source.sizeX(); ++x)
+        {
+            for (int y = 0; y < source.sizeY(); ++y)
+            {
+                EXPECT_EQ(source.height(x, y), tiled.height(x, y));
+            }
+        }
+        // clamped like HeightfieldSource
+        EXPECT_EQ(source.height(0, 0), tiled.height(-5, -1));
+        EXPECT_EQ(source.height(299, 199), tiled.height(1000, 1000));
+
+        // a cell across the corner of four tiles
+        float h00, h01, h10, h11;
+        tiled.cellHeights(63, 63, h00, h01, h10, h11);
+        EXPECT_EQ(source.height(63, 63), h00);
+        EXPECT_EQ(source.height(63, 64), h01);
+        EXPECT_EQ(source.height(64, 63), h10);
+        EXPECT_EQ(source.height(64, 64), h11);
+        std::remove(TestFile);
+    }
+
+    TEST(TiledHeightfieldTest, Budget)
+    {
+        WaveSource source;
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 64));
+
+        TiledHeightfield tiled;
+        const std::size_t tileBytes = 64 * 64 * sizeof(float);
+        ASSERT_TRUE(tiled.open(TestFile, 3 * tileBytes));
+        EXPECT_EQ(3 * tileBytes, tiled.budget());
+        for (int x = 0; x < source.sizeX(); x += 7)
+        {
+            for (int y = 0; y < source.sizeY(); y += 3)
+            {
+                EXPECT_EQ(source.height(x, y), tiled.height(x, y));
+                EXPECT_LE(tiled.residentBytes(), tiled.budget());
+            }
+        }
+        EXPECT_EQ(3u, tiled.residentTiles());
+
+        // a working set that fits is not loaded again
+        tiled.height(0, 0);
+        tiled.height(100, 0);
+        const std::size_t loads = tiled.tileLoads();
+        for (int i = 0; i < 10; ++i)
+        {
+            EXPECT_EQ(source.height(10, 10), tiled.height(10, 10));
+            EXPECT_EQ(source.height(100, 5), tiled.height(100, 5));
+        }
+        EXPECT_EQ(loads, tiled.tileLoads());
+
+        tiled.close();
+        EXPECT_FALSE(tiled.isOpen());
+        EXPECT_EQ(0u, tiled.residentTiles());
+        std::remove(TestFile);
+    }
+
+    TEST(TiledHeightfieldTest, Threads)
+    {
+        WaveSource source;
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 64));
+
+        // two readers on opposite ends, so that they evict each other's tiles
+        TiledHeightfield tiled;
+        ASSERT_TRUE(tiled.open(TestFile, 2 * 64 * 64 * sizeof(float)));
+        std::atomic<int> mismatches(0);
+        auto read = [&](bool reverse)
+        {
+            for (int x = 0; x < source.sizeX(); x += 3)
+            {
+                for (int y = 0; y < source.sizeY(); y += 5)
+                {
+                    const int rx = reverse ? source.sizeX() - 1 - x : x;
+                    const int ry = reverse ? source.sizeY() - 1 - y : y;
+                    mismatches += source.height(rx, ry) != tiled.height(rx, ry) ? 1 : 0;
+                }
+            }
+        };
+        std::thread other(read, true);
+        read(false);
+        other.join();
+        EXPECT_EQ(0, mismatches.load());
+        EXPECT_LE(tiled.residentBytes(), tiled.budget());
+        std::remove(TestFile);
+    }
+
+    TEST(TiledHeightfieldTest, InvalidFile)
+    {
+        TiledHeightfield tiled;
+        EXPECT_FALSE(tiled.open("does-not-exist.thf", 1 << 20));
+
+        std::ofstream ofs(TestFile, std::ofstream::binary);
+        ofs << "this is not a heightfield at all";
+        ofs.close();
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        EXPECT_FALSE(tiled.isOpen());
+        std::remove(TestFile);
+    }
+
+    // write the test file with header changed by corrupt
+    template<typename Corrupt>
+    void writeCorrupt(Corrupt corrupt)
+    {
+        WaveSource source;
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 64));
+        std::fstream file(TestFile, std::fstream::binary | std::fstream::in | std::fstream::out);
+        TiledHeightfield::Header header;
+        file.read((char*) &header, sizeof(header));
+        corrupt(header);
+        file.seekp(0);
+        file.write((const char*) &header, sizeof(header));
+    }
+
+    TEST(TiledHeightfieldTest, CorruptHeader)
+    {
+        TiledHeightfield tiled;
+        writeCorrupt([](TiledHeightfield::Header& header) { header.spacing = 0.0f; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        writeCorrupt([](TiledHeightfield::Header& header) { header.spacing = -1.0f; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        writeCorrupt([](TiledHeightfield::Header& header) { header.spacing = NAN; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        writeCorrupt([](TiledHeightfield::Header& header) { header.tileSize = 0; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        writeCorrupt([](TiledHeightfield::Header& header) { header.tileSize = 1u << 31; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        // more tiles than the file holds
+        writeCorrupt([](TiledHeightfield::Header& header) { header.sizeX = 1u << 30; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        writeCorrupt([](TiledHeightfield::Header& header) { header.tileSize = 128; });
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        EXPECT_FALSE(tiled.isOpen());
+
+        // cut off in the last tile
+        writeCorrupt([](TiledHeightfield::Header&) {});
+        std::ifstream ifs(TestFile, std::ifstream::binary | std::ifstream::ate);
+        const std::streamoff size = ifs.tellg();
+        ifs.seekg(0);
+        std::vector<char> bytes((std::size_t) size - 100);
+        ifs.read(bytes.data(), bytes.size());
+        ifs.close();
+        std::ofstream ofs(TestFile, std::ofstream::binary | std::ofstream::trunc);
+        ofs.write(bytes.data(), bytes.size());
+        ofs.close();
+        EXPECT_FALSE(tiled.open(TestFile, 1 << 20));
+        EXPECT_FALSE(tiled.isOpen());
+        std::remove(TestFile);
+    }
+
+    TEST(TiledHeightfieldTest, Landscape)
+    {
+        LandscapeMock generated;
+        generated.generate(Landscape::Type::RANDOM);
+        const float scale = 10.0f;
+        HeightfieldSource source(generated.supportPoints(), scale);
+        ASSERT_TRUE(TiledHeightfield::write(TestFile, source, 32));
+
+        LandscapeMock tiled;
+        ASSERT_TRUE(tiled.openTiled(TestFile, 4 * 32 * 32 * sizeof(float)));
+        EXPECT_TRUE(tiled.isTiled());
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> dis(-20.0f, generated.dimX() * scale + 20.0f);
+        for (int i = 0; i < 1000; ++i)
+        {
+            const float x = dis(random);
+            const float y = dis(random);
+            float expectedAltitude, altitude;
+            glm::vec3 expectedNormal, normal;
+            generated.getLocalEnvironment(x, y, expectedAltitude, expectedNormal);
+            tiled.getLocalEnvironment(x, y, altitude, normal);
+            EXPECT_FLOAT_EQ(expectedAltitude, altitude);
+            EXPECT_FLOAT_EQ(expectedNormal.x, normal.x);
+            EXPECT_FLOAT_EQ(expectedNormal.y, normal.y);
+            EXPECT_FLOAT_EQ(expectedNormal.z, normal.z);
+            EXPECT_TRUE(generated.findTriangle(x, y) == tiled.findTriangle(x, y));
+
+            // the same index, and the triangle is only built from it on request
+            std::uint32_t expectedIndex, index;
+            generated.getLocalEnvironment(x, y, expectedAltitude, expectedNormal, expectedIndex);
+            tiled.getLocalEnvironment(x, y, altitude, normal, index);
+            EXPECT_EQ(expectedIndex, index);
+            EXPECT_TRUE(tiled.triangle(index) == generated.findTriangle(x, y));
+        }
+
+        // the batch query falls back to one point at a time
+        std::vector<glm::vec2> points(37);
+        for (glm::vec2& point : points)
+        {
+            point = glm::vec2(dis(random), dis(random));
+        }
+        std::vector<float> expectedAltitudes(points.size()), altitudes(points.size());
+        std::vector<glm::vec3> expectedNormals(points.size()), normals(points.size());
+        generated.getLocalEnvironments(points, expectedAltitudes, expectedNormals);
+        tiled.getLocalEnvironments(points, altitudes, normals);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            EXPECT_FLOAT_EQ(expectedAltitudes[i], altitudes[i]);
+            EXPECT_FLOAT_EQ(expectedNormals[i].z, normals[i].z);
+        }
+
+        tiled.generate(Landscape::Type::FLAT);
+        EXPECT_FALSE(tiled.isTiled());
+        std::remove(TestFile);
+    }
+}
@@ -0,0 +1,90 @@
+#include "../utils/TripleBuffer.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+namespace
+{
+    class TripleBufferTest : public ::testing::Test
+    {
+    protected:
+        TripleBufferTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~TripleBufferTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(TripleBufferTest, LatestValue)
+    {
+        TripleBuffer<int> buffer;
+        EXPECT_FALSE(buffer.update());
+
+        buffer.back() = 1;
+        buffer.publish();
+        EXPECT_TRUE(buffer.update());
+        EXPECT_EQ(buffer.front(), 1);
+        EXPECT_FALSE(buffer.update());
+        EXPECT_EQ(buffer.front(), 1);
+
+        // values published in between are skipped
+        for (int i = 2; i <= 5; ++i)
+        {
+            buffer.back() = i;
+            buffer.publish();
+        }
+        EXPECT_TRUE(buffer.update());
+        EXPECT_EQ(buffer.front(), 5);
+    }
+
+    TEST(TripleBufferTest, TwoThreads)
+    {
+        // a value the producer writes in several steps, to catch torn reads
+        struct Pair
+        {
+            int first;
+            int second;
+        };
+        TripleBuffer<Pair> buffer;
+        const int count = 100000;
+        std::thread producer([&]()
+        {
+            for (int i = 1; i <= count; ++i)
+            {
+                buffer.back().first = i;
+                buffer.back().second = -i;
+                buffer.publish();
+            }
+        });
+
+        // the values arrive complete and never go back in time
+        int last = 0;
+        while (last < count)
+        {
+            if (buffer.update())
+            {
+                const Pair& pair = buffer.front();
+                ASSERT_EQ(pair.first, -pair.second);
+                ASSERT_GT(pair.first, last);
+                last = pair.first;
+            }
+        }
+        producer.join();
+    }
+}
@@ -0,0 +1,58 @@
+#include "../VehicleInstances.h"
+#include "gtest/gtest.h"
+
+
+namespace
+{
+    class VehicleInstancesTest : public ::testing::Test
+    {
+    protected:
+        VehicleInstancesTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~VehicleInstancesTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(VehicleInstancesTest, CullsByDistance)
+    {
+        VehicleInstances instances;
+        // twice the size
+        glm::mat4 model;
+        model[0][0] = model[1][1] = model[2][2] = 2.0f;
+        instances.begin(glm::vec3(10, 0, 0), 5.0f, model);
+        instances.add(glm::vec3(10, 0, 0), glm::quat());
+        instances.add(glm::vec3(16, 0, 0), glm::quat());
+        instances.add(glm::vec3(13, 4, 0), glm::angleAxis(1.0f, glm::vec3(0, 0, 1)));
+        EXPECT_EQ(instances.stats().vehicles, 3u);
+        ASSERT_EQ(instances.transforms().size(), 2u);
+
+        // the model first, then the pose
+        const glm::vec4 origin = instances.transforms()[1] * glm::vec4(0, 0, 0, 1);
+        EXPECT_EQ(origin, glm::vec4(13, 4, 0, 1));
+        const glm::vec4 forward = instances.transforms()[0] * glm::vec4(1, 0, 0, 0);
+        EXPECT_EQ(forward, glm::vec4(2, 0, 0, 0));
+
+        // a new frame starts empty
+        instances.begin(glm::vec3(0, 0, 0), 1.0f, model);
+        EXPECT_TRUE(instances.transforms().empty());
+        EXPECT_EQ(instances.stats().vehicles, 0u);
+        EXPECT_FALSE(instances.isInstancingEnabled());
+    }
+}
@@ -0,0 +1,94 @@
+#include "../VehicleMesh.h"
+#include "../AssetCache.h"
+#include "gtest/gtest.h"
+
+
+namespace
+{
+    class VehicleMeshTest : public ::testing::Test
+    {
+    protected:
+        VehicleMeshTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~VehicleMeshTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(VehicleMeshTest, Triangulates)
+    {
+        // a quad and a pentagon sharing an edge, the wheel of a flat axle along y
+        std::vector<glm::vec3> quad = { glm::vec3(0, 0, 0), glm::vec3(2, 0, 0), glm::vec3(2, 0, 2), glm::vec3(0, 0, 2) };
+        std::vector<glm::vec3> pentagon = { glm::vec3(2, 0, 0), glm::vec3(4, 0, 0), glm::vec3(4, 0, 2),
+                                            glm::vec3(3, 0, 3), glm::vec3(2, 0, 2) };
+        VertexObject wheel;
+        wheel.addFace(4, quad, std::vector<glm::vec3>(4, glm::vec3(0, -1, 0)));
+        wheel.addFace(5, pentagon, std::vector<glm::vec3>(5, glm::vec3(0, -1, 0)));
+        std::map<std::string, VertexObject> parts;
+        parts["Wheel"] = wheel;
+        parts["Empty"] = VertexObject();
+
+        VehicleMesh mesh(parts);
+        ASSERT_EQ(mesh.parts().size(), 2u);
+        EXPECT_EQ(mesh.partIndex("Wheel"), 1);
+        EXPECT_EQ(mesh.partIndex("Chassis"), -1);
+        EXPECT_EQ(mesh.parts()[0].indexCount, 0);
+
+        // two and three triangles, the two vertices of the edge are shared
+        const VehicleMesh::Part& part = mesh.parts()[1];
+        EXPECT_EQ(part.firstIndex, 0);
+        EXPECT_EQ(part.indexCount, 15);
+        EXPECT_EQ(mesh.vertices().size(), 7u);
+        const std::vector<GLuint> fans = { 0, 1, 2, 0, 2, 3, 1, 4, 5, 1, 5, 6, 1, 6, 2 };
+        EXPECT_EQ(mesh.indices(), fans);
+        EXPECT_EQ(mesh.vertices()[6].position, glm::vec3(3, 0, 3));
+        EXPECT_EQ(mesh.vertices()[6].normal, glm::vec3(0, -1, 0));
+
+        EXPECT_EQ(part.pivot, glm::vec3(2, 0, 1.5f));
+        EXPECT_EQ(part.axle, glm::vec3(0, 1, 0));
+        EXPECT_EQ(part.radius, 2.0f);
+        EXPECT_FALSE(mesh.isUploaded());
+    }
+
+    TEST(VehicleMeshTest, SharedByCache)
+    {
+        AssetCache cache;
+        AssetCache::VehicleMeshHandle mesh = cache.loadVehicleMesh("../Vehicle.obj");
+        ASSERT_TRUE(mesh != nullptr);
+        EXPECT_EQ(cache.loadVehicleMesh("../Vehicle.obj"), mesh);
+        EXPECT_EQ(cache.loadCount(), 1u);
+        // the parsed mesh stays in use as long as the vehicle mesh
+        EXPECT_EQ(cache.meshCount(), 1u);
+
+        ASSERT_EQ(mesh->parts().size(), 5u);
+        for (const VehicleMesh::Part& part : mesh->parts())
+        {
+            EXPECT_GT(part.indexCount, 0);
+            EXPECT_EQ(part.indexCount % 3, 0);
+        }
+        const VehicleMesh::Part& wheel = mesh->parts()[mesh->partIndex("Wheel_FL")];
+        EXPECT_EQ(wheel.axle, glm::vec3(1, 0, 0));
+        EXPECT_NEAR(wheel.radius, 40.0f, 0.01f);
+        EXPECT_NEAR(wheel.pivot.y, 170.0f, 0.01f);
+
+        mesh.reset();
+        EXPECT_EQ(cache.meshCount(), 0u);
+        EXPECT_TRUE(cache.loadVehicleMesh("VehicleMeshTest.missing.obj") == nullptr);
+    }
+}
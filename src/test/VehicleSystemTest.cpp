@@ -0,0 +1,131 @@
+#include "LandscapeMock.h"
+#include "../VehicleSystem.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+    class VehicleSystemTest : public ::testing::Test
+    {
+    protected:
+        VehicleSystemTest()
+        {
+            // You can do set-up work for each test here.
+        }
+
+        virtual ~VehicleSystemTest()
+        {
+            // You can do clean-up work that doesn't throw exceptions here.
+        }
+
+        virtual void SetUp()
+        {
+            // Code here will be called immediately after the constructor (right
+            // before each test).
+        }
+
+        virtual void TearDown()
+        {
+            // Code here will be called immediately after each test (right
+            // before the destructor).
+        }
+    };
+
+    TEST(VehicleSystemTest, LandAndAlign)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::FLAT);
+
+        VehicleSystem vehicles;
+        const std::size_t falling = vehicles.add(glm::vec3(10.0f, 10.0f, 0.55f), 0.0f, 0.0f, 0.0f);
+        const std::size_t driving = vehicles.add(glm::vec3(20.0f, 20.0f, 0.0f), 90.0f, 0.5f, 0.0f);
+        EXPECT_EQ(vehicles.size(), 2u);
+
+        vehicles.step(landscape);
+        EXPECT_FALSE(vehicles.isOnGround(falling));
+        EXPECT_TRUE(vehicles.isOnGround(driving));
+        for (int i = 0; i < 5; ++i)
+        {
+            vehicles.step(landscape);
+        }
+        EXPECT_TRUE(vehicles.isOnGround(falling));
+        EXPECT_EQ(vehicles.position(falling).z, 0.0f);
+
+        // heading 90 degrees is along y
+        EXPECT_NEAR(vehicles.position(driving).x, 20.0f, 1e-4f);
+        EXPECT_NEAR(vehicles.position(driving).y, 23.0f, 1e-4f);
+        const glm::quat orientation = vehicles.orientation(driving);
+        const glm::vec3 forward = orientation * glm::vec3(1.0f, 0.0f, 0.0f);
+        EXPECT_NEAR(forward.y, 1.0f, 1e-5f);
+        EXPECT_NEAR((orientation * glm::vec3(0.0f, 0.0f, 1.0f)).z, 1.0f, 1e-5f);
+    }
+
+    TEST(VehicleSystemTest, AlignsWithSlope)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+
+        // a parked vehicle leans towards the surface normal until it matches
+        VehicleSystem vehicles;
+        vehicles.add(glm::vec3(123.4f, 234.5f, 0.0f), 30.0f, 0.0f, 0.0f);
+        for (int i = 0; i < 100; ++i)
+        {
+            vehicles.step(landscape);
+        }
+        float altitude;
+        glm::vec3 normal;
+        std::uint32_t triangle;
+        landscape.getLocalEnvironment(123.4f, 234.5f, altitude, normal, triangle);
+        EXPECT_TRUE(vehicles.isOnGround(0));
+        EXPECT_NEAR(vehicles.position(0).z, altitude, 1e-4f);
+        EXPECT_NEAR(glm::dot(vehicles.up(0), normal), 1.0f, 1e-5f);
+    }
+
+    TEST(VehicleSystemTest, SimdMatchesScalar)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::RANDOM);
+
+        // not a multiple of the SIMD width, so that the scalar tail runs too
+        VehicleSystem simd;
+        VehicleSystem scalar;
+        for (int i = 0; i < 37; ++i)
+        {
+            const glm::vec3 position(13.0f * i, 500.0f - 7.0f * i, 5.0f * (i % 4));
+            simd.add(position, i * 23.0f, 0.1f + 0.01f * i, i % 5 - 2.0f);
+            scalar.add(position, i * 23.0f, 0.1f + 0.01f * i, i % 5 - 2.0f);
+        }
+        for (int tick = 0; tick < 200; ++tick)
+        {
+            simd.step(landscape);
+            scalar.stepScalar(landscape);
+        }
+        for (std::size_t i = 0; i < simd.size(); ++i)
+        {
+            EXPECT_EQ(simd.position(i), scalar.position(i));
+            EXPECT_EQ(simd.heading(i), scalar.heading(i));
+            EXPECT_EQ(simd.up(i), scalar.up(i));
+            EXPECT_EQ(simd.isOnGround(i), scalar.isOnGround(i));
+        }
+    }
+
+    TEST(VehicleSystemTest, HeadingStaysUnit)
+    {
+        LandscapeMock landscape;
+        landscape.generate(Landscape::Type::FLAT);
+
+        // 9, so that the scalar tail turns too
+        VehicleSystem vehicles;
+        for (int i = 0; i < 9; ++i)
+        {
+            vehicles.add(glm::vec3(0.0f), 10.0f * i, 0.5f, 0.7f + 0.3f * i);
+        }
+        for (int tick = 0; tick < 100000; ++tick)
+        {
+            vehicles.step(landscape);
+        }
+        for (std::size_t i = 0; i < vehicles.size(); ++i)
+        {
+            EXPECT_NEAR(glm::length(vehicles.heading(i)), 1.0f, 1e-6f);
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Runs the simulation without a window or GL context, as fast as it goes,
+ * and reports its throughput: one tank and a number of AI vehicles.
+ *
+ * usage: src/Headless [ticks] [vehicles]   (run from the directory with images/)
+ */
+#include "../Simulation.h"
+#include "../Utils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    const unsigned long ticks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    const unsigned long vehicles = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    if (ticks == 0 || vehicles == 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [ticks] [vehicles]" << std::endl;
+        return 1;
+    }
+
+    Simulation simulation;
+    simulation.loadLandscape();
+
+    const std::size_t tank = simulation.addVehicle(glm::vec3(0.0f, 0.0f, 0.0f));
+    simulation.vehicle(tank).accelerate(0.05);
+
+    // a grid of vehicles, 10 units apart, driving circles of different sizes
+    const unsigned long columns = 32;
+    for (unsigned long i = 0; i < vehicles; ++i)
+    {
+        simulation.traffic().add(glm::vec3((i % columns) * 10.0f, (i / columns) * 10.0f, 0.0f),
+                        (i * 37) % 360, 0.05f + (i % 7) * 0.01f, 0.1f + (i % 11) * 0.1f);
+    }
+    std::cout << "kernel: " << VehicleSystem::kernelName() << std::endl;
+
+    const unsigned long start = Utils::clockTimeUs();
+    for (unsigned long i = 0; i < ticks; ++i)
+    {
+        simulation.step();
+    }
+    const unsigned long elapsedUs = std::max(Utils::clockTimeUs() - start, 1ul);
+
+    std::cout << ticks << " ticks of " << vehicles << " vehicles in " << elapsedUs / 1000.0 << "ms: "
+              << ticks * 1e6 / elapsedUs << " ticks/s, "
+              << elapsedUs * 1000.0 / (ticks * vehicles) << "ns per vehicle step" << std::endl;
+    const glm::vec3 position = simulation.traffic().position(0);
+    std::cout << "vehicle 0 at " << position.x << " " << position.y << " " << position.z << std::endl;
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Precomputes what Landscape::generate(Type::FILE) derives from the
+ * heightmap jpeg - heights, plane table and render tiles - into one file
+ * that MainWindow maps at startup instead.
+ *
+ * usage: src/TerrainBake [output]   (run from the directory with images/)
+ */
+#include "../Landscape.h"
+#include "../Utils.h"
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    const std::string output = argc > 1 ? argv[1] : Landscape::BakedHeightmap;
+
+    // what startup does without a baked file
+    unsigned long start = Utils::clockTimeUs();
+    Landscape landscape;
+    landscape.setUsePlaneTable(true);
+    landscape.generate(Landscape::Type::FILE);
+    const unsigned long generateUs = Utils::clockTimeUs() - start;
+
+    // the tile geometry is otherwise built while the first frames are drawn
+    start = Utils::clockTimeUs();
+    if (!landscape.bake(output))
+    {
+        return 1;
+    }
+    const unsigned long bakeUs = Utils::clockTimeUs() - start;
+
+    start = Utils::clockTimeUs();
+    Landscape baked;
+    if (!baked.loadBaked(output))
+    {
+        return 1;
+    }
+    const unsigned long loadUs = Utils::clockTimeUs() - start;
+
+    std::cout << "Baked " << landscape.get().size() << " triangles into " << output << std::endl;
+    std::cout << "generate: " << generateUs / 1000.0 << "ms, bake: " << bakeUs / 1000.0
+              << "ms, loadBaked: " << loadUs / 1000.0 << "ms" << std::endl;
+    return 0;
+}
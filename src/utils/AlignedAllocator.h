@@ -0,0 +1,98 @@
+#ifndef UTILS_ALIGNEDALLOCATOR_H_
+#define UTILS_ALIGNEDALLOCATOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+
+/* @brief Allocator for std::vector that places the first element on an
+ * Alignment byte boundary (e.g. a cache line or a SIMD register width).
+ */
+template<typename T, std::size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t)
+    {
+        free(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const
+    {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const
+    {
+        return false;
+    }
+};
+
+/* @brief Deleter for objects made by makeAligned.
+ */
+template<typename T>
+struct AlignedDelete
+{
+    void operator()(T* ptr) const
+    {
+        ptr->~T();
+        free(ptr);
+    }
+};
+
+template<typename T>
+using AlignedPtr = std::unique_ptr<T, AlignedDelete<T>>;
+
+/* @brief new for types with alignas members (e.g. padded to cache lines),
+ * which plain new does not align before C++17.
+ */
+template<typename T, typename... Args>
+AlignedPtr<T> makeAligned(Args&&... args)
+{
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, std::max(alignof(T), sizeof(void*)), sizeof(T)) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    try
+    {
+        return AlignedPtr<T>(new (ptr) T(std::forward<Args>(args)...));
+    }
+    catch (...)
+    {
+        free(ptr);
+        throw;
+    }
+}
+
+#endif /* UTILS_ALIGNEDALLOCATOR_H_ */
@@ -0,0 +1,32 @@
+#ifndef UTILS_CPUFEATURES_H_
+#define UTILS_CPUFEATURES_H_
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* AVX2_KERNEL marks functions with AVX2 intrinsics. They are built into
+ * every x86 build and picked at runtime with hasAvx2(), unless the whole
+ * build targets AVX2 anyway.
+ */
+#if defined(__AVX2__)
+#define AVX2_KERNEL
+#elif defined(__SSE2__) && defined(__GNUC__)
+#define AVX2_KERNEL __attribute__((target("avx2")))
+#endif
+
+/* @brief whether the CPU the binary runs on has AVX2
+ */
+inline bool hasAvx2()
+{
+#if defined(__AVX2__)
+    return true;
+#elif defined(AVX2_KERNEL)
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+#endif /* UTILS_CPUFEATURES_H_ */
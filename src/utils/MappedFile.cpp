@@ -0,0 +1,75 @@
+#include "MappedFile.h"
+
+#include <iostream>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        std::cerr << "Failed to get the size of " << filename << std::endl;
+        ::close(file);
+        return false;
+    }
+
+    void* data = mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map " << filename << std::endl;
+        return false;
+    }
+
+    mData = data;
+    mSize = status.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData != nullptr)
+    {
+        munmap(mData, mSize);
+        mData = nullptr;
+        mSize = 0;
+    }
+}
+
+bool MappedFile::isOpen() const
+{
+    return mData != nullptr;
+}
+
+void MappedFile::swap(MappedFile& other)
+{
+    std::swap(mData, other.mData);
+    std::swap(mSize, other.mSize);
+}
+
+char* MappedFile::data() const
+{
+    return (char*) mData;
+}
+
+std::size_t MappedFile::size() const
+{
+    return mSize;
+}
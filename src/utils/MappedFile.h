@@ -0,0 +1,31 @@
+#ifndef UTILS_MAPPEDFILE_H_
+#define UTILS_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+/* @brief A whole file mapped into memory. The pages are private: they can
+ * be written, but the changes never reach the file.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const;
+    void swap(MappedFile& other);
+
+    char* data() const;
+    std::size_t size() const;
+
+private:
+    void* mData = nullptr;
+    std::size_t mSize = 0;
+};
+
+#endif /* UTILS_MAPPEDFILE_H_ */
@@ -0,0 +1,39 @@
+#ifndef UTILS_PARALLEL_H_
+#define UTILS_PARALLEL_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/* @brief the number of threads to use for a request of threads, where 0
+ * means one per core.
+ */
+inline unsigned int threadsFor(unsigned int threads)
+{
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/* @brief call function(0) to function(count - 1), each on a thread of its
+ * own; the calling thread takes the last one. Returns when all are done.
+ */
+template<typename Function>
+void parallelFor(unsigned int count, Function function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for (unsigned int i = 0; i + 1 < count; ++i)
+    {
+        workers.push_back(std::thread(function, i));
+    }
+    function(count - 1);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+#endif /* UTILS_PARALLEL_H_ */
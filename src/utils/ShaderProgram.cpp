@@ -0,0 +1,59 @@
+#include "ShaderProgram.h"
+
+#include <iostream>
+
+namespace
+{
+    GLuint compileShader(GLenum type, const char* source, const char* name)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        GLint status = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE)
+        {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+            std::cerr << name << " shader does not compile: " << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+GLuint linkShaderProgram(const char* vertexSource, const char* fragmentSource, const char* name,
+                const std::vector<AttributeBinding>& attributes)
+{
+    const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, name);
+    const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+    if (vertexShader == 0 || fragmentShader == 0)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    for (const AttributeBinding& attribute : attributes)
+    {
+        glBindAttribLocation(program, attribute.location, attribute.name);
+    }
+    glLinkProgram(program);
+    // flagged for deletion, they go with the program
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cerr << name << " shader does not link: " << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,22 @@
+#ifndef UTILS_SHADERPROGRAM_H_
+#define UTILS_SHADERPROGRAM_H_
+
+#include <GL/glut.h>
+#include <vector>
+
+// a generic vertex attribute and the location it is bound to before linking
+struct AttributeBinding
+{
+    GLuint location;
+    const char* name;
+};
+
+/* @brief compile a vertex and a fragment shader and link them into a
+ * program with the given attribute locations. Returns 0 and reports the
+ * log, headed by name, if either does not compile or the program does not
+ * link.
+ */
+GLuint linkShaderProgram(const char* vertexSource, const char* fragmentSource, const char* name,
+                const std::vector<AttributeBinding>& attributes = std::vector<AttributeBinding>());
+
+#endif /* UTILS_SHADERPROGRAM_H_ */
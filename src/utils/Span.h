@@ -0,0 +1,86 @@
+#ifndef UTILS_SPAN_H_
+#define UTILS_SPAN_H_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/* @brief Non-owning view of a contiguous sequence of T, the subset of
+ * std::span that is needed to pass arrays into batch interfaces.
+ */
+template<typename T>
+class Span
+{
+public:
+    Span() = default;
+
+    Span(T* data, std::size_t size) :
+                    mData(data), mSize(size)
+    {
+    }
+
+    template<typename U, typename Allocator>
+    Span(std::vector<U, Allocator>& vector) :
+                    mData(vector.data()), mSize(vector.size())
+    {
+    }
+
+    template<typename U, typename Allocator>
+    Span(const std::vector<U, Allocator>& vector) :
+                    mData(vector.data()), mSize(vector.size())
+    {
+    }
+
+    template<typename U, std::size_t N>
+    Span(std::array<U, N>& array) :
+                    mData(array.data()), mSize(N)
+    {
+    }
+
+    template<typename U>
+    Span(const Span<U>& other) :
+                    mData(other.data()), mSize(other.size())
+    {
+    }
+
+    T* data() const
+    {
+        return mData;
+    }
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    T& operator[](std::size_t index) const
+    {
+        return mData[index];
+    }
+
+    T* begin() const
+    {
+        return mData;
+    }
+
+    T* end() const
+    {
+        return mData + mSize;
+    }
+
+    Span subspan(std::size_t offset, std::size_t count) const
+    {
+        return Span(mData + offset, count);
+    }
+
+private:
+    T* mData = nullptr;
+    std::size_t mSize = 0;
+};
+
+#endif /* UTILS_SPAN_H_ */
@@ -0,0 +1,63 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ @brief A bounded, lock-free queue for exactly one producer thread and one
+        consumer thread. push and pop never block; they fail when the queue
+        is full or empty.
+ */
+template<typename T, std::size_t Capacity>
+class SpscQueue
+{
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // producer only
+    bool push(const T& value)
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        const std::size_t next = (tail + 1) % Slots;
+        if (next == mHead.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        mSlots[tail] = value;
+        mTail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool pop(T& value)
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = mSlots[head];
+        mHead.store((head + 1) % Slots, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+private:
+    // one slot stays free to tell a full queue from an empty one
+    static const std::size_t Slots = Capacity + 1;
+
+    std::array<T, Slots> mSlots;
+    // on separate cache lines, each is written by one thread only
+    alignas(64) std::atomic<std::size_t> mHead { 0 };
+    alignas(64) std::atomic<std::size_t> mTail { 0 };
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+
+/**
+ @brief Hands the latest of a series of values from one producer thread to
+        one consumer thread without locks or copies. The producer fills
+        back() and publishes it; the consumer takes the most recent published
+        value with update() and reads it in front() for as long as it likes.
+        Values published in between are skipped. Neither side ever waits for
+        the other. The slots are reused, so the producer has to overwrite all
+        of back() before publishing it.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // producer only
+    T& back()
+    {
+        return mSlots[mBack];
+    }
+
+    // producer only: make back() the latest value and take another slot
+    void publish()
+    {
+        const unsigned int previous = mMiddle.exchange(mBack | Fresh, std::memory_order_acq_rel);
+        mBack = previous & Index;
+    }
+
+    /* @brief consumer only: move the latest published value to front().
+     * Returns false if nothing was published since the last call.
+     */
+    bool update()
+    {
+        if (!(mMiddle.load(std::memory_order_relaxed) & Fresh))
+        {
+            return false;
+        }
+        const unsigned int previous = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+        mFront = previous & Index;
+        return true;
+    }
+
+    // consumer only
+    const T& front() const
+    {
+        return mSlots[mFront];
+    }
+
+private:
+    // the middle slot: its index and whether it is newer than front()
+    static const unsigned int Index = 3;
+    static const unsigned int Fresh = 4;
+
+    std::array<T, 3> mSlots;
+    unsigned int mBack = 0;
+    // on separate cache lines, mBack and mFront are each used by one thread only
+    alignas(64) std::atomic<unsigned int> mMiddle { 1 };
+    alignas(64) unsigned int mFront = 2;
+};
+
+#endif
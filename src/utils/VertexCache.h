@@ -0,0 +1,34 @@
+#ifndef VERTEXCACHE_H
+#define VERTEXCACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/* @brief the number of vertices that drawing the triangles transforms with a
+ * FIFO post-transform cache of cacheSize entries. Divided by the number of
+ * triangles this is the average cache miss ratio (ACMR): 3 without reuse,
+ * about 0.5 at best for a regular grid.
+ */
+template<typename Index>
+std::size_t vertexCacheMisses(const Index* indices, std::size_t count, unsigned int cacheSize)
+{
+    std::vector<Index> cache(cacheSize);
+    std::size_t used = 0;
+    std::size_t next = 0; // the oldest entry once the cache is full
+    std::size_t misses = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (std::find(cache.begin(), cache.begin() + used, indices[i]) != cache.begin() + used)
+        {
+            continue;
+        }
+        misses++;
+        cache[next] = indices[i];
+        next = (next + 1) % cacheSize;
+        used = std::min<std::size_t>(used + 1, cacheSize);
+    }
+    return misses;
+}
+
+#endif